@@ -0,0 +1,241 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Compares point lookups expressed as coroutines whose reads run on an
+ * AsyncIoPool (util/async.h) with the same lookups run one thread per
+ * request.
+ *
+ * A lookup reads an "index" block at a random offset and then the data
+ * block it points to, so its second read depends on the first.
+ *
+ * Before each mode the file is dropped from the page cache, so reads go
+ * to the device unless --cold=0. That only works where the file system
+ * honours POSIX_FADV_DONTNEED: pass a --db on a real disk, not tmpfs.
+ *
+ *     ./async_bench --lookups=100000 --concurrency=1000 --io_threads=64 \
+ *         --file_size=1024 --db=/var/tmp
+ */
+
+#include "leveldb/env.h"
+#include "util/async.h"
+#include "util/random.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Number of lookups to perform in each mode.
+int FLAGS_lookups = 100000;
+
+// Number of lookups in flight at once.
+int FLAGS_concurrency = 1000;
+
+// Number of threads performing the coroutines' reads.
+int FLAGS_io_threads = 64;
+
+// Size of the file read by the lookups, in MB.
+int FLAGS_file_size = 64;
+
+// Drop the file from the page cache before each mode.
+bool FLAGS_cold = true;
+
+// Size of every read.
+const size_t kBlockSize = 4096;
+
+// Directory holding the benchmark file.
+const char *FLAGS_db = nullptr;
+
+} // namespace
+
+namespace leveldb {
+
+// Offset of the data block that the index block at "offset" points to.
+static uint64_t DataBlockOffset(const Slice& index_block, uint64_t num_blocks) {
+    uint64_t v;
+    memcpy(&v, index_block.data(), sizeof(v));
+    return (v % num_blocks) * kBlockSize;
+}
+
+static Task<Status> LookupAsync(AsyncIoPool *pool, RandomAccessFile *file, uint64_t num_blocks, Random *rnd) {
+    char scratch[kBlockSize];
+    Slice block;
+    Status s = co_await ReadAsync(pool, file, rnd->Uniform(num_blocks) * kBlockSize,
+                                  kBlockSize, &block, scratch);
+    if (s.ok()) {
+        s = co_await ReadAsync(pool, file, DataBlockOffset(block, num_blocks),
+                               kBlockSize, &block, scratch);
+    }
+    co_return s;
+}
+
+static Task<Status> Worker(AsyncIoPool *pool, RandomAccessFile *file, uint64_t num_blocks,
+                           int lookups, uint32_t seed) {
+    Random rnd(seed);
+    for (int i = 0; i < lookups; i++) {
+        Status s = co_await LookupAsync(pool, file, num_blocks, &rnd);
+        if (!s.ok()) {
+            co_return s;
+        }
+    }
+    co_return Status::OK();
+}
+
+static Status LookupSync(RandomAccessFile *file, uint64_t num_blocks, Random *rnd) {
+    char scratch[kBlockSize];
+    Slice block;
+    Status s = file->Read(rnd->Uniform(num_blocks) * kBlockSize, kBlockSize, &block, scratch);
+    if (s.ok()) {
+        s = file->Read(DataBlockOffset(block, num_blocks), kBlockSize, &block, scratch);
+    }
+    return s;
+}
+
+static void Report(const char *name, uint64_t micros, int lookups) {
+    fprintf(stdout, "%-20s : %10.3f micros/op; %10.0f ops/sec\n",
+            name, static_cast<double>(micros) / lookups, lookups * 1e6 / micros);
+}
+
+static void RunCoroutines(Env *env, RandomAccessFile *file, uint64_t num_blocks) {
+    auto run = [](vector<Task<Status>> *workers) -> Task<void> {
+        co_await WhenAll(workers);
+    };
+
+    AsyncIoPool pool(FLAGS_io_threads);
+    const int per_worker = FLAGS_lookups / FLAGS_concurrency;
+    vector<Task<Status>> workers;
+    for (int w = 0; w < FLAGS_concurrency; w++) {
+        workers.push_back(Worker(&pool, file, num_blocks, per_worker, 301 + w));
+    }
+
+    const uint64_t start = env->NowMicros();
+    SyncWait(run(&workers));
+    const uint64_t micros = env->NowMicros() - start;
+
+    for (Task<Status>& worker : workers) {
+        if (!worker.Result().ok()) {
+            fprintf(stderr, "lookup failed: %s\n", worker.Result().ToString().c_str());
+            exit(1);
+        }
+    }
+    Report("coroutines", micros, per_worker * FLAGS_concurrency);
+}
+
+static void RunThreadPerRequest(Env *env, RandomAccessFile *file, uint64_t num_blocks) {
+    const int batches = FLAGS_lookups / FLAGS_concurrency;
+    vector<Status> statuses(FLAGS_concurrency);
+
+    const uint64_t start = env->NowMicros();
+    for (int b = 0; b < batches; b++) {
+        vector<thread> threads;
+        threads.reserve(FLAGS_concurrency);
+        for (int r = 0; r < FLAGS_concurrency; r++) {
+            threads.emplace_back([file, num_blocks, b, r, &statuses]() {
+                Random rnd(301 + b * FLAGS_concurrency + r);
+                statuses[r] = LookupSync(file, num_blocks, &rnd);
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        for (const Status& s : statuses) {
+            if (!s.ok()) {
+                fprintf(stderr, "lookup failed: %s\n", s.ToString().c_str());
+                exit(1);
+            }
+        }
+    }
+    const uint64_t micros = env->NowMicros() - start;
+    Report("thread-per-request", micros, batches * FLAGS_concurrency);
+}
+
+static void Run() {
+    Env *env = Env::Default();
+    string fname = string(FLAGS_db != nullptr ? FLAGS_db : "/tmp") + "/async_bench.dat";
+
+    const uint64_t num_blocks = static_cast<uint64_t>(FLAGS_file_size) * 1048576 / kBlockSize;
+    WritableFile *writable_file;
+    Status s = env->NewWritableFile(fname, &writable_file);
+    if (s.ok()) {
+        Random rnd(301);
+        string block(kBlockSize, '\0');
+        for (uint64_t b = 0; b < num_blocks && s.ok(); b++) {
+            for (size_t i = 0; i < kBlockSize; i += 4) {
+                const uint32_t v = rnd.Uniform(1 << 30);
+                memcpy(&block[i], &v, sizeof(v));
+            }
+            s = writable_file->Append(block);
+        }
+        // Only clean pages can be dropped from the cache.
+        if (s.ok()) {
+            s = writable_file->Sync();
+        }
+        if (s.ok()) {
+            s = writable_file->Close();
+        }
+        delete writable_file;
+    }
+
+    RandomAccessFile *file = nullptr;
+    if (s.ok()) {
+        s = env->NewRandomAccessFile(fname, &file);
+    }
+    if (!s.ok()) {
+        fprintf(stderr, "%s\n", s.ToString().c_str());
+        exit(1);
+    }
+
+    fprintf(stdout, "Lookups:     %d\n", FLAGS_lookups);
+    fprintf(stdout, "Concurrency: %d\n", FLAGS_concurrency);
+    fprintf(stdout, "IO threads:  %d\n", FLAGS_io_threads);
+    fprintf(stdout, "File size:   %d MB\n", FLAGS_file_size);
+    fprintf(stdout, "Page cache:  %s\n", FLAGS_cold ? "cold" : "warm");
+    fprintf(stdout, "------------------------------------------------\n");
+
+    if (FLAGS_cold) {
+        file->Hint(AccessPattern::kDontNeed);
+    }
+    RunCoroutines(env, file, num_blocks);
+    if (FLAGS_cold) {
+        file->Hint(AccessPattern::kDontNeed);
+    }
+    RunThreadPerRequest(env, file, num_blocks);
+
+    delete file;
+    env->RemoveFile(fname);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--lookups=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_lookups = n;
+        } else if (sscanf(argv[i], "--concurrency=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_concurrency = n;
+        } else if (sscanf(argv[i], "--io_threads=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_io_threads = n;
+        } else if (sscanf(argv[i], "--file_size=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_file_size = n;
+        } else if (sscanf(argv[i], "--cold=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+            FLAGS_cold = n;
+        } else if (strncmp(argv[i], "--db=", 5) == 0) {
+            FLAGS_db = argv[i] + 5;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    leveldb::Run();
+    return 0;
+}
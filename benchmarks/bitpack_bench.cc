@@ -0,0 +1,151 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Compares the size and decoding speed of integer columns stored as
+ * fixed32s, as varints, and as util/bitpack.h blocks.
+ *
+ *     ./bitpack_bench --values=10000000
+ */
+
+#include "util/bitpack.h"
+
+#include "util/coding.h"
+#include "util/random.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Values per column.
+int FLAGS_values = 10000000;
+
+} // namespace
+
+namespace leveldb {
+
+using bitpack::kBlockSize;
+
+static vector<uint32_t> Column(const char *shape) {
+    Random rnd(301);
+    vector<uint32_t> values(FLAGS_values);
+    uint32_t v = 1;
+    for (uint32_t& value : values) {
+        if (shape[0] == 's') {
+            // Sequence numbers: increasing in small steps.
+            v += 1 + rnd.Uniform(8);
+        } else if (shape[0] == 'o') {
+            // Block offsets: increasing by about a block.
+            v += 4000 + rnd.Uniform(200);
+        } else {
+            // Value lengths: clustered, both ways.
+            v = 100 + rnd.Uniform(50);
+        }
+        value = v;
+    }
+    return values;
+}
+
+template <typename Encode, typename Decode>
+static void Run(const char *shape, const char *name, const vector<uint32_t>& values,
+                Encode encode, Decode decode) {
+    string buf;
+    for (size_t i = 0; i + kBlockSize <= values.size(); i += kBlockSize) {
+        encode(&buf, &values[i]);
+    }
+    const size_t blocks = values.size() / kBlockSize;
+
+    uint32_t decoded[kBlockSize];
+    uint64_t sink = 0;
+    const auto start = chrono::steady_clock::now();
+    const char *p = buf.data();
+    const char *limit = p + buf.size();
+    for (size_t b = 0; b < blocks; b++) {
+        p = decode(p, limit, decoded);
+        sink += decoded[b % kBlockSize];
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%-10s %-14s : %6.2f bytes/value %7.2f ns/value (%02x)\n", shape, name,
+            static_cast<double>(buf.size()) / (blocks * kBlockSize),
+            seconds * 1e9 / (blocks * kBlockSize), static_cast<unsigned>(sink & 0xff));
+}
+
+static void RunColumn(const char *shape) {
+    const vector<uint32_t> values = Column(shape);
+    Run(shape, "fixed32", values,
+        [](string *dst, const uint32_t *v) {
+            for (size_t i = 0; i < kBlockSize; i++) {
+                PutFixed32(dst, v[i]);
+            }
+        },
+        [](const char *p, const char *, uint32_t *out) {
+            for (size_t i = 0; i < kBlockSize; i++) {
+                out[i] = DecodeFixed32(p + 4 * i);
+            }
+            return p + 4 * kBlockSize;
+        });
+    Run(shape, "varint", values,
+        [](string *dst, const uint32_t *v) {
+            for (size_t i = 0; i < kBlockSize; i++) {
+                PutVarint32(dst, v[i]);
+            }
+        },
+        [](const char *p, const char *limit, uint32_t *out) {
+            return GetVarint32Array(p, limit, out, kBlockSize);
+        });
+    Run(shape, "varint delta", values,
+        [](string *dst, const uint32_t *v) {
+            PutVarint32(dst, v[0]);
+            for (size_t i = 1; i < kBlockSize; i++) {
+                PutVarint32(dst, v[i] - v[i - 1]);
+            }
+        },
+        [](const char *p, const char *limit, uint32_t *out) {
+            p = GetVarint32Array(p, limit, out, kBlockSize);
+            for (size_t i = 1; i < kBlockSize; i++) {
+                out[i] += out[i - 1];
+            }
+            return p;
+        });
+    Run(shape, "bitpack", values,
+        [](string *dst, const uint32_t *v) { bitpack::PutBlock(dst, v, kBlockSize); },
+        [](const char *p, const char *limit, uint32_t *out) {
+            return bitpack::GetBlock(p, limit, out, kBlockSize);
+        });
+    Run(shape, "bitpack delta", values,
+        [](string *dst, const uint32_t *v) { bitpack::PutDeltaBlock(dst, v, kBlockSize); },
+        [](const char *p, const char *limit, uint32_t *out) {
+            return bitpack::GetDeltaBlock(p, limit, out, kBlockSize);
+        });
+    Run(shape, "bitpack zigzag", values,
+        [](string *dst, const uint32_t *v) { bitpack::PutZigZagDeltaBlock(dst, v, kBlockSize); },
+        [](const char *p, const char *limit, uint32_t *out) {
+            return bitpack::GetZigZagDeltaBlock(p, limit, out, kBlockSize);
+        });
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--values=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_values = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    for (const char *shape : {"sequence", "offsets", "lengths"}) {
+        leveldb::RunColumn(shape);
+    }
+    return 0;
+}
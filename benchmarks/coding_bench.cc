@@ -0,0 +1,166 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Measures encoding and decoding throughput of util/coding.h for value
+ * distributions seen in practice: lengths of small keys and values (one
+ * byte varints), a mix of one to three byte varints, and full-width
+ * values. Bulk varint32 decoding is compared with one varint at a time.
+ *
+ *     ./coding_bench --values=10000000
+ */
+
+#include "util/coding.h"
+
+#include "util/random.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Values encoded and decoded per distribution and encoding.
+int FLAGS_values = 10000000;
+
+} // namespace
+
+namespace leveldb {
+
+static vector<uint64_t> Values(const char *distribution) {
+    Random rnd(301);
+    vector<uint64_t> values(FLAGS_values);
+    for (uint64_t& v : values) {
+        const uint64_t r = (uint64_t{rnd.Uniform(1 << 30)} << 34) ^
+                           (uint64_t{rnd.Uniform(1 << 30)} << 4) ^ rnd.Uniform(16);
+        if (distribution[0] == 's') {
+            v = r % 128;
+        } else if (distribution[0] == 'm') {
+            // 70% one byte, 25% two bytes, 5% three bytes.
+            const uint32_t pick = rnd.Uniform(100);
+            v = pick < 70 ? r % 128 : (pick < 95 ? r % 16384 : r % (1 << 21));
+        } else {
+            v = r & 0xffffffff;
+        }
+    }
+    return values;
+}
+
+static void Report(const char *distribution, const char *name, double seconds,
+                   size_t bytes, uint64_t sink) {
+    fprintf(stdout, "%-6s %-16s : %7.2f ns/value %8.1f MB/s (%02x)\n", distribution, name,
+            seconds * 1e9 / FLAGS_values, bytes / seconds / 1e6,
+            static_cast<unsigned>(sink & 0xff));
+}
+
+template <typename Encode, typename Decode>
+static void Run(const char *distribution, const char *name, const vector<uint64_t>& values,
+                Encode encode, Decode decode) {
+    string buf;
+    buf.reserve(values.size() * 10);
+    auto start = chrono::steady_clock::now();
+    for (uint64_t v : values) {
+        encode(&buf, v);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    Report(distribution, (string(name) + " encode").c_str(), seconds, buf.size(), buf.size());
+
+    uint64_t sink = 0;
+    start = chrono::steady_clock::now();
+    const char *p = buf.data();
+    const char *limit = p + buf.size();
+    while (p < limit) {
+        p = decode(p, limit, &sink);
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    Report(distribution, (string(name) + " decode").c_str(), seconds, buf.size(), sink);
+}
+
+// Decodes varint32s in runs of 128, as a block of lengths or deltas is.
+static void RunBulk(const char *distribution, const vector<uint64_t>& values) {
+    const size_t kRun = 128;
+    string buf;
+    for (uint64_t v : values) {
+        PutVarint32(&buf, static_cast<uint32_t>(v));
+    }
+    const size_t runs = values.size() / kRun;
+    uint32_t decoded[kRun];
+
+    for (bool bulk : {false, true}) {
+        uint64_t sink = 0;
+        const auto start = chrono::steady_clock::now();
+        const char *p = buf.data();
+        const char *limit = p + buf.size();
+        for (size_t r = 0; r < runs; r++) {
+            if (bulk) {
+                p = GetVarint32Array(p, limit, decoded, kRun);
+            } else {
+                for (size_t i = 0; i < kRun; i++) {
+                    p = GetVarint32Ptr(p, limit, &decoded[i]);
+                }
+            }
+            sink += decoded[r % kRun];
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        fprintf(stdout, "%-6s %-16s : %7.2f ns/value %8.1f Mvalues/s (%02x)\n", distribution,
+                bulk ? "varint32 array" : "varint32 loop", seconds * 1e9 / (runs * kRun),
+                runs * kRun / seconds / 1e6, static_cast<unsigned>(sink & 0xff));
+    }
+}
+
+static void RunDistribution(const char *distribution) {
+    const vector<uint64_t> values = Values(distribution);
+    Run(distribution, "fixed32", values,
+        [](string *dst, uint64_t v) { PutFixed32(dst, static_cast<uint32_t>(v)); },
+        [](const char *p, const char *, uint64_t *sink) {
+            *sink += DecodeFixed32(p);
+            return p + 4;
+        });
+    Run(distribution, "fixed64", values,
+        [](string *dst, uint64_t v) { PutFixed64(dst, v); },
+        [](const char *p, const char *, uint64_t *sink) {
+            *sink += DecodeFixed64(p);
+            return p + 8;
+        });
+    Run(distribution, "varint32", values,
+        [](string *dst, uint64_t v) { PutVarint32(dst, static_cast<uint32_t>(v)); },
+        [](const char *p, const char *limit, uint64_t *sink) {
+            uint32_t v;
+            p = GetVarint32Ptr(p, limit, &v);
+            *sink += v;
+            return p;
+        });
+    Run(distribution, "varint64", values,
+        [](string *dst, uint64_t v) { PutVarint64(dst, v); },
+        [](const char *p, const char *limit, uint64_t *sink) {
+            uint64_t v;
+            p = GetVarint64Ptr(p, limit, &v);
+            *sink += v;
+            return p;
+        });
+    RunBulk(distribution, values);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--values=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_values = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    for (const char *distribution : {"small", "mixed", "large"}) {
+        leveldb::RunDistribution(distribution);
+    }
+    return 0;
+}
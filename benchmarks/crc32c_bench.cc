@@ -0,0 +1,71 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Measures crc32c throughput of the accelerated and the portable
+ * implementation over block sizes typical for records and table blocks.
+ *
+ *     ./crc32c_bench --bytes=1073741824
+ */
+
+#include "util/crc32c.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+using namespace std;
+
+namespace {
+
+// Bytes checksummed per block size and implementation.
+long long FLAGS_bytes = 1LL << 30;
+
+} // namespace
+
+namespace leveldb {
+
+static void Run(const char *name, uint32_t (*extend)(uint32_t, const char *, size_t),
+                const string& data, size_t block_size) {
+    const long long iterations = FLAGS_bytes / block_size;
+    uint32_t crc = 0;
+    const auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; i++) {
+        // Slide through the buffer so that not every block is cache-hot.
+        const size_t offset = (i * block_size) % (data.size() - block_size + 1);
+        crc = extend(crc, data.data() + offset, block_size);
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%-10s %8zu bytes : %8.2f GB/s (crc %08x)\n",
+            name, block_size, iterations * block_size / seconds / 1e9, crc);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        long long n;
+        char junk;
+        if (sscanf(argv[i], "--bytes=%lld%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_bytes = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    string data(4 << 20, '\0');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 7 + (i >> 8));
+    }
+
+    fprintf(stdout, "Hardware accelerated: %s\n",
+            leveldb::crc32c::IsHardwareAccelerated() ? "yes" : "no");
+    fprintf(stdout, "------------------------------------------------\n");
+    for (size_t block_size : {64, 256, 4096, 32768, 1 << 20}) {
+        leveldb::Run("Extend", &leveldb::crc32c::Extend, data, block_size);
+        leveldb::Run("portable", &leveldb::crc32c::ExtendPortable, data, block_size);
+    }
+    return 0;
+}
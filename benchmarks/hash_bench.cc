@@ -0,0 +1,292 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Speed and quality of the hash functions in util/hash.h, for choosing
+ * one for a filter or for sharding.
+ *
+ *     ./hash_bench --benchmarks=speed,batch,avalanche,buckets --bytes=268435456
+ *
+ *   speed      Hash() and Hash64() over inputs of 1 to 4096 bytes, in
+ *              nanoseconds per key and bytes per cycle (TSC cycles on x86).
+ *   batch      one key at a time against HashBatch() and Hash64Batch().
+ *   avalanche  how far from 1/2 the chance that flipping one input bit
+ *              flips a given output bit is, worst and on average.
+ *   buckets    how evenly typical key sets spread over a table, as the
+ *              z-score of a chi-square test and the fullest bucket
+ *              relative to the mean; |z| < 3 is as even as random.
+ */
+
+#include "util/hash.h"
+
+#include "util/coding.h"
+#include "util/random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+using namespace std;
+
+namespace {
+
+// Comma-separated list of the benchmarks to run.
+const char *FLAGS_benchmarks = "speed,batch,avalanche,buckets";
+
+// Bytes hashed per input size and hash function.
+long long FLAGS_bytes = 1LL << 28;
+
+// Upper bound on the keys hashed per input size, so tiny inputs finish.
+const long long kMaxKeys = 20 * 1000 * 1000;
+
+} // namespace
+
+namespace leveldb {
+
+// Both hash functions with a common signature.
+struct HashFunction {
+    const char *name;
+    int bits;
+    uint64_t (*hash)(const char *data, size_t n, uint64_t seed);
+};
+
+static const HashFunction kHashFunctions[] = {
+    {"Hash", 32, [](const char *data, size_t n, uint64_t seed) -> uint64_t {
+        return Hash(data, n, static_cast<uint32_t>(seed));
+    }},
+    {"Hash64", 64, [](const char *data, size_t n, uint64_t seed) -> uint64_t {
+        return Hash64(data, n, seed);
+    }},
+};
+
+static uint64_t Cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void Speed(const HashFunction& f, const string& data, size_t key_len) {
+    const size_t span = data.size() - key_len + 1;
+    const long long iterations = min(kMaxKeys, max(1LL, FLAGS_bytes / static_cast<long long>(key_len)));
+    uint64_t sink = 0;
+    const auto start = chrono::steady_clock::now();
+    const uint64_t start_cycles = Cycles();
+    for (long long i = 0; i < iterations; i++) {
+        // Vary the key so the work can not be hoisted out of the loop.
+        sink += f.hash(data.data() + (i * 64) % span, key_len, sink);
+    }
+    const uint64_t cycles = Cycles() - start_cycles;
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    char bytes_per_cycle[20] = "-";
+    if (cycles != 0) {
+        snprintf(bytes_per_cycle, sizeof(bytes_per_cycle), "%.3f",
+                 static_cast<double>(iterations) * key_len / cycles);
+    }
+    fprintf(stdout, "%-8s %6zu bytes : %8.2f ns/key %8.2f GB/s %8s bytes/cycle (%02x)\n",
+            f.name, key_len, seconds * 1e9 / iterations, iterations * key_len / seconds / 1e9,
+            bytes_per_cycle, static_cast<unsigned>(sink & 0xff));
+}
+
+// Hashes FLAGS_bytes worth of keys of "key_len" bytes, as a filter builder
+// over a sorted run of keys would.
+template <typename Batch>
+static void RunBatch(const char *name, Batch batch, const string& data, size_t key_len) {
+    const size_t kKeys = 1024;
+    vector<Slice> keys;
+    for (size_t i = 0; i < kKeys; i++) {
+        keys.emplace_back(data.data() + (i * 4099) % (data.size() - key_len), key_len);
+    }
+    const long long rounds = max(1LL, FLAGS_bytes / static_cast<long long>(kKeys * key_len));
+    uint64_t sink = 0;
+    const auto start = chrono::steady_clock::now();
+    for (long long r = 0; r < rounds; r++) {
+        sink += batch(keys.data(), kKeys, static_cast<uint32_t>(r));
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%-12s %6zu bytes : %8.2f ns/key (%02x)\n", name, key_len,
+            seconds * 1e9 / (rounds * kKeys), static_cast<unsigned>(sink & 0xff));
+}
+
+static void Batch(const string& data) {
+    for (size_t key_len : {8, 16, 32, 64, 128, 256}) {
+        RunBatch("Hash", [](const Slice *keys, size_t n, uint32_t seed) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n; i++) {
+                sum += Hash(keys[i].data(), keys[i].size(), seed);
+            }
+            return sum;
+        }, data, key_len);
+        RunBatch("HashBatch", [](const Slice *keys, size_t n, uint32_t seed) {
+            static uint32_t out[1024];
+            HashBatch(keys, n, seed, out);
+            return static_cast<uint64_t>(out[0] + out[n - 1]);
+        }, data, key_len);
+        RunBatch("Hash64", [](const Slice *keys, size_t n, uint32_t seed) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n; i++) {
+                sum += Hash64(keys[i].data(), keys[i].size(), seed);
+            }
+            return sum;
+        }, data, key_len);
+        RunBatch("Hash64Batch", [](const Slice *keys, size_t n, uint32_t seed) {
+            static uint64_t out[1024];
+            Hash64Batch(keys, n, seed, out);
+            return out[0] + out[n - 1];
+        }, data, key_len);
+    }
+}
+
+// Flips every input bit of "samples" random keys of "key_len" bytes.
+static void Avalanche(const HashFunction& f, size_t key_len) {
+    const int kSamples = 1000;
+    const size_t input_bits = 8 * key_len;
+    vector<int> flips(input_bits * f.bits, 0);
+    Random rnd(301);
+    string key(key_len, '\0');
+    for (int s = 0; s < kSamples; s++) {
+        for (char& c : key) {
+            c = static_cast<char>(rnd.Uniform(256));
+        }
+        const uint64_t h = f.hash(key.data(), key_len, 0);
+        for (size_t i = 0; i < input_bits; i++) {
+            key[i / 8] ^= static_cast<char>(1 << (i % 8));
+            const uint64_t diff = h ^ f.hash(key.data(), key_len, 0);
+            key[i / 8] ^= static_cast<char>(1 << (i % 8));
+            for (int j = 0; j < f.bits; j++) {
+                flips[i * f.bits + j] += (diff >> j) & 1;
+            }
+        }
+    }
+
+    double worst = 0;
+    double total = 0;
+    for (int count : flips) {
+        const double bias = fabs(static_cast<double>(count) / kSamples - 0.5);
+        worst = max(worst, bias);
+        total += bias;
+    }
+    fprintf(stdout, "%-8s %6zu bytes : worst bias %.3f mean bias %.4f (random: mean %.4f)\n",
+            f.name, key_len, worst, total / flips.size(), 0.5 * sqrt(2.0 / M_PI / kSamples));
+}
+
+/*
+ * Places "keys" into "buckets" buckets by the low and by the high bits of
+ * the hash, and reports both spreads.
+ */
+static void Buckets(const HashFunction& f, const char *key_set, const vector<string>& keys,
+                    int bucket_bits) {
+    const size_t buckets = size_t{1} << bucket_bits;
+    for (bool high_bits : {false, true}) {
+        vector<int> counts(buckets, 0);
+        for (const string& key : keys) {
+            const uint64_t h = f.hash(key.data(), key.size(), 0);
+            counts[high_bits ? h >> (f.bits - bucket_bits) : h & (buckets - 1)]++;
+        }
+        const double expected = static_cast<double>(keys.size()) / buckets;
+        double chi_square = 0;
+        for (int c : counts) {
+            chi_square += (c - expected) * (c - expected) / expected;
+        }
+        const double z = (chi_square - (buckets - 1)) / sqrt(2.0 * (buckets - 1));
+        fprintf(stdout, "%-8s %-12s %s bits : z %7.2f fullest %.2fx\n", f.name, key_set,
+                high_bits ? "high" : "low ", z,
+                *max_element(counts.begin(), counts.end()) / expected);
+    }
+}
+
+static void BucketKeySets() {
+    const int kKeys = 1 << 20;
+    const int kBucketBits = 12;
+    vector<string> fixed(kKeys);
+    vector<string> decimal(kKeys);
+    vector<string> random(kKeys);
+    Random rnd(301);
+    char buf[32];
+    for (int i = 0; i < kKeys; i++) {
+        fixed[i].assign(reinterpret_cast<const char *>(&i), sizeof(i));
+        snprintf(buf, sizeof(buf), "key%012d", i);
+        decimal[i] = buf;
+        random[i].resize(16);
+        for (char& c : random[i]) {
+            c = static_cast<char>(rnd.Uniform(256));
+        }
+    }
+    for (const HashFunction& f : kHashFunctions) {
+        Buckets(f, "sequential", fixed, kBucketBits);
+        Buckets(f, "decimal", decimal, kBucketBits);
+        Buckets(f, "random", random, kBucketBits);
+    }
+}
+
+static void Run(const string& name) {
+    string data(1 << 20, '\0');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 7 + (i >> 8));
+    }
+
+    fprintf(stdout, "------------------------------------------------ %s\n", name.c_str());
+    if (name == "speed") {
+        for (size_t key_len : {1, 2, 3, 4, 7, 8, 12, 16, 24, 32, 48, 64, 100, 128, 256,
+                               257, 512, 1024, 2048, 4096}) {
+            for (const HashFunction& f : kHashFunctions) {
+                Speed(f, data, key_len);
+            }
+        }
+    } else if (name == "batch") {
+        Batch(data);
+    } else if (name == "avalanche") {
+        for (size_t key_len : {4, 8, 16, 32, 100, 300}) {
+            for (const HashFunction& f : kHashFunctions) {
+                Avalanche(f, key_len);
+            }
+        }
+    } else if (name == "buckets") {
+        BucketKeySets();
+    } else {
+        fprintf(stderr, "Unknown benchmark '%s'\n", name.c_str());
+        exit(1);
+    }
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        long long n;
+        char junk;
+        if (strncmp(argv[i], "--benchmarks=", 13) == 0) {
+            FLAGS_benchmarks = argv[i] + 13;
+        } else if (sscanf(argv[i], "--bytes=%lld%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_bytes = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    string benchmarks = FLAGS_benchmarks;
+    size_t start = 0;
+    while (start <= benchmarks.size()) {
+        size_t end = benchmarks.find(',', start);
+        if (end == string::npos) {
+            end = benchmarks.size();
+        }
+        if (end > start) {
+            leveldb::Run(benchmarks.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Measures the overhead of an instrumented Env (util/instrumented_env.h)
+ * over the Env it wraps: small appends and reads, on the in-memory Env
+ * and on files of the default Env, and Schedule() round-trips through
+ * the background thread. Each is run with every read and append timed,
+ * and with one in --sample_one_in timed.
+ *
+ *     ./instrumented_env_bench --ops=1000000 --value_size=100 --sample_one_in=64
+ */
+
+#include "helpers/memenv/memenv.h"
+#include "leveldb/env.h"
+#include "util/instrumented_env.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+using namespace std;
+
+namespace {
+
+// File operations per run; Schedule() round-trips are a 50th of it.
+int FLAGS_ops = 1000000;
+
+// Bytes per append and per read.
+int FLAGS_value_size = 100;
+
+// Sampling rate of the second instrumented run.
+int FLAGS_sample_one_in = 64;
+
+// Directory holding the default Env's files.
+const char *FLAGS_db = "/tmp";
+
+// Runs per operation; the fastest one is reported.
+const int kRuns = 5;
+
+} // namespace
+
+namespace leveldb {
+
+// Prefix of the files used; set per Env.
+static string dir;
+
+static double NowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Check(const Status& s) {
+    if (!s.ok()) {
+        fprintf(stderr, "%s\n", s.ToString().c_str());
+        exit(1);
+    }
+}
+
+// Nanoseconds per append.
+static double Append(Env *env) {
+    const string value(FLAGS_value_size, 'x');
+    WritableFile *file;
+    Check(env->NewWritableFile(dir + "/append", &file));
+    const double start = NowNanos();
+    for (int i = 0; i < FLAGS_ops; i++) {
+        Check(file->Append(value));
+    }
+    const double nanos = NowNanos() - start;
+    delete file;
+    Check(env->RemoveFile(dir + "/append"));
+    return nanos / FLAGS_ops;
+}
+
+// Nanoseconds per read, at offsets spread over the file.
+static double RandomRead(Env *env) {
+    const int kValues = 10000;
+    WritableFile *writable_file;
+    Check(env->NewWritableFile(dir + "/read", &writable_file));
+    Check(writable_file->Append(string(static_cast<size_t>(kValues) * FLAGS_value_size, 'x')));
+    delete writable_file;
+
+    RandomAccessFile *file;
+    Check(env->NewRandomAccessFile(dir + "/read", &file));
+    string scratch(FLAGS_value_size, '\0');
+    Slice result;
+    const double start = NowNanos();
+    for (int i = 0; i < FLAGS_ops; i++) {
+        const uint64_t offset = static_cast<uint64_t>(i * 7919 % kValues) * FLAGS_value_size;
+        Check(file->Read(offset, FLAGS_value_size, &result, &scratch[0]));
+    }
+    const double nanos = NowNanos() - start;
+    delete file;
+    Check(env->RemoveFile(dir + "/read"));
+    return nanos / FLAGS_ops;
+}
+
+// Nanoseconds per ScheduleWithHandle() of an empty work item and Wait().
+static double Schedule(Env *env) {
+    const int ops = FLAGS_ops / 50;
+    const double start = NowNanos();
+    for (int i = 0; i < ops; i++) {
+        env->ScheduleWithHandle([](void *) {}, nullptr).Wait();
+    }
+    return (NowNanos() - start) / ops;
+}
+
+static void Compare(const char *name, double (*op)(Env *), Env *bare, Env *instrumented) {
+    double bare_nanos = 0;
+    double instrumented_nanos = 0;
+    for (int r = 0; r < kRuns; r++) {
+        // Interleaved, so that both see the same machine state.
+        const double b = op(bare);
+        const double i = op(instrumented);
+        if (r == 0 || b < bare_nanos) {
+            bare_nanos = b;
+        }
+        if (r == 0 || i < instrumented_nanos) {
+            instrumented_nanos = i;
+        }
+    }
+    fprintf(stdout, "%-16s : %10.1f ns/op bare, %10.1f ns/op instrumented, %+6.1f%%\n",
+            name, bare_nanos, instrumented_nanos,
+            (instrumented_nanos - bare_nanos) * 100 / bare_nanos);
+}
+
+static void Run(uint32_t sample_one_in) {
+    fprintf(stdout, "Sampling:    one in %u\n", sample_one_in);
+    EnvStatistics stats(sample_one_in);
+    Env *mem = NewMemEnv(Env::Default());
+    Env *instrumented = NewInstrumentedEnv(mem, &stats);
+    dir = "";
+    Compare("memenv append", &Append, mem, instrumented);
+    Compare("memenv read", &RandomRead, mem, instrumented);
+    delete instrumented;
+    delete mem;
+
+    instrumented = NewInstrumentedEnv(Env::Default(), &stats);
+    dir = FLAGS_db;
+    Compare("posix append", &Append, Env::Default(), instrumented);
+    Compare("posix read", &RandomRead, Env::Default(), instrumented);
+    Compare("schedule", &Schedule, Env::Default(), instrumented);
+    delete instrumented;
+}
+
+static void Run() {
+    fprintf(stdout, "Ops:         %d\n", FLAGS_ops);
+    fprintf(stdout, "Value size:  %d bytes\n", FLAGS_value_size);
+    fprintf(stdout, "------------------------------------------------\n");
+    Run(1);
+    fprintf(stdout, "------------------------------------------------\n");
+    Run(FLAGS_sample_one_in);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--ops=%d%c", &n, &junk) == 1 && n >= 50) {
+            FLAGS_ops = n;
+        } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_value_size = n;
+        } else if (sscanf(argv[i], "--sample_one_in=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_sample_one_in = n;
+        } else if (strncmp(argv[i], "--db=", 5) == 0) {
+            FLAGS_db = argv[i] + 5;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    leveldb::Run();
+    return 0;
+}
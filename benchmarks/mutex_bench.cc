@@ -0,0 +1,124 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Measures lock throughput of port::Mutex against std::mutex when several
+ * threads compete for one lock around a short critical section.
+ *
+ *     ./mutex_bench --threads=8 --ops=1000000 --critical_section=20
+ */
+
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Lock acquisitions per thread.
+int FLAGS_ops = 1000000;
+
+// Largest number of threads; runs use 1, 2, 4, ... up to it.
+int FLAGS_threads = 8;
+
+// Iterations of busy work inside and outside the critical section.
+int FLAGS_critical_section = 20;
+
+} // namespace
+
+namespace leveldb {
+
+// Busy work the optimizer cannot drop.
+static void Work(int iterations, uint64_t *sink) {
+    uint64_t v = *sink;
+    for (int i = 0; i < iterations; i++) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    *sink = v;
+}
+
+template <typename Lock>
+static void Run(const char *name, int num_threads) {
+    Lock lock;
+    uint64_t shared = 0;
+
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&lock, &shared]() {
+            uint64_t local = 1;
+            for (int i = 0; i < FLAGS_ops; i++) {
+                lock.Acquire();
+                Work(FLAGS_critical_section, &shared);
+                lock.Release();
+                Work(FLAGS_critical_section, &local);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    const double micros = chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+
+    const double ops = static_cast<double>(FLAGS_ops) * num_threads;
+    fprintf(stdout, "%-12s %2d threads : %8.3f micros/op; %12.0f ops/sec\n",
+            name, num_threads, micros / ops, ops * 1e6 / micros);
+}
+
+struct PortMutex {
+    port::Mutex mu;
+    void Acquire() {
+        mu.Lock();
+    }
+    void Release() {
+        mu.Unlock();
+    }
+};
+
+struct StdMutex {
+    mutex mu;
+    void Acquire() {
+        mu.lock();
+    }
+    void Release() {
+        mu.unlock();
+    }
+};
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--ops=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_ops = n;
+        } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_threads = n;
+        } else if (sscanf(argv[i], "--critical_section=%d%c", &n, &junk) == 1 && n >= 0) {
+            FLAGS_critical_section = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    fprintf(stdout, "CPUs:             %u\n", thread::hardware_concurrency());
+    fprintf(stdout, "Ops per thread:   %d\n", FLAGS_ops);
+    fprintf(stdout, "Critical section: %d iterations\n", FLAGS_critical_section);
+    fprintf(stdout, "------------------------------------------------\n");
+    for (int threads = 1; threads <= FLAGS_threads; threads *= 2) {
+        leveldb::Run<leveldb::StdMutex>("std::mutex", threads);
+        leveldb::Run<leveldb::PortMutex>("port::Mutex", threads);
+    }
+    return 0;
+}
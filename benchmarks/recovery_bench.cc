@@ -0,0 +1,141 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Replay speed of db/log_recovery.h on a generated log.
+ *
+ *     ./recovery_bench --log_size=256 --batch_size=16 --threads=8
+ *
+ * Writes a log of about --log_size MB of write batches, each of
+ * --batch_size puts with Zipfian keys from util/workload.h, then
+ * recovers it into a fresh memtable on the reading thread alone and
+ * with 1 up to --threads (doubling) inserting threads, reporting MB/s
+ * and entries per second.
+ */
+
+#include "db/log_recovery.h"
+#include "db/log_writer.h"
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "leveldb/env.h"
+#include "util/workload.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+using namespace std;
+
+namespace {
+
+// Size of the generated log, in MB.
+int FLAGS_log_size = 256;
+
+// Puts per write batch.
+int FLAGS_batch_size = 16;
+
+// Size of every value.
+int FLAGS_value_size = 100;
+
+// Highest number of inserting threads.
+int FLAGS_threads = 8;
+
+// Directory holding the log file.
+const char *FLAGS_db = nullptr;
+
+} // namespace
+
+namespace leveldb {
+
+static void Check(const Status& s) {
+    if (!s.ok()) {
+        fprintf(stderr, "%s\n", s.ToString().c_str());
+        exit(1);
+    }
+}
+
+static void GenerateLog(Env *env, const string& fname) {
+    WorkloadOptions options;
+    options.key_distribution = KeyDistribution::kZipfian;
+    options.value_size = SizeDistribution::Fixed(FLAGS_value_size);
+    WorkloadGenerator gen(options);
+
+    WritableFile *file;
+    Check(env->NewWritableFile(fname, &file));
+    {
+        log::Writer writer(file);
+        const uint64_t target = static_cast<uint64_t>(FLAGS_log_size) * 1048576;
+        uint64_t written = 0;
+        SequenceNumber seq = 1;
+        WriteBatch batch;
+        while (written < target) {
+            batch.Clear();
+            WriteBatchInternal::SetSequence(&batch, seq);
+            for (int i = 0; i < FLAGS_batch_size; i++) {
+                batch.Put(gen.Key(gen.NextKeyNumber()), gen.Value());
+            }
+            seq += FLAGS_batch_size;
+            Check(writer.AddRecord(WriteBatchInternal::Contents(&batch)));
+            written += WriteBatchInternal::ByteSize(&batch);
+        }
+        Check(writer.Flush());
+    }
+    Check(file->Close());
+    delete file;
+}
+
+static void Run(Env *env, const string& fname, int threads) {
+    SequentialFile *file;
+    Check(env->NewSequentialFile(fname, &file));
+    MemTable *mem = new MemTable;
+    LogRecoveryOptions options;
+    options.threads = threads;
+    LogRecoveryStats stats;
+    Check(RecoverLog(file, mem, options, nullptr, &stats));
+    fprintf(stdout, "%2d threads : %8.1f MB/s; %10.0f entries/sec; %6.0f MB in memtable\n",
+            threads, stats.MBPerSecond(), stats.updates * 1e6 / stats.micros,
+            mem->ApproximateMemoryUsage() / 1048576.0);
+    delete mem;
+    delete file;
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--log_size=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_log_size = n;
+        } else if (sscanf(argv[i], "--batch_size=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_batch_size = n;
+        } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 && n >= 0) {
+            FLAGS_value_size = n;
+        } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n >= 0) {
+            FLAGS_threads = n;
+        } else if (strncmp(argv[i], "--db=", 5) == 0) {
+            FLAGS_db = argv[i] + 5;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    leveldb::Env *env = leveldb::Env::Default();
+    const string fname = string(FLAGS_db != nullptr ? FLAGS_db : "/tmp") + "/recovery_bench.log";
+    leveldb::GenerateLog(env, fname);
+
+    fprintf(stdout, "Log size:   %d MB\n", FLAGS_log_size);
+    fprintf(stdout, "Batch size: %d\n", FLAGS_batch_size);
+    fprintf(stdout, "Value size: %d\n", FLAGS_value_size);
+    fprintf(stdout, "CPUs:       %u\n", thread::hardware_concurrency());
+    fprintf(stdout, "------------------------------------------------\n");
+    leveldb::Run(env, fname, 0);
+    for (int threads = 1; threads <= FLAGS_threads; threads *= 2) {
+        leveldb::Run(env, fname, threads);
+    }
+    env->RemoveFile(fname);
+    return 0;
+}
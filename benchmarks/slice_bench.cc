@@ -0,0 +1,105 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Speed of the Slice comparison primitives on pairs of keys that share a
+ * prefix of a given length, as sorted keys in a block or a skiplist do.
+ *
+ *     ./slice_bench --pairs=1000000
+ *
+ * For every shared prefix length it reports nanoseconds per pair for
+ * compare(), starts_with() of the shared part, difference_offset(), and a
+ * byte-at-a-time prefix loop as the baseline difference_offset() replaces.
+ */
+
+#include "leveldb/slice.h"
+
+#include "util/random.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Key pairs compared per prefix length and primitive.
+int FLAGS_pairs = 1000000;
+
+} // namespace
+
+namespace leveldb {
+
+static size_t BytewiseDifferenceOffset(const Slice& a, const Slice& b) {
+    const size_t n = min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+template <typename Op>
+static void Run(const char *name, const vector<string>& keys, size_t prefix, Op op) {
+    const size_t mask = keys.size() - 1;
+    long long sink = 0;
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_pairs; i++) {
+        sink += op(Slice(keys[i & mask]), Slice(keys[(i + 1) & mask]));
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%-18s prefix %5zu : %8.2f ns/pair (%02x)\n", name, prefix,
+            seconds * 1e9 / FLAGS_pairs, static_cast<unsigned>(sink & 0xff));
+}
+
+static void RunPrefix(size_t prefix) {
+    // Distinct keys that agree on their first "prefix" bytes.
+    const size_t kKeys = 1024;
+    Random rnd(301);
+    const string common(prefix, 'k');
+    vector<string> keys;
+    for (size_t i = 0; i < kKeys; i++) {
+        string key = common;
+        for (int j = 0; j < 16; j++) {
+            key.push_back(static_cast<char>(rnd.Uniform(256)));
+        }
+        keys.push_back(key);
+    }
+
+    Run("compare", keys, prefix, [](const Slice& a, const Slice& b) {
+        return a.compare(b);
+    });
+    Run("starts_with", keys, prefix, [prefix](const Slice& a, const Slice& b) {
+        return static_cast<int>(a.starts_with(Slice(b.data(), prefix)));
+    });
+    Run("difference_offset", keys, prefix, [](const Slice& a, const Slice& b) {
+        return static_cast<int>(a.difference_offset(b));
+    });
+    Run("bytewise", keys, prefix, [](const Slice& a, const Slice& b) {
+        return static_cast<int>(BytewiseDifferenceOffset(a, b));
+    });
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--pairs=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_pairs = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    for (size_t prefix : {0, 4, 8, 16, 24, 32, 64, 128, 256, 1024}) {
+        leveldb::RunPrefix(prefix);
+    }
+    return 0;
+}
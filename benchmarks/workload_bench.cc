@@ -0,0 +1,86 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Cost and shape of the key distributions of util/workload.h, to check
+ * that the generator stays cheap next to the operations it drives.
+ *
+ *     ./workload_bench --ops=10000000 --keys=1000000
+ *
+ * For each distribution it reports nanoseconds per operation and the
+ * share of the operations that went to the hottest 1% of the keys.
+ */
+
+#include "util/workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Operations drawn per distribution.
+int FLAGS_ops = 10000000;
+
+// Keys in the key space.
+int FLAGS_keys = 1000000;
+
+} // namespace
+
+namespace leveldb {
+
+static void Run(const char *name, KeyDistribution distribution) {
+    WorkloadOptions options;
+    options.num_keys = FLAGS_keys;
+    options.key_distribution = distribution;
+    options.read_weight = 8;
+    options.write_weight = 1;
+    options.scan_weight = 1;
+    WorkloadGenerator gen(options);
+
+    vector<int> counts(FLAGS_keys, 0);
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_ops; i++) {
+        const Operation op = gen.Next();
+        if (op.key_number < counts.size()) {
+            counts[op.key_number]++;
+        }
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sort(counts.begin(), counts.end(), greater<int>());
+    double top = 0;
+    for (size_t i = 0; i < counts.size() / 100; i++) {
+        top += counts[i];
+    }
+    fprintf(stdout, "%-10s : %8.2f ns/op, hottest 1%% of keys take %5.1f%% of operations\n",
+            name, seconds * 1e9 / FLAGS_ops, 100.0 * top / FLAGS_ops);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--ops=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_ops = n;
+        } else if (sscanf(argv[i], "--keys=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_keys = n;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    leveldb::Run("uniform", leveldb::KeyDistribution::kUniform);
+    leveldb::Run("zipfian", leveldb::KeyDistribution::kZipfian);
+    leveldb::Run("latest", leveldb::KeyDistribution::kLatest);
+    leveldb::Run("hotprefix", leveldb::KeyDistribution::kHotPrefix);
+    return 0;
+}
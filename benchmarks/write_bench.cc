@@ -0,0 +1,138 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Write throughput of db/write_pipeline.h into a log file and a
+ * memtable, with the group's memtable inserts serialized behind the
+ * leader ("serial") and done by every member in parallel while the next
+ * group writes the log ("pipelined").
+ *
+ *     ./write_bench --threads=16 --writes=200000 --value_size=100 --sync=0
+ *
+ * For each mode and each thread count from 1 up to --threads (doubling)
+ * it reports writes per second and the average group size.
+ */
+
+#include "db/log_writer.h"
+#include "db/memtable.h"
+#include "db/write_pipeline.h"
+#include "leveldb/env.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Total writes per run, split over the threads.
+int FLAGS_writes = 200000;
+
+// Highest number of writer threads.
+int FLAGS_threads = 16;
+
+// Size of every value.
+int FLAGS_value_size = 100;
+
+// Sync the log on every write.
+bool FLAGS_sync = false;
+
+// Directory holding the log file.
+const char *FLAGS_db = nullptr;
+
+} // namespace
+
+namespace leveldb {
+
+static void Run(Env *env, const string& fname, int threads, bool pipelined) {
+    WritableFile *file;
+    Status s = env->NewWritableFile(fname, &file);
+    if (!s.ok()) {
+        fprintf(stderr, "%s\n", s.ToString().c_str());
+        exit(1);
+    }
+
+    {
+        log::Writer log(file);
+        MemTable mem;
+        WritePipeline::Options options;
+        options.concurrent_memtable_writes = pipelined;
+        WritePipeline pipeline(&log, &mem, 0, options);
+
+        const int per_thread = FLAGS_writes / threads;
+        const string value(FLAGS_value_size, 'x');
+        const uint64_t start = env->NowMicros();
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                char key[32];
+                WriteBatch batch;
+                for (int i = 0; i < per_thread; i++) {
+                    // Spread the threads' keys over the whole table.
+                    snprintf(key, sizeof(key), "%016d", i * threads + t);
+                    batch.Clear();
+                    batch.Put(key, value);
+                    Status ws = pipeline.Write(&batch, FLAGS_sync);
+                    if (!ws.ok()) {
+                        fprintf(stderr, "write failed: %s\n", ws.ToString().c_str());
+                        exit(1);
+                    }
+                }
+            });
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+        const uint64_t micros = env->NowMicros() - start;
+
+        const WritePipeline::Stats stats = pipeline.GetStats();
+        fprintf(stdout, "%-9s %3d threads : %10.0f writes/sec; %6.1f writes/group\n",
+                pipelined ? "pipelined" : "serial", threads,
+                per_thread * threads * 1e6 / micros,
+                static_cast<double>(stats.writes) / stats.groups);
+    }
+
+    file->Close();
+    delete file;
+    env->RemoveFile(fname);
+}
+
+} // namespace leveldb.
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        int n;
+        char junk;
+        if (sscanf(argv[i], "--writes=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_writes = n;
+        } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n > 0) {
+            FLAGS_threads = n;
+        } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 && n >= 0) {
+            FLAGS_value_size = n;
+        } else if (sscanf(argv[i], "--sync=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+            FLAGS_sync = n;
+        } else if (strncmp(argv[i], "--db=", 5) == 0) {
+            FLAGS_db = argv[i] + 5;
+        } else {
+            fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    leveldb::Env *env = leveldb::Env::Default();
+    const string fname = string(FLAGS_db != nullptr ? FLAGS_db : "/tmp") + "/write_bench.log";
+    fprintf(stdout, "Writes:     %d\n", FLAGS_writes);
+    fprintf(stdout, "Value size: %d\n", FLAGS_value_size);
+    fprintf(stdout, "Sync:       %d\n", FLAGS_sync);
+    fprintf(stdout, "CPUs:       %u\n", thread::hardware_concurrency());
+    fprintf(stdout, "------------------------------------------------\n");
+    for (int threads = 1; threads <= FLAGS_threads; threads *= 2) {
+        leveldb::Run(env, fname, threads, false);
+        leveldb::Run(env, fname, threads, true);
+    }
+    return 0;
+}
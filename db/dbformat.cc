@@ -0,0 +1,32 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "dbformat.h"
+
+#include <cstring>
+using namespace std;
+
+namespace leveldb {
+
+LookupKey::LookupKey(const Slice& user_key, SequenceNumber s)
+{
+    const size_t usize = user_key.size();
+    const size_t needed = usize + 13;  // A conservative estimate.
+    char *dst;
+    if (needed <= sizeof(_space)) {
+        dst = _space;
+    } else {
+        dst = new char[needed];
+    }
+    _start = dst;
+    dst = EncodeVarint32(dst, usize + kTagSize);
+    _kstart = dst;
+    memcpy(dst, user_key.data(), usize);
+    dst += usize;
+    EncodeFixed64(dst, PackSequenceAndType(s, kValueTypeForSeek));
+    dst += kTagSize;
+    _end = dst;
+}
+
+} // namespace leveldb.
@@ -0,0 +1,132 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/slice.h"
+#include "util/coding.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Value types encoded as the last component of internal keys.
+ * DO NOT CHANGE THESE ENUM VALUES: they are embedded in the on-disk
+ * data structures.
+ */
+enum ValueType {
+    kTypeDeletion = 0x0,
+    kTypeValue = 0x1
+};
+
+/*
+ * kValueTypeForSeek defines the ValueType that should be passed when
+ * constructing a lookup key for a particular sequence number (since we
+ * sort sequence numbers in decreasing order and the value type is
+ * embedded as the low 8 bits in the sequence number in internal keys,
+ * we need to use the highest-numbered ValueType, not the lowest).
+ */
+static const ValueType kValueTypeForSeek = kTypeValue;
+
+typedef uint64_t SequenceNumber;
+
+// We leave eight bits empty at the bottom so a type and sequence#
+// can be packed together into 64-bits.
+static const SequenceNumber kMaxSequenceNumber = ((0x1ull << 56) - 1);
+
+// Size of the tag that follows the user key in an internal key.
+static const size_t kTagSize = 8;
+
+inline uint64_t PackSequenceAndType(SequenceNumber seq, ValueType t) {
+    assert(seq <= kMaxSequenceNumber);
+    assert(t <= kValueTypeForSeek);
+    return (seq << 8) | t;
+}
+
+// An internal key is the user key followed by the packed tag.
+inline Slice ExtractUserKey(const Slice& internal_key) {
+    assert(internal_key.size() >= kTagSize);
+    return Slice(internal_key.data(), internal_key.size() - kTagSize);
+}
+
+inline uint64_t ExtractTag(const Slice& internal_key) {
+    assert(internal_key.size() >= kTagSize);
+    return DecodeFixed64(internal_key.data() + internal_key.size() - kTagSize);
+}
+
+/*
+ * Orders internal keys by increasing user key (bytewise), then by
+ * decreasing sequence number, so that the newest entry for a key comes
+ * first.
+ */
+inline int CompareInternalKey(const Slice& a, const Slice& b) {
+    int r = ExtractUserKey(a).compare(ExtractUserKey(b));
+    if (r == 0) {
+        const uint64_t atag = ExtractTag(a);
+        const uint64_t btag = ExtractTag(b);
+        if (atag > btag) {
+            r = -1;
+        } else if (atag < btag) {
+            r = +1;
+        }
+    }
+    return r;
+}
+
+/*
+ * A helper class useful for MemTable::Get(): the memtable entry prefix
+ * of a lookup for "user_key" as of "sequence".
+ */
+class LookupKey {
+public:
+    LookupKey(const Slice& user_key, SequenceNumber sequence);
+
+    LookupKey(const LookupKey&) = delete;
+    LookupKey& operator=(const LookupKey&) = delete;
+
+    ~LookupKey();
+
+    // Return a key suitable for lookup in a MemTable.
+    Slice memtable_key() const {
+        return Slice(_start, _end - _start);
+    }
+
+    // Return an internal key.
+    Slice internal_key() const {
+        return Slice(_kstart, _end - _kstart);
+    }
+
+    // Return the user key.
+    Slice user_key() const {
+        return Slice(_kstart, _end - _kstart - kTagSize);
+    }
+
+private:
+    /*
+     * We construct a char array of the form:
+     *    klength  varint32               <-- _start
+     *    userkey  char[klength - 8]      <-- _kstart
+     *    tag      uint64
+     *                                    <-- _end
+     * The array is a suitable MemTable key.
+     */
+    const char *_start;
+    const char *_kstart;
+    const char *_end;
+
+    // Avoid allocation for short keys.
+    char _space[200];
+};
+
+inline LookupKey::~LookupKey() {
+    if (_start != _space) {
+        delete[] _start;
+    }
+}
+
+} // namespace leveldb.
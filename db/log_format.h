@@ -0,0 +1,47 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+/*
+ * Log format information shared by reader and writer.
+ *
+ * A log is a sequence of 32 KB blocks. A record that does not fit in what
+ * is left of a block is split into fragments: FIRST in this block, MIDDLE
+ * in whole blocks after it, and LAST; a record that fits is one FULL
+ * fragment. Each fragment has a 7 byte header:
+ *
+ *     checksum: uint32    masked crc32c of type and data[], little-endian
+ *     length:   uint16    little-endian
+ *     type:     uint8     one of RecordType
+ *     data:     uint8[length]
+ *
+ * A block never ends with a partial header: if fewer than 7 bytes are
+ * left, they are zero filled and the next fragment starts a new block.
+ */
+
+#pragma once
+
+namespace leveldb {
+namespace log {
+
+enum RecordType {
+    // Zero is reserved for preallocated files.
+    kZeroType = 0,
+
+    kFullType = 1,
+
+    // For fragments.
+    kFirstType = 2,
+    kMiddleType = 3,
+    kLastType = 4,
+};
+
+static const int kMaxRecordType = kLastType;
+
+static const int kBlockSize = 32768;
+
+// Header is checksum (4 bytes), length (2 bytes), type (1 byte).
+static const int kHeaderSize = 4 + 2 + 1;
+
+} // namespace log.
+} // namespace leveldb.
@@ -0,0 +1,292 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "log_reader.h"
+
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+#include <cstdio>
+using namespace std;
+
+namespace leveldb {
+namespace log {
+
+Reader::Reporter::~Reporter() = default;
+
+Reader::Reader(SequentialFile *file, Reporter *reporter, bool checksum, uint64_t initial_offset)
+    : _file(file),
+      _reporter(reporter),
+      _checksum(checksum),
+      _backing_store(new char[kBlockSize]),
+      _buffer(),
+      _eof(false),
+      _last_record_offset(0),
+      _end_of_buffer_offset(0),
+      _initial_offset(initial_offset),
+      _resyncing(initial_offset > 0)
+{
+}
+
+Reader::~Reader()
+{
+    delete[] _backing_store;
+}
+
+bool
+Reader::SkipToInitialBlock()
+{
+    const size_t offset_in_block = _initial_offset % kBlockSize;
+    uint64_t block_start_location = _initial_offset - offset_in_block;
+
+    // Don't search a block if we'd be in the trailer.
+    if (offset_in_block > kBlockSize - 6) {
+        block_start_location += kBlockSize;
+    }
+
+    _end_of_buffer_offset = block_start_location;
+
+    // Skip to start of first block that can contain the initial record.
+    if (block_start_location > 0) {
+        Status skip_status = _file->Skip(block_start_location);
+        if (!skip_status.ok()) {
+            ReportDrop(block_start_location, skip_status);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+Reader::ReadRecord(Slice *record, string *scratch)
+{
+    if (_last_record_offset < _initial_offset) {
+        if (!SkipToInitialBlock()) {
+            return false;
+        }
+    }
+
+    scratch->clear();
+    record->clear();
+    bool in_fragmented_record = false;
+
+    // Record offset of the logical record that we're reading.
+    // 0 is a dummy value to make compilers happy.
+    uint64_t prospective_record_offset = 0;
+
+    Slice fragment;
+    while (true) {
+        const unsigned int record_type = ReadPhysicalRecord(&fragment);
+
+        /*
+         * ReadPhysicalRecord may have only had an empty trailer remaining in its
+         * internal buffer. Calculate the offset of the next physical record now
+         * that it has returned, properly accounting for its header size.
+         */
+        uint64_t physical_record_offset = _end_of_buffer_offset - _buffer.size() - kHeaderSize - fragment.size();
+
+        if (_resyncing) {
+            if (record_type == kMiddleType) {
+                continue;
+            } else if (record_type == kLastType) {
+                _resyncing = false;
+                continue;
+            } else {
+                _resyncing = false;
+            }
+        }
+
+        switch (record_type) {
+        case kFullType:
+            if (in_fragmented_record) {
+                /*
+                 * An unfinished record is dropped. An empty kFirstType
+                 * fragment at the tail of a block carries no data, so it
+                 * is not reported.
+                 */
+                if (!scratch->empty()) {
+                    ReportCorruption(scratch->size(), "partial record without end(1)");
+                }
+            }
+            prospective_record_offset = physical_record_offset;
+            scratch->clear();
+            *record = fragment;
+            _last_record_offset = prospective_record_offset;
+            return true;
+
+        case kFirstType:
+            if (in_fragmented_record) {
+                // An unfinished record is dropped; see above.
+                if (!scratch->empty()) {
+                    ReportCorruption(scratch->size(), "partial record without end(2)");
+                }
+            }
+            prospective_record_offset = physical_record_offset;
+            scratch->assign(fragment.data(), fragment.size());
+            in_fragmented_record = true;
+            break;
+
+        case kMiddleType:
+            if (!in_fragmented_record) {
+                ReportCorruption(fragment.size(), "missing start of fragmented record(1)");
+            } else {
+                scratch->append(fragment.data(), fragment.size());
+            }
+            break;
+
+        case kLastType:
+            if (!in_fragmented_record) {
+                ReportCorruption(fragment.size(), "missing start of fragmented record(2)");
+            } else {
+                scratch->append(fragment.data(), fragment.size());
+                *record = Slice(*scratch);
+                _last_record_offset = prospective_record_offset;
+                return true;
+            }
+            break;
+
+        case kEof:
+            if (in_fragmented_record) {
+                /*
+                 * This can be caused by the writer dying immediately after
+                 * writing a physical record but before completing the next;
+                 * don't treat it as a corruption, just ignore the entire
+                 * logical record.
+                 */
+                scratch->clear();
+            }
+            return false;
+
+        case kBadRecord:
+            if (in_fragmented_record) {
+                ReportCorruption(scratch->size(), "error in middle of record");
+                in_fragmented_record = false;
+                scratch->clear();
+            }
+            break;
+
+        default: {
+            char buf[40];
+            snprintf(buf, sizeof(buf), "unknown record type %u", record_type);
+            ReportCorruption((fragment.size() + (in_fragmented_record ? scratch->size() : 0)), buf);
+            in_fragmented_record = false;
+            scratch->clear();
+            break;
+        }
+        }
+    }
+    return false;
+}
+
+void
+Reader::ReportCorruption(uint64_t bytes, const char *reason)
+{
+    ReportDrop(bytes, Status::Corruption(reason));
+}
+
+void
+Reader::ReportDrop(uint64_t bytes, const Status& reason)
+{
+    if (_reporter != nullptr && _end_of_buffer_offset - _buffer.size() - bytes >= _initial_offset) {
+        _reporter->Corruption(static_cast<size_t>(bytes), reason);
+    }
+}
+
+unsigned int
+Reader::ReadPhysicalRecord(Slice *result)
+{
+    while (true) {
+        if (_buffer.size() < kHeaderSize) {
+            if (!_eof) {
+                // Last read was a full read, so this is a trailer to skip.
+                _buffer.clear();
+                Status status = _file->Read(kBlockSize, &_buffer, _backing_store);
+                _end_of_buffer_offset += _buffer.size();
+                if (!status.ok()) {
+                    _buffer.clear();
+                    ReportDrop(kBlockSize, status);
+                    _eof = true;
+                    return kEof;
+                } else if (_buffer.size() < kBlockSize) {
+                    _eof = true;
+                }
+                continue;
+            } else {
+                /*
+                 * Note that if _buffer is non-empty, we have a truncated header at the
+                 * end of the file, which can be caused by the writer crashing in the
+                 * middle of writing the header. Instead of considering this an error,
+                 * just report EOF.
+                 */
+                _buffer.clear();
+                return kEof;
+            }
+        }
+
+        // Parse the header.
+        const char *header = _buffer.data();
+        const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
+        const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
+        const unsigned int type = static_cast<unsigned char>(header[6]);
+        const uint32_t length = a | (b << 8);
+        if (kHeaderSize + length > _buffer.size()) {
+            const size_t drop_size = _buffer.size();
+            _buffer.clear();
+            if (!_eof) {
+                ReportCorruption(drop_size, "bad record length");
+                return kBadRecord;
+            }
+            /*
+             * If the end of the file has been reached without reading |length| bytes
+             * of payload, assume the writer died in the middle of writing the record.
+             * Don't report a corruption.
+             */
+            return kEof;
+        }
+
+        if (type == kZeroType && length == 0) {
+            /*
+             * Skip zero length record without reporting any drops since
+             * such records are produced by writers that preallocate file
+             * regions.
+             */
+            _buffer.clear();
+            return kBadRecord;
+        }
+
+        // Check crc.
+        if (_checksum) {
+            const uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(header));
+            const uint32_t actual_crc = crc32c::Value(header + 6, 1 + length);
+            if (actual_crc != expected_crc) {
+                /*
+                 * Drop the rest of the buffer since "length" itself may have
+                 * been corrupted and if we trust it, we could find some
+                 * fragment of a real log record that just happens to look
+                 * like a valid log record.
+                 */
+                const size_t drop_size = _buffer.size();
+                _buffer.clear();
+                ReportCorruption(drop_size, "checksum mismatch");
+                return kBadRecord;
+            }
+        }
+
+        _buffer.remove_prefix(kHeaderSize + length);
+
+        // Skip physical record that started before _initial_offset.
+        if (_end_of_buffer_offset - _buffer.size() - kHeaderSize - length < _initial_offset) {
+            result->clear();
+            return kBadRecord;
+        }
+
+        *result = Slice(header + kHeaderSize, length);
+        return type;
+    }
+}
+
+} // namespace log.
+} // namespace leveldb.
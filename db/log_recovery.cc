@@ -0,0 +1,203 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "log_recovery.h"
+
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace leveldb {
+
+namespace {
+
+/*
+ * Hands batches from the reading thread to the inserting threads.
+ *
+ * The batches live in a fixed set of slots that go round between the
+ * two sides, so a slot's buffer is reused once it has grown to the
+ * size of the largest batches, and reading allocates nothing per
+ * record after a while.
+ */
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t depth)
+        : _slots(depth), _ready(depth), _ready_head(0), _ready_count(0),
+          _closed(false), _free_cv(&_mu), _ready_cv(&_mu) {
+        for (size_t i = 0; i < depth; i++) {
+            _free.push_back(i);
+        }
+    }
+
+    // Waits for a slot to fill.
+    WriteBatch *Acquire() EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        while (_free.empty()) {
+            _free_cv.Wait();
+        }
+        const size_t slot = _free.back();
+        _free.pop_back();
+        return &_slots[slot];
+    }
+
+    // Queues a slot from Acquire() for insertion.
+    void Push(WriteBatch *batch) EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        assert(_ready_count < _ready.size());
+        _ready[(_ready_head + _ready_count) % _ready.size()] = batch - &_slots[0];
+        _ready_count++;
+        _ready_cv.Signal();
+    }
+
+    // No more batches will be pushed.
+    void Close() EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        _closed = true;
+        _ready_cv.SignalAll();
+    }
+
+    // Waits for a queued batch; returns nullptr once closed and drained.
+    WriteBatch *Pop() EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        while (_ready_count == 0 && !_closed) {
+            _ready_cv.Wait();
+        }
+        if (_ready_count == 0) {
+            return nullptr;
+        }
+        const size_t slot = _ready[_ready_head];
+        _ready_head = (_ready_head + 1) % _ready.size();
+        _ready_count--;
+        return &_slots[slot];
+    }
+
+    // Returns a slot from Pop() for reuse.
+    void Release(WriteBatch *batch) EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        _free.push_back(batch - &_slots[0]);
+        _free_cv.Signal();
+    }
+
+private:
+    vector<WriteBatch> _slots;
+
+    port::Mutex _mu;
+
+    // Slots neither filling nor queued.
+    vector<size_t> _free GUARDED_BY(_mu);
+
+    // Queued slots, as a ring of _ready_count entries from _ready_head.
+    vector<size_t> _ready GUARDED_BY(_mu);
+    size_t _ready_head GUARDED_BY(_mu);
+    size_t _ready_count GUARDED_BY(_mu);
+
+    bool _closed GUARDED_BY(_mu);
+
+    port::CondVar _free_cv;
+    port::CondVar _ready_cv;
+};
+
+// Keeps the first insertion error of any thread.
+class ErrorSlot {
+public:
+    void Set(const Status& s) EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        if (_status.ok()) {
+            _status = s;
+        }
+    }
+
+    Status Get() EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        return _status;
+    }
+
+private:
+    port::Mutex _mu;
+    Status _status GUARDED_BY(_mu);
+};
+
+} // namespace
+
+Status
+RecoverLog(SequentialFile *file, MemTable *mem, const LogRecoveryOptions& options,
+           log::Reader::Reporter *reporter, LogRecoveryStats *stats)
+{
+    const auto start = chrono::steady_clock::now();
+    LogRecoveryStats counts = {0, 0, 0, 0, 0};
+    ErrorSlot error;
+
+    const bool parallel = options.threads > 0;
+    BatchQueue queue(parallel ? max<size_t>(options.queue_depth, 1) : 0);
+    vector<thread> workers;
+    for (int i = 0; i < options.threads; i++) {
+        workers.emplace_back([&queue, &error, mem]() {
+            WriteBatch *batch;
+            while ((batch = queue.Pop()) != nullptr) {
+                Status s = WriteBatchInternal::InsertInto(batch, mem, true);
+                if (!s.ok()) {
+                    error.Set(s);
+                }
+                queue.Release(batch);
+            }
+        });
+    }
+
+    log::Reader reader(file, reporter, options.checksum, 0);
+    string scratch;
+    Slice record;
+    WriteBatch inline_batch;
+    while (reader.ReadRecord(&record, &scratch)) {
+        if (record.size() < WriteBatchInternal::kHeader) {
+            if (reporter != nullptr) {
+                reporter->Corruption(record.size(), Status::Corruption("log record too small"));
+            }
+            continue;
+        }
+
+        // The record is only valid until the next read, so it is copied.
+        WriteBatch *batch = parallel ? queue.Acquire() : &inline_batch;
+        WriteBatchInternal::SetContents(batch, record);
+        const int count = WriteBatchInternal::Count(batch);
+        const SequenceNumber last_sequence = WriteBatchInternal::Sequence(batch) + count - 1;
+        if (count > 0 && last_sequence > counts.last_sequence) {
+            counts.last_sequence = last_sequence;
+        }
+        counts.records++;
+        counts.updates += count;
+        counts.bytes += record.size();
+
+        if (parallel) {
+            queue.Push(batch);
+        } else {
+            Status s = WriteBatchInternal::InsertInto(batch, mem, false);
+            if (!s.ok()) {
+                error.Set(s);
+            }
+        }
+    }
+
+    queue.Close();
+    for (thread& w : workers) {
+        w.join();
+    }
+
+    counts.micros = chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+    if (stats != nullptr) {
+        *stats = counts;
+    }
+    return error.Get();
+}
+
+} // namespace leveldb.
@@ -0,0 +1,69 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "db/dbformat.h"
+#include "db/log_reader.h"
+#include "leveldb/status.h"
+
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+namespace leveldb {
+
+class MemTable;
+class SequentialFile;
+
+struct LogRecoveryOptions {
+    /*
+     * Threads inserting batches into the memtable, next to the calling
+     * thread that reads the log. With 0, the calling thread inserts each
+     * batch itself as it reads it.
+     */
+    int threads = 4;
+
+    // Batches read ahead of the inserting threads.
+    size_t queue_depth = 64;
+
+    // Verify the checksums of log records.
+    bool checksum = true;
+};
+
+struct LogRecoveryStats {
+    uint64_t records;               // Batches inserted.
+    uint64_t updates;               // Entries in those batches.
+    uint64_t bytes;                 // Size of those batches.
+    uint64_t micros;                // Wall time of the recovery.
+    SequenceNumber last_sequence;   // Highest sequence number seen.
+
+    // Recovery throughput in MB of batches per second.
+    double MBPerSecond() const {
+        return micros == 0 ? 0 : bytes / 1048576.0 / (micros * 1e-6);
+    }
+};
+
+/*
+ * Replays the write batches logged in "*file" into "*mem".
+ *
+ * The calling thread reads and checksums the log records and hands them
+ * to "options.threads" threads, which insert them in parallel with
+ * MemTable::AddConcurrently(). Batches may thus go in out of log order,
+ * but each entry keeps the sequence number it was logged with, and the
+ * memtable orders a key's entries by sequence number, so lookups see the
+ * same newest entry as after a replay in log order.
+ *
+ * Records dropped by the log reader are passed to "reporter", if any,
+ * as are records too short to be batches. A batch that does not parse
+ * fails the recovery, though batches read before and after it may
+ * already be in the memtable. "*stats", if non-null, receives counters
+ * for the batches inserted.
+ *
+ * "*mem" must not be used by anyone else until this returns.
+ */
+Status RecoverLog(SequentialFile *file, MemTable *mem, const LogRecoveryOptions& options,
+                  log::Reader::Reporter *reporter, LogRecoveryStats *stats);
+
+} // namespace leveldb.
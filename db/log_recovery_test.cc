@@ -0,0 +1,202 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "log_recovery.h"
+#include "db/log_writer.h"
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "leveldb/env.h"
+#include "util/random.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+class StringDest : public WritableFile {
+public:
+    Status Close() override {
+        return Status::OK();
+    }
+    Status Flush() override {
+        return Status::OK();
+    }
+    Status Sync() override {
+        return Status::OK();
+    }
+    Status Append(const Slice& slice) override {
+        _contents.append(slice.data(), slice.size());
+        return Status::OK();
+    }
+
+    string _contents;
+};
+
+class StringSource : public SequentialFile {
+public:
+    explicit StringSource(const Slice& contents) : _contents(contents) {}
+
+    Status Read(size_t n, Slice *result, char *scratch) override {
+        n = min(n, _contents.size());
+        memcpy(scratch, _contents.data(), n);
+        *result = Slice(scratch, n);
+        _contents.remove_prefix(n);
+        return Status::OK();
+    }
+    Status Skip(uint64_t n) override {
+        _contents.remove_prefix(min<uint64_t>(n, _contents.size()));
+        return Status::OK();
+    }
+
+private:
+    Slice _contents;
+};
+
+class ReportCollector : public log::Reader::Reporter {
+public:
+    void Corruption(size_t bytes, const Status& status) override {
+        _dropped_bytes += bytes;
+        _message.append(status.ToString());
+    }
+
+    size_t _dropped_bytes = 0;
+    string _message;
+};
+
+class LogRecoveryTest : public testing::Test {
+public:
+    static const int kKeys = 50;
+
+    /*
+     * Logs "batches" batches of updates to a few keys, so that most keys
+     * are written by many batches, and remembers the state of the keys
+     * after the first "snapshot" batches and at the end.
+     */
+    void Generate(int batches, int snapshot) {
+        Random rnd(301);
+        log::Writer writer(&_dest);
+        SequenceNumber seq = 1;
+        for (int b = 0; b < batches; b++) {
+            WriteBatch batch;
+            WriteBatchInternal::SetSequence(&batch, seq);
+            const int n = 1 + rnd.Uniform(10);
+            for (int i = 0; i < n; i++) {
+                const string key = "key" + to_string(rnd.Uniform(kKeys));
+                if (rnd.OneIn(4)) {
+                    batch.Delete(key);
+                    _final[key] = "DELETED";
+                } else {
+                    const string value = "v" + to_string(seq + i);
+                    batch.Put(key, value);
+                    _final[key] = value;
+                }
+            }
+            seq += n;
+            ASSERT_TRUE(writer.AddRecord(WriteBatchInternal::Contents(&batch)).ok());
+            if (b + 1 == snapshot) {
+                _snapshot = _final;
+                _snapshot_sequence = seq - 1;
+            }
+        }
+        ASSERT_TRUE(writer.Flush().ok());
+        _last_sequence = seq - 1;
+    }
+
+    static string Get(const MemTable& mem, const string& key, SequenceNumber seq) {
+        string value;
+        Status s;
+        if (!mem.Get(key, seq, &value, &s)) {
+            return "NOT_FOUND";
+        }
+        return s.IsNotFound() ? "DELETED" : value;
+    }
+
+    // Checks *mem against the state of every key as of "seq".
+    static void Check(const MemTable& mem, const map<string, string>& expected, SequenceNumber seq) {
+        for (int k = 0; k < kKeys; k++) {
+            const string key = "key" + to_string(k);
+            auto it = expected.find(key);
+            ASSERT_EQ(it == expected.end() ? "NOT_FOUND" : it->second, Get(mem, key, seq)) << key;
+        }
+    }
+
+    StringDest _dest;
+    map<string, string> _final;
+    map<string, string> _snapshot;
+    SequenceNumber _snapshot_sequence = 0;
+    SequenceNumber _last_sequence = 0;
+};
+
+TEST_F(LogRecoveryTest, Empty)
+{
+    StringSource source(_dest._contents);
+    MemTable mem;
+    LogRecoveryStats stats;
+    ASSERT_TRUE(RecoverLog(&source, &mem, LogRecoveryOptions(), nullptr, &stats).ok());
+    ASSERT_EQ(0, stats.records);
+    ASSERT_EQ(0, stats.last_sequence);
+}
+
+TEST_F(LogRecoveryTest, KeepsPerKeyOrder)
+{
+    Generate(2000, 1000);
+    for (int threads : {0, 1, 4}) {
+        for (size_t depth : {1, 64}) {
+            StringSource source(_dest._contents);
+            MemTable mem;
+            LogRecoveryOptions options;
+            options.threads = threads;
+            options.queue_depth = depth;
+            LogRecoveryStats stats;
+            ASSERT_TRUE(RecoverLog(&source, &mem, options, nullptr, &stats).ok());
+
+            ASSERT_EQ(2000, stats.records);
+            ASSERT_EQ(_last_sequence, stats.updates);
+            ASSERT_EQ(_last_sequence, stats.last_sequence);
+            Check(mem, _final, _last_sequence);
+            Check(mem, _snapshot, _snapshot_sequence);
+        }
+    }
+}
+
+TEST_F(LogRecoveryTest, ReportsCorruption)
+{
+    Generate(100, 0);
+    _dest._contents[log::kHeaderSize + 20] ^= 0x40;
+
+    StringSource source(_dest._contents);
+    MemTable mem;
+    ReportCollector report;
+    LogRecoveryStats stats;
+    ASSERT_TRUE(RecoverLog(&source, &mem, LogRecoveryOptions(), &report, &stats).ok());
+
+    // The whole first block holds every record, and it is dropped.
+    ASSERT_EQ(_dest._contents.size(), report._dropped_bytes);
+    ASSERT_NE(string::npos, report._message.find("checksum mismatch"));
+    ASSERT_EQ(0, stats.records);
+}
+
+TEST_F(LogRecoveryTest, BadBatch)
+{
+    log::Writer writer(&_dest);
+    ASSERT_TRUE(writer.AddRecord("short").ok());
+    WriteBatch batch;
+    batch.Put("a", "1");
+    WriteBatchInternal::SetCount(&batch, 2);
+    ASSERT_TRUE(writer.AddRecord(WriteBatchInternal::Contents(&batch)).ok());
+    ASSERT_TRUE(writer.Flush().ok());
+
+    StringSource source(_dest._contents);
+    MemTable mem;
+    ReportCollector report;
+    Status s = RecoverLog(&source, &mem, LogRecoveryOptions(), &report, nullptr);
+    ASSERT_TRUE(s.IsCorruption());
+    ASSERT_EQ(5, report._dropped_bytes);
+}
+
+} // namespace leveldb.
@@ -0,0 +1,144 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "log_writer.h"
+
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+namespace log {
+
+static void InitTypeCrc(uint32_t *type_crc) {
+    for (int i = 0; i <= kMaxRecordType; i++) {
+        char t = static_cast<char>(i);
+        type_crc[i] = crc32c::Value(&t, 1);
+    }
+}
+
+Writer::Writer(WritableFile *dest) : _dest(dest), _block_offset(0)
+{
+    InitTypeCrc(_type_crc);
+}
+
+Writer::Writer(WritableFile *dest, uint64_t dest_length)
+    : _dest(dest), _block_offset(dest_length % kBlockSize)
+{
+    InitTypeCrc(_type_crc);
+}
+
+Writer::~Writer() = default;
+
+Status
+Writer::AddRecord(const Slice& slice)
+{
+    if (!_status.ok()) {
+        return _status;
+    }
+
+    const char *ptr = slice.data();
+    size_t left = slice.size();
+
+    /*
+     * Fragment the record if necessary and emit it. Note that if slice
+     * is empty, we still want to iterate once to emit a single
+     * zero-length record.
+     */
+    bool begin = true;
+    do {
+        const int leftover = kBlockSize - _block_offset;
+        assert(leftover >= 0);
+        if (leftover < kHeaderSize) {
+            // Switch to a new block.
+            if (leftover > 0) {
+                // Fill the trailer, which is shorter than a header.
+                static_assert(kHeaderSize == 7, "the literal below has kHeaderSize - 1 bytes");
+                _status = _dest->Append(Slice("\x00\x00\x00\x00\x00\x00", leftover));
+                if (!_status.ok()) {
+                    return _status;
+                }
+            }
+            _block_offset = 0;
+        }
+
+        // Invariant: we never leave < kHeaderSize bytes in a block.
+        assert(kBlockSize - _block_offset - kHeaderSize >= 0);
+
+        const size_t avail = kBlockSize - _block_offset - kHeaderSize;
+        const size_t fragment_length = (left < avail) ? left : avail;
+
+        RecordType type;
+        const bool end = (left == fragment_length);
+        if (begin && end) {
+            type = kFullType;
+        } else if (begin) {
+            type = kFirstType;
+        } else if (end) {
+            type = kLastType;
+        } else {
+            type = kMiddleType;
+        }
+
+        _status = EmitPhysicalRecord(type, ptr, fragment_length);
+        if (!_status.ok()) {
+            return _status;
+        }
+        ptr += fragment_length;
+        left -= fragment_length;
+        begin = false;
+    } while (left > 0);
+    return _status;
+}
+
+Status
+Writer::Flush()
+{
+    if (_status.ok()) {
+        _status = _dest->Flush();
+    }
+    return _status;
+}
+
+Status
+Writer::Sync()
+{
+    Status s = Flush();
+    if (s.ok()) {
+        s = _dest->Sync();
+    }
+    return s;
+}
+
+Status
+Writer::EmitPhysicalRecord(RecordType t, const char *ptr, size_t length)
+{
+    assert(length <= 0xffff);  // Must fit in two bytes.
+    assert(_block_offset + kHeaderSize + length <= kBlockSize);
+
+    // Format the header.
+    char buf[kHeaderSize];
+    buf[4] = static_cast<char>(length & 0xff);
+    buf[5] = static_cast<char>(length >> 8);
+    buf[6] = static_cast<char>(t);
+
+    // Compute the crc of the record type and the payload.
+    uint32_t crc = crc32c::Extend(_type_crc[t], ptr, length);
+    crc = crc32c::Mask(crc);  // Adjust for storage.
+    EncodeFixed32(buf, crc);
+
+    // Write the header and the payload.
+    Status s = _dest->Append(Slice(buf, kHeaderSize));
+    if (s.ok()) {
+        s = _dest->Append(Slice(ptr, length));
+    }
+    _block_offset += kHeaderSize + length;
+    return s;
+}
+
+} // namespace log.
+} // namespace leveldb.
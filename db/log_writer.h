@@ -0,0 +1,77 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "db/log_format.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace leveldb {
+
+class WritableFile;
+
+namespace log {
+
+/*
+ * Appends records to a log file.
+ *
+ * Every fragment's header and payload are appended to the file as they
+ * are framed; the file's own buffer is the only copy of the bytes. A
+ * record thus reaches the file in AddRecord(), and the OS on Flush() or
+ * Sync().
+ */
+class Writer {
+public:
+    /*
+     * Create a writer that will append data to "*dest".
+     * "*dest" must be initially empty.
+     * "*dest" must remain live while this Writer is in use.
+     */
+    explicit Writer(WritableFile *dest);
+
+    /*
+     * Create a writer that will append data to "*dest".
+     * "*dest" must have initial length "dest_length".
+     * "*dest" must remain live while this Writer is in use.
+     */
+    Writer(WritableFile *dest, uint64_t dest_length);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer();
+
+    Status AddRecord(const Slice& slice);
+
+    // Flushes the file to the OS.
+    Status Flush();
+
+    // Flush(), then makes the file durable.
+    Status Sync();
+
+private:
+    Status EmitPhysicalRecord(RecordType type, const char *ptr, size_t length);
+
+    WritableFile *_dest;
+
+    // Current offset in block.
+    int _block_offset;
+
+    // A failed append to the file, returned by every later call.
+    Status _status;
+
+    /*
+     * crc32c values for all supported record types. These are
+     * pre-computed to reduce the overhead of computing the crc of the
+     * record type stored in the header.
+     */
+    uint32_t _type_crc[kMaxRecordType + 1];
+};
+
+} // namespace log.
+} // namespace leveldb.
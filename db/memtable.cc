@@ -4,14 +4,123 @@
 
 #include "memtable.h"
 
+#include "util/coding.h"
+
+#include <cstring>
+using namespace std;
+
 namespace leveldb {
 
-MemTable::MemTable() {
+static Slice GetLengthPrefixedSlice(const char *data) {
+    uint32_t len;
+    const char *p = data;
+    p = GetVarint32Ptr(p, p + 5, &len);  // +5: we assume "p" is not corrupted.
+    return Slice(p, len);
+}
+
+int
+MemTable::KeyComparator::operator()(const char *a, const char *b) const
+{
+    // Internal keys are encoded as length-prefixed strings.
+    return CompareInternalKey(GetLengthPrefixedSlice(a), GetLengthPrefixedSlice(b));
+}
+
+MemTable::MemTable() : _table(KeyComparator(), &_arena)
+{
+}
+
+MemTable::~MemTable()
+{
+}
+
+size_t
+MemTable::ApproximateMemoryUsage() const
+{
+    return _arena.MemoryUsage();
+}
+
+size_t
+MemTable::EncodedLength(const Slice& key, const Slice& value)
+{
+    const size_t internal_key_size = key.size() + kTagSize;
+    return VarintLength(internal_key_size) + internal_key_size +
+           VarintLength(value.size()) + value.size();
+}
+
+void
+MemTable::Encode(char *buf, SequenceNumber seq, ValueType type,
+                 const Slice& key, const Slice& value)
+{
+    char *p = EncodeVarint32(buf, key.size() + kTagSize);
+    memcpy(p, key.data(), key.size());
+    p += key.size();
+    EncodeFixed64(p, PackSequenceAndType(seq, type));
+    p += kTagSize;
+    p = EncodeVarint32(p, value.size());
+    memcpy(p, value.data(), value.size());
+}
+
+void
+MemTable::Add(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value)
+{
+    char *buf = _arena.Allocate(EncodedLength(key, value));
+    Encode(buf, seq, type, key, value);
+    _table.Insert(buf);
+}
+
+void
+MemTable::AddConcurrently(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value)
+{
+    char *buf = _arena.AllocateConcurrent(EncodedLength(key, value));
+    Encode(buf, seq, type, key, value);
+    _table.InsertConcurrently(buf);
+}
+
+Slice
+MemTable::Iterator::key() const
+{
+    return GetLengthPrefixedSlice(_iter.GetKey());
+}
 
+Slice
+MemTable::Iterator::value() const
+{
+    const Slice key_slice = GetLengthPrefixedSlice(_iter.GetKey());
+    return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
 }
 
-MemTable::~MemTable() {
+bool
+MemTable::Get(const Slice& key, SequenceNumber seq, string *value, Status *s) const
+{
+    LookupKey lkey(key, seq);
+    Table::Iterator iter(&_table);
+    iter.Seek(lkey.memtable_key().data());
+    if (!iter.Valid()) {
+        return false;
+    }
 
+    /*
+     * The seek skipped every entry of the key newer than "seq", so the
+     * entry found is the newest visible one if it has the same user key.
+     */
+    const char *entry = iter.GetKey();
+    uint32_t key_length;
+    const char *key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+    const Slice internal_key(key_ptr, key_length);
+    if (ExtractUserKey(internal_key) != key) {
+        return false;
+    }
+    switch (static_cast<ValueType>(ExtractTag(internal_key) & 0xff)) {
+    case kTypeValue: {
+        const Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+        value->assign(v.data(), v.size());
+        return true;
+    }
+    case kTypeDeletion:
+        *s = Status::NotFound(Slice());
+        return true;
+    }
+    return false;
 }
 
-} // namespace leveldb.
\ No newline at end of file
+} // namespace leveldb.
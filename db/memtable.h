@@ -4,14 +4,104 @@
 
 #pragma once
 
+#include "db/dbformat.h"
+#include "db/skiplist.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "util/arena.h"
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
 namespace leveldb {
 
+/*
+ * In-memory table of internal entries, kept sorted in a skiplist whose
+ * nodes and entries live in an arena. Each entry is
+ *
+ *    key_size     varint32 of internal_key.size()
+ *    key bytes    char[internal_key.size()]
+ *    value_size   varint32 of value.size()
+ *    value bytes  char[value.size()]
+ *
+ * Reads need no locking. Add() requires external synchronization with
+ * all other writers; AddConcurrently() may run alongside other
+ * AddConcurrently() calls but not alongside Add().
+ */
 class MemTable {
 public:
     explicit MemTable();
     ~MemTable();
+
+    MemTable(const MemTable&) = delete;
+    MemTable& operator=(const MemTable&) = delete;
+
+    // Returns an estimate of the number of bytes of data in use.
+    size_t ApproximateMemoryUsage() const;
+
+    /*
+     * Add an entry into memtable that maps key to value at the
+     * specified sequence number and with the specified type.
+     * Typically value will be empty if type==kTypeDeletion.
+     */
+    void Add(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value);
+
+    void AddConcurrently(SequenceNumber seq, ValueType type, const Slice& key, const Slice& value);
+
+    /*
+     * If memtable contains a value for key as of sequence number "seq",
+     * store it in *value and return true.
+     * If memtable contains a deletion for key, store a NotFound() error
+     * in *status and return true.
+     * Else, return false.
+     */
+    bool Get(const Slice& key, SequenceNumber seq, string *value, Status *s) const;
+
+    class Iterator;
+
 private:
+    struct KeyComparator {
+        int operator()(const char *a, const char *b) const;
+    };
+
+    typedef SkipList<const char *, KeyComparator> Table;
 
+    // Bytes needed for an entry, and its encoding into "buf".
+    static size_t EncodedLength(const Slice& key, const Slice& value);
+    static void Encode(char *buf, SequenceNumber seq, ValueType type,
+                       const Slice& key, const Slice& value);
+
+    Arena _arena;
+    Table _table;
+};
+
+/*
+ * Iterates over the entries of a memtable in internal key order. key()
+ * is the internal key. Entries added while iterating may or may not be
+ * seen. The memtable must outlive the iterator.
+ */
+class MemTable::Iterator {
+public:
+    explicit Iterator(const MemTable *mem) : _iter(&mem->_table) {}
+
+    bool Valid() const {
+        return _iter.Valid();
+    }
+
+    void SeekToFirst() {
+        _iter.SeekToFirst();
+    }
+
+    void Next() {
+        _iter.Next();
+    }
+
+    Slice key() const;
+    Slice value() const;
+
+private:
+    Table::Iterator _iter;
 };
 
-} // namespace leveldb.
\ No newline at end of file
+} // namespace leveldb.
@@ -7,6 +7,7 @@
 #include "util/arena.h"
 #include "util/random.h"
 
+#include <atomic>
 #include <cassert>
 using namespace std;
 
@@ -40,8 +41,18 @@ public:
     }
 
     // Insert key into the list.
+    // REQUIRES: external synchronization with other writers.
     void Insert(const Key& key);
 
+    /*
+     * Like Insert(), but may run concurrently with other
+     * InsertConcurrently() calls (though not with Insert()). Each level
+     * is linked with a compare-and-swap, retried from the last known
+     * predecessor when another insert got there first. Nodes come from
+     * Arena::AllocateAlignedConcurrent().
+     */
+    void InsertConcurrently(const Key& key);
+
     // Returns true iff an entry that compares equal to key is in the list.
     bool Contains(const Key& key) const;
 
@@ -62,6 +73,13 @@ private:
                 _next[n] = val;
             }
 
+            // Links "val" after this node at level n iff the next node
+            // there is still "expected".
+            bool CASNext(int n, Node *expected, Node *val) {
+                assert(n >= 0);
+                return _next[n].compare_exchange_strong(expected, val);
+            }
+
             const Key& GetKey() const {
                 return _key;
             }
@@ -134,7 +152,7 @@ public:
 
 private:
     int GetMaxHeight() const {
-        return _max_height;
+        return _max_height.load(memory_order_relaxed);
     }
 
     bool Equal(const Key& a, const Key& b) const {
@@ -142,8 +160,16 @@ private:
     }
 
     Node *NewNode(const Key& key, int height) const;
+    Node *NewNodeConcurrent(const Key& key, int height) const;
+
+    static int RandomHeight(Random *rnd);
 
-    int RandomHeight();
+    /*
+     * Starting at "before", which comes before key, finds the adjacent
+     * pair of nodes at "level" that key goes between.
+     */
+    void FindSpliceForLevel(const Key& key, Node *before, int level,
+                            Node **out_prev, Node **out_next) const;
 
     // Returns true if key is greater or equal to the data stored in 'node'.
     bool KeyIsAfterNode(const Key& key, Node *node) const {
@@ -175,10 +201,11 @@ private:
     Comparator const _compare;
     Node *const _head;
 
-    // Modified only by Insert(). Read concurrently by readers, but stale vlaues are okay.
-    int _max_height;
+    // Modified only by inserts. Read concurrently by readers, but stale values are okay.
+    atomic<int> _max_height;
 
-    // Read/written only by Insert().
+    // Read/written only by Insert(); InsertConcurrently() uses a
+    // generator per thread.
     Random _rnd;
 };
 
@@ -195,6 +222,14 @@ SkipList<Key, Comparator>::NewNode(const Key& key, int height) const
   return new (node_memory) Node(key);
 }
 
+template <typename Key, class Comparator>
+typename SkipList<Key, Comparator>::Node *
+SkipList<Key, Comparator>::NewNodeConcurrent(const Key& key, int height) const
+{
+    char *node_memory = _arena->AllocateAlignedConcurrent(sizeof(Node) + sizeof(atomic<Node *>) * (height - 1));
+    return new (node_memory) Node(key);
+}
+
 template <typename Key, class Comparator>
 void
 SkipList<Key, Comparator>::Insert(const Key& key)
@@ -204,12 +239,12 @@ SkipList<Key, Comparator>::Insert(const Key& key)
     // Does not allow duplicate insertion.
     assert(node == nullptr || !Equal(node->GetKey(), key));
 
-    int height = RandomHeight();
+    int height = RandomHeight(&_rnd);
     if (height > GetMaxHeight()) {
         for (int i = GetMaxHeight(); i < height; i++) {
             prev[i] = _head;
         }
-        _max_height = height;
+        _max_height.store(height, memory_order_relaxed);
     }
     node = NewNode(key, height);
     for (int i = 0; i < height; i++) {
@@ -218,6 +253,65 @@ SkipList<Key, Comparator>::Insert(const Key& key)
     }
 }
 
+template <typename Key, class Comparator>
+void
+SkipList<Key, Comparator>::InsertConcurrently(const Key& key)
+{
+    static atomic<uint32_t> next_seed(0xdeadbeef);
+    thread_local Random rnd(next_seed.fetch_add(1, memory_order_relaxed));
+    const int height = RandomHeight(&rnd);
+
+    int max_height = GetMaxHeight();
+    while (height > max_height) {
+        if (_max_height.compare_exchange_weak(max_height, height, memory_order_relaxed)) {
+            max_height = height;
+            break;
+        }
+    }
+
+    // Find the splice from the top down, each level starting from the
+    // predecessor found on the level above.
+    Node *prev[kMaxHeight];
+    Node *next[kMaxHeight];
+    Node *before = _head;
+    for (int level = max_height - 1; level >= 0; level--) {
+        FindSpliceForLevel(key, before, level, &prev[level], &next[level]);
+        before = prev[level];
+    }
+    // Does not allow duplicate insertion.
+    assert(next[0] == nullptr || !Equal(next[0]->GetKey(), key));
+
+    // Link bottom up, so that a node reachable at some level is reachable
+    // at every level below it.
+    Node *node = NewNodeConcurrent(key, height);
+    for (int level = 0; level < height; level++) {
+        while (true) {
+            node->SetNext(level, next[level]);
+            if (prev[level]->CASNext(level, next[level], node)) {
+                break;
+            }
+            // Another node went in between; look again from prev[level].
+            FindSpliceForLevel(key, prev[level], level, &prev[level], &next[level]);
+        }
+    }
+}
+
+template <typename Key, class Comparator>
+void
+SkipList<Key, Comparator>::FindSpliceForLevel(const Key& key, Node *before, int level,
+                                              Node **out_prev, Node **out_next) const
+{
+    while (true) {
+        Node *after = before->Next(level);
+        if (!KeyIsAfterNode(key, after)) {
+            *out_prev = before;
+            *out_next = after;
+            return;
+        }
+        before = after;
+    }
+}
+
 template <typename Key, class Comparator>
 bool
 SkipList<Key, Comparator>::Contains(const Key& key) const
@@ -296,12 +390,12 @@ SkipList<Key, Comparator>::FindLast() const
 
 template <typename Key, class Comparator>
 int
-SkipList<Key, Comparator>::RandomHeight() {
+SkipList<Key, Comparator>::RandomHeight(Random *rnd) {
   // Increase height with probability 1 in kBranching.
   static const int kBranching = 4;
   int height = 1;
 
-  while (height < kMaxHeight && _rnd.OneIn(kBranching)) {
+  while (height < kMaxHeight && rnd->OneIn(kBranching)) {
     height++;
   }
 
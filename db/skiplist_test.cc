@@ -3,12 +3,15 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "skiplist.h"
+#include "leveldb/env.h"
 #include "util/testutil.h"
 #include "util/hash.h"
 
 #include <atomic>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -358,13 +361,13 @@ static void RunConcurrent(int run) {
     }
 
     TestState state(seed + 1);
-    Env::Default()->Schedule(ConcurrentReader, &state);
+    ScheduleHandle reader = Env::Default()->ScheduleWithHandle(ConcurrentReader, &state);
     state.Wait(TestState::RUNNING);
     for (int i = 0; i < kSize; i++) {
       state._t.WriteStep(&rnd);
     }
     state._quit_flag = true;
-    state.Wait(TestState::DONE);
+    reader.Wait();
   }
 }
 
@@ -374,4 +377,52 @@ TEST(SkipTest, Concurrent3) { RunConcurrent(3); }
 TEST(SkipTest, Concurrent4) { RunConcurrent(4); }
 TEST(SkipTest, Concurrent5) { RunConcurrent(5); }
 
+// Several threads insert interleaved keys at once while a reader scans.
+TEST(SkipTest, InsertConcurrently)
+{
+    const int kThreads = 4;
+    const int kPerThread = 20000;
+    Arena arena;
+    Comparator cmp;
+    SkipList<Key, Comparator> list(cmp, &arena);
+
+    atomic<bool> done(false);
+    thread reader([&]() {
+        while (!done) {
+            // Whatever is visible is sorted.
+            SkipList<Key, Comparator>::Iterator iter(&list);
+            Key prev = 0;
+            bool first = true;
+            for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+                ASSERT_TRUE(first || prev < iter.GetKey());
+                prev = iter.GetKey();
+                first = false;
+            }
+        }
+    });
+
+    vector<thread> writers;
+    for (int t = 0; t < kThreads; t++) {
+        writers.emplace_back([&list, t]() {
+            for (int i = 0; i < kPerThread; i++) {
+                list.InsertConcurrently(static_cast<Key>(i) * kThreads + t);
+            }
+        });
+    }
+    for (thread& w : writers) {
+        w.join();
+    }
+    done = true;
+    reader.join();
+
+    SkipList<Key, Comparator>::Iterator iter(&list);
+    iter.SeekToFirst();
+    for (Key k = 0; k < static_cast<Key>(kThreads) * kPerThread; k++) {
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(k, iter.GetKey());
+        iter.Next();
+    }
+    ASSERT_FALSE(iter.Valid());
+}
+
 } // namespace leveldb.
\ No newline at end of file
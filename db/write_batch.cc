@@ -0,0 +1,182 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/write_batch.h"
+
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "util/coding.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+
+const size_t WriteBatchInternal::kHeader;
+
+WriteBatch::WriteBatch()
+{
+    Clear();
+}
+
+WriteBatch::~WriteBatch() = default;
+
+WriteBatch::Handler::~Handler() = default;
+
+void
+WriteBatch::Clear()
+{
+    _rep.clear();
+    _rep.resize(WriteBatchInternal::kHeader);
+}
+
+size_t
+WriteBatch::ApproximateSize() const
+{
+    return _rep.size();
+}
+
+Status
+WriteBatch::Iterate(Handler *handler) const
+{
+    Slice input(_rep);
+    if (input.size() < WriteBatchInternal::kHeader) {
+        return Status::Corruption("malformed WriteBatch (too small)");
+    }
+
+    input.remove_prefix(WriteBatchInternal::kHeader);
+    Slice key, value;
+    int found = 0;
+    while (!input.empty()) {
+        found++;
+        const char tag = input[0];
+        input.remove_prefix(1);
+        switch (tag) {
+        case kTypeValue:
+            if (GetLengthPrefixedSlice(&input, &key) && GetLengthPrefixedSlice(&input, &value)) {
+                handler->Put(key, value);
+            } else {
+                return Status::Corruption("bad WriteBatch Put");
+            }
+            break;
+        case kTypeDeletion:
+            if (GetLengthPrefixedSlice(&input, &key)) {
+                handler->Delete(key);
+            } else {
+                return Status::Corruption("bad WriteBatch Delete");
+            }
+            break;
+        default:
+            return Status::Corruption("unknown WriteBatch tag");
+        }
+    }
+    if (found != WriteBatchInternal::Count(this)) {
+        return Status::Corruption("WriteBatch has wrong count");
+    }
+    return Status::OK();
+}
+
+int
+WriteBatchInternal::Count(const WriteBatch *b)
+{
+    return DecodeFixed32(b->_rep.data() + 8);
+}
+
+void
+WriteBatchInternal::SetCount(WriteBatch *b, int n)
+{
+    EncodeFixed32(&b->_rep[8], n);
+}
+
+SequenceNumber
+WriteBatchInternal::Sequence(const WriteBatch *b)
+{
+    return SequenceNumber(DecodeFixed64(b->_rep.data()));
+}
+
+void
+WriteBatchInternal::SetSequence(WriteBatch *b, SequenceNumber seq)
+{
+    EncodeFixed64(&b->_rep[0], seq);
+}
+
+void
+WriteBatch::Put(const Slice& key, const Slice& value)
+{
+    WriteBatchInternal::SetCount(this, WriteBatchInternal::Count(this) + 1);
+    _rep.push_back(static_cast<char>(kTypeValue));
+    PutLengthPrefixedSlice(&_rep, key);
+    PutLengthPrefixedSlice(&_rep, value);
+}
+
+void
+WriteBatch::Delete(const Slice& key)
+{
+    WriteBatchInternal::SetCount(this, WriteBatchInternal::Count(this) + 1);
+    _rep.push_back(static_cast<char>(kTypeDeletion));
+    PutLengthPrefixedSlice(&_rep, key);
+}
+
+void
+WriteBatch::Append(const WriteBatch& source)
+{
+    WriteBatchInternal::Append(this, &source);
+}
+
+namespace {
+
+// Adds each entry to the memtable from the slices into the batch.
+class MemTableInserter : public WriteBatch::Handler {
+public:
+    MemTableInserter(SequenceNumber sequence, MemTable *mem, bool concurrent)
+        : _sequence(sequence), _mem(mem), _concurrent(concurrent) {}
+
+    void Put(const Slice& key, const Slice& value) override {
+        Add(kTypeValue, key, value);
+    }
+
+    void Delete(const Slice& key) override {
+        Add(kTypeDeletion, key, Slice());
+    }
+
+private:
+    void Add(ValueType type, const Slice& key, const Slice& value) {
+        if (_concurrent) {
+            _mem->AddConcurrently(_sequence, type, key, value);
+        } else {
+            _mem->Add(_sequence, type, key, value);
+        }
+        _sequence++;
+    }
+
+    SequenceNumber _sequence;
+    MemTable *const _mem;
+    const bool _concurrent;
+};
+
+} // namespace
+
+Status
+WriteBatchInternal::InsertInto(const WriteBatch *b, MemTable *memtable, bool concurrent)
+{
+    MemTableInserter inserter(WriteBatchInternal::Sequence(b), memtable, concurrent);
+    return b->Iterate(&inserter);
+}
+
+void
+WriteBatchInternal::SetContents(WriteBatch *b, const Slice& contents)
+{
+    assert(contents.size() >= kHeader);
+    b->_rep.assign(contents.data(), contents.size());
+}
+
+void
+WriteBatchInternal::Append(WriteBatch *dst, const WriteBatch *src)
+{
+    SetCount(dst, Count(dst) + Count(src));
+    assert(src->_rep.size() >= kHeader);
+    dst->_rep.append(src->_rep.data() + kHeader, src->_rep.size() - kHeader);
+}
+
+} // namespace leveldb.
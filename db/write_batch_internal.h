@@ -0,0 +1,61 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "db/dbformat.h"
+#include "leveldb/write_batch.h"
+
+#include <cstddef>
+using namespace std;
+
+namespace leveldb {
+
+class MemTable;
+
+/*
+ * WriteBatchInternal provides static methods for manipulating a
+ * WriteBatch that we don't want in the public WriteBatch interface.
+ */
+class WriteBatchInternal {
+public:
+    // Size of the sequence and count that start every batch.
+    static const size_t kHeader = 12;
+
+    // Return the number of entries in the batch.
+    static int Count(const WriteBatch *batch);
+
+    // Set the count for the number of entries in the batch.
+    static void SetCount(WriteBatch *batch, int n);
+
+    // Return the sequence number for the start of this batch.
+    static SequenceNumber Sequence(const WriteBatch *batch);
+
+    // Store the specified number as the sequence number for the start of
+    // this batch.
+    static void SetSequence(WriteBatch *batch, SequenceNumber seq);
+
+    static Slice Contents(const WriteBatch *batch) {
+        return Slice(batch->_rep);
+    }
+
+    static size_t ByteSize(const WriteBatch *batch) {
+        return batch->_rep.size();
+    }
+
+    static void SetContents(WriteBatch *batch, const Slice& contents);
+
+    /*
+     * Inserts the batch's entries into *memtable, numbered from its
+     * sequence number. Keys and values are copied from the batch's
+     * encoding straight into the memtable's arena. With "concurrent",
+     * uses MemTable::AddConcurrently().
+     */
+    static Status InsertInto(const WriteBatch *batch, MemTable *memtable,
+                             bool concurrent = false);
+
+    static void Append(WriteBatch *dst, const WriteBatch *src);
+};
+
+} // namespace leveldb.
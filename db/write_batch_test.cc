@@ -0,0 +1,159 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/write_batch.h"
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+
+#include <string>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+// Lists the batch's updates, numbered from its sequence number.
+static string PrintContents(const WriteBatch *b) {
+    class Printer : public WriteBatch::Handler {
+    public:
+        explicit Printer(SequenceNumber seq) : _seq(seq) {}
+
+        void Put(const Slice& key, const Slice& value) override {
+            _state += "Put(" + key.ToString() + ", " + value.ToString() + ")@" + to_string(_seq++);
+        }
+        void Delete(const Slice& key) override {
+            _state += "Delete(" + key.ToString() + ")@" + to_string(_seq++);
+        }
+
+        string _state;
+        SequenceNumber _seq;
+    };
+
+    Printer printer(WriteBatchInternal::Sequence(b));
+    Status s = b->Iterate(&printer);
+    if (!s.ok()) {
+        printer._state += "ParseError()";
+    }
+    return printer._state;
+}
+
+TEST(WriteBatchTest, Empty)
+{
+    WriteBatch batch;
+    ASSERT_EQ("", PrintContents(&batch));
+    ASSERT_EQ(0, WriteBatchInternal::Count(&batch));
+    ASSERT_EQ(WriteBatchInternal::kHeader, WriteBatchInternal::ByteSize(&batch));
+}
+
+TEST(WriteBatchTest, Multiple)
+{
+    WriteBatch batch;
+    batch.Put(Slice("foo"), Slice("bar"));
+    batch.Delete(Slice("box"));
+    batch.Put(Slice("baz"), Slice("boo"));
+    WriteBatchInternal::SetSequence(&batch, 100);
+    ASSERT_EQ(100, WriteBatchInternal::Sequence(&batch));
+    ASSERT_EQ(3, WriteBatchInternal::Count(&batch));
+    ASSERT_EQ("Put(foo, bar)@100"
+              "Delete(box)@101"
+              "Put(baz, boo)@102",
+              PrintContents(&batch));
+}
+
+TEST(WriteBatchTest, Encoding)
+{
+    WriteBatch batch;
+    batch.Put(Slice("k"), Slice("vv"));
+    batch.Delete(Slice("d"));
+    WriteBatchInternal::SetSequence(&batch, 0x0102030405060708ull);
+
+    const string expected("\x08\x07\x06\x05\x04\x03\x02\x01"  // Sequence.
+                          "\x02\x00\x00\x00"                  // Count.
+                          "\x01\x01k\x02vv"                   // Put.
+                          "\x00\x01" "d",                     // Delete.
+                          12 + 6 + 3);
+    ASSERT_EQ(expected, WriteBatchInternal::Contents(&batch).ToString());
+}
+
+TEST(WriteBatchTest, Corruption)
+{
+    WriteBatch batch;
+    batch.Put(Slice("foo"), Slice("bar"));
+    batch.Delete(Slice("box"));
+    WriteBatchInternal::SetSequence(&batch, 200);
+    Slice contents = WriteBatchInternal::Contents(&batch);
+    WriteBatchInternal::SetContents(&batch, Slice(contents.data(), contents.size() - 1));
+    ASSERT_EQ("Put(foo, bar)@200"
+              "ParseError()",
+              PrintContents(&batch));
+}
+
+TEST(WriteBatchTest, Append)
+{
+    WriteBatch b1, b2;
+    WriteBatchInternal::SetSequence(&b1, 200);
+    WriteBatchInternal::SetSequence(&b2, 300);
+    b1.Append(b2);
+    ASSERT_EQ("", PrintContents(&b1));
+    b2.Put("a", "va");
+    b1.Append(b2);
+    ASSERT_EQ("Put(a, va)@200", PrintContents(&b1));
+    b2.Clear();
+    b2.Put("b", "vb");
+    b1.Append(b2);
+    ASSERT_EQ("Put(a, va)@200"
+              "Put(b, vb)@201",
+              PrintContents(&b1));
+    b2.Delete("foo");
+    b1.Append(b2);
+    ASSERT_EQ("Put(a, va)@200"
+              "Put(b, vb)@201"
+              "Put(b, vb)@202"
+              "Delete(foo)@203",
+              PrintContents(&b1));
+}
+
+TEST(WriteBatchTest, ApproximateSize)
+{
+    WriteBatch batch;
+    size_t empty_size = batch.ApproximateSize();
+
+    batch.Put(Slice("foo"), Slice("bar"));
+    size_t one_key_size = batch.ApproximateSize();
+    ASSERT_LT(empty_size, one_key_size);
+
+    batch.Put(Slice("baz"), Slice("boo"));
+    size_t two_keys_size = batch.ApproximateSize();
+    ASSERT_LT(one_key_size, two_keys_size);
+
+    batch.Delete(Slice("box"));
+    size_t post_delete_size = batch.ApproximateSize();
+    ASSERT_LT(two_keys_size, post_delete_size);
+}
+
+TEST(WriteBatchTest, InsertInto)
+{
+    WriteBatch batch;
+    batch.Put(Slice("foo"), Slice("bar"));
+    batch.Delete(Slice("box"));
+    batch.Put(Slice("box"), Slice("v1"));
+    batch.Put(Slice("box"), Slice("v2"));
+    WriteBatchInternal::SetSequence(&batch, 10);
+
+    MemTable mem;
+    ASSERT_TRUE(WriteBatchInternal::InsertInto(&batch, &mem).ok());
+
+    string value;
+    Status s;
+    ASSERT_TRUE(mem.Get("foo", 13, &value, &s));
+    ASSERT_EQ("bar", value);
+    ASSERT_TRUE(mem.Get("box", 13, &value, &s));
+    ASSERT_EQ("v2", value);
+    ASSERT_TRUE(mem.Get("box", 12, &value, &s));
+    ASSERT_EQ("v1", value);
+    ASSERT_TRUE(mem.Get("box", 11, &value, &s));
+    ASSERT_TRUE(s.IsNotFound());
+    ASSERT_FALSE(mem.Get("foo", 9, &value, &s));
+}
+
+} // namespace leveldb.
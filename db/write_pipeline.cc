@@ -0,0 +1,253 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "write_pipeline.h"
+
+#include "db/log_writer.h"
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "util/mutexlock.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+
+struct WritePipeline::Writer {
+    explicit Writer(port::Mutex *mu) : cv(mu) {}
+
+    WriteBatch *batch;
+    bool sync;
+
+    // Set by the leader that takes this writer into its group, along
+    // with the batch's sequence number.
+    Group *group;
+    Writer *next_member;  // In the same group, or nullptr.
+
+    // The group's log record is written; insert the batch.
+    bool logged;
+
+    // Nothing left to do; return "status".
+    bool done;
+
+    Status status;
+    port::CondVar cv;
+};
+
+struct WritePipeline::Group {
+    SequenceNumber last_sequence;
+
+    // Members that have not finished inserting.
+    size_t pending;
+
+    // All members and all earlier groups are done; the group is off
+    // _groups and its leader may return.
+    bool published;
+};
+
+WritePipeline::WritePipeline(log::Writer *log, MemTable *mem, SequenceNumber last_sequence,
+                             const Options& options)
+    : _log(log),
+      _mem(mem),
+      _options(options),
+      _published_cv(&_mu),
+      _last_sequence(last_sequence),
+      _published_sequence(last_sequence),
+      _stats{0, 0}
+{
+}
+
+WritePipeline::~WritePipeline()
+{
+    MutexLock l(&_mu);
+    assert(_writers.empty());
+    assert(_groups.empty());
+}
+
+void
+WritePipeline::FinishMember(Group *group)
+{
+    assert(group->pending > 0);
+    group->pending--;
+
+    // Publish the groups that are done, up to the first that is not.
+    bool published = false;
+    while (!_groups.empty() && _groups.front()->pending == 0) {
+        _published_sequence = _groups.front()->last_sequence;
+        _groups.front()->published = true;
+        _groups.pop_front();
+        published = true;
+    }
+    if (published) {
+        _published_cv.SignalAll();
+    }
+}
+
+Status
+WritePipeline::Write(WriteBatch *batch, bool sync)
+{
+    Writer w(&_mu);
+    w.batch = batch;
+    w.sync = sync;
+    w.group = nullptr;
+    w.next_member = nullptr;
+    w.logged = false;
+    w.done = false;
+
+    MutexLock l(&_mu);
+    _stats.writes++;
+    _writers.push_back(&w);
+    while (!w.done && !w.logged && !(w.group == nullptr && &w == _writers.front())) {
+        w.cv.Wait();
+    }
+    if (w.done) {
+        return w.status;
+    }
+
+    if (w.logged) {
+        // A member: the leader wrote our batch to the log.
+        Group *const group = w.group;
+        const SequenceNumber last_sequence = group->last_sequence;
+        _mu.Unlock();
+        Status s = WriteBatchInternal::InsertInto(w.batch, _mem, true);
+        _mu.Lock();
+        FinishMember(group);
+
+        // The leader may free "group" from here on.
+        while (_published_sequence < last_sequence) {
+            _published_cv.Wait();
+        }
+        return s;
+    }
+
+    // The leader.
+    if (!_error.ok()) {
+        _writers.pop_front();
+        if (!_writers.empty()) {
+            _writers.front()->cv.Signal();
+        }
+        return _error;
+    }
+
+    /*
+     * Take the writers queued behind us, up to the size limit. A sync
+     * write does not join a group that would not sync.
+     */
+    Group group;
+    size_t members = 0;
+    size_t bytes = 0;
+    Writer *last = nullptr;
+    for (Writer *m : _writers) {
+        if (m != &w) {
+            if (m->sync && !w.sync) {
+                break;
+            }
+            if (bytes > _options.max_group_bytes) {
+                break;
+            }
+        }
+        m->group = &group;
+        WriteBatchInternal::SetSequence(m->batch, _last_sequence + 1);
+        _last_sequence += WriteBatchInternal::Count(m->batch);
+        if (last != nullptr) {
+            last->next_member = m;
+        }
+        last = m;
+        members++;
+        bytes += WriteBatchInternal::ByteSize(m->batch);
+    }
+    group.last_sequence = _last_sequence;
+    group.pending = members;
+    group.published = false;
+    _stats.groups++;
+
+    /*
+     * Log the whole group as one record. The members only wait, so the
+     * list through next_member and their batches are stable without the
+     * lock.
+     */
+    _mu.Unlock();
+    const WriteBatch *record = w.batch;
+    if (w.next_member != nullptr) {
+        _group_batch.Clear();
+        WriteBatchInternal::SetSequence(&_group_batch, WriteBatchInternal::Sequence(w.batch));
+        for (const Writer *m = &w; m != nullptr; m = m->next_member) {
+            WriteBatchInternal::Append(&_group_batch, m->batch);
+        }
+        record = &_group_batch;
+    }
+    Status s = _log->AddRecord(WriteBatchInternal::Contents(record));
+    if (s.ok()) {
+        s = sync ? _log->Sync() : _log->Flush();
+    }
+    const bool log_error = !s.ok();
+    if (s.ok() && !_options.concurrent_memtable_writes) {
+        s = WriteBatchInternal::InsertInto(record, _mem, false);
+    }
+    _mu.Lock();
+    if (log_error) {
+        _error = s;
+    }
+
+    // Hand the front of the queue to the next leader.
+    for (size_t i = 0; i < members; i++) {
+        _writers.pop_front();
+    }
+    if (!_writers.empty()) {
+        _writers.front()->cv.Signal();
+    }
+
+    if (log_error || !_options.concurrent_memtable_writes) {
+        if (!log_error) {
+            assert(_groups.empty());
+            _published_sequence = group.last_sequence;
+        }
+        for (Writer *m = w.next_member; m != nullptr; m = m->next_member) {
+            m->status = s;
+            m->done = true;
+            m->cv.Signal();
+        }
+        return s;
+    }
+
+    /*
+     * Queued after the log write, so groups are published in log order
+     * whichever finishes inserting first.
+     */
+    _groups.push_back(&group);
+    for (Writer *m = w.next_member; m != nullptr; m = m->next_member) {
+        m->logged = true;
+        m->cv.Signal();
+    }
+    _mu.Unlock();
+    s = WriteBatchInternal::InsertInto(w.batch, _mem, true);
+    _mu.Lock();
+    FinishMember(&group);
+
+    /*
+     * Wait for the group itself rather than its sequence number: a group
+     * of empty batches ends at an already published one, and must not
+     * go away while its members still have to finish.
+     */
+    while (!group.published) {
+        _published_cv.Wait();
+    }
+    return s;
+}
+
+SequenceNumber
+WritePipeline::LastSequence() const
+{
+    MutexLock l(&_mu);
+    return _published_sequence;
+}
+
+WritePipeline::Stats
+WritePipeline::GetStats() const
+{
+    MutexLock l(&_mu);
+    return _stats;
+}
+
+} // namespace leveldb.
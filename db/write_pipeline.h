@@ -0,0 +1,131 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "db/dbformat.h"
+#include "leveldb/status.h"
+#include "leveldb/write_batch.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+using namespace std;
+
+namespace leveldb {
+
+class MemTable;
+
+namespace log {
+class Writer;
+}
+
+/*
+ * Applies updates from many threads to a log and a memtable.
+ *
+ * Writers queue up, and the one at the front leads a group: it takes
+ * the writers queued behind it, assigns their sequence numbers, and
+ * appends all their batches to the log as one record with one flush or
+ * sync. A group of one logs its batch's own encoding. Then it hands the
+ * front of the queue to the next leader, and every member of the group
+ * inserts its own updates into the memtable, in parallel through
+ * MemTable::AddConcurrently(). The next group's log write thus overlaps
+ * this group's inserts.
+ *
+ * Groups may finish their inserts out of order, but become visible in
+ * order: a write returns once its group and all earlier ones are fully
+ * in the memtable, and LastSequence() only covers such groups.
+ *
+ * With "concurrent_memtable_writes" off, the leader inserts the whole
+ * group with MemTable::Add() before handing over, so log writes and
+ * inserts are serialized as in a single-writer design.
+ *
+ * A failed log write is sticky: it fails that group and every later
+ * write.
+ *
+ * Thread-safe.
+ */
+class WritePipeline {
+public:
+    struct Options {
+        // Members insert their own updates in parallel.
+        bool concurrent_memtable_writes = true;
+
+        // A group stops taking writers once its log record exceeds this
+        // size.
+        size_t max_group_bytes = 1 << 20;
+    };
+
+    // Counters since construction.
+    struct Stats {
+        uint64_t writes;  // Calls to Write().
+        uint64_t groups;  // Log records written on their behalf.
+    };
+
+    /*
+     * "*log" and "*mem" must remain live while this WritePipeline is in
+     * use and must not be written by anyone else. Sequence numbers
+     * continue from "last_sequence".
+     */
+    WritePipeline(log::Writer *log, MemTable *mem, SequenceNumber last_sequence,
+                  const Options& options);
+
+    WritePipeline(const WritePipeline&) = delete;
+    WritePipeline& operator=(const WritePipeline&) = delete;
+
+    ~WritePipeline();
+
+    /*
+     * Applies the updates of *batch with consecutive sequence numbers,
+     * which are stored in the batch. If "sync" is true, the log is synced
+     * before the updates are applied.
+     */
+    Status Write(WriteBatch *batch, bool sync);
+
+    // The sequence number of the last update visible in the memtable.
+    SequenceNumber LastSequence() const;
+
+    Stats GetStats() const;
+
+private:
+    struct Writer;
+    struct Group;
+
+    // Marks one member of *group done and publishes the finished groups.
+    void FinishMember(Group *group) EXCLUSIVE_LOCKS_REQUIRED(_mu);
+
+    log::Writer *const _log;
+    MemTable *const _mem;
+    const Options _options;
+
+    mutable port::Mutex _mu;
+
+    // Signaled whenever _published_sequence advances.
+    port::CondVar _published_cv;
+
+    // Writers waiting to join a group, oldest first.
+    deque<Writer *> _writers GUARDED_BY(_mu);
+
+    // Groups whose updates are not all visible yet, oldest first.
+    deque<Group *> _groups GUARDED_BY(_mu);
+
+    // The last sequence number handed out.
+    SequenceNumber _last_sequence GUARDED_BY(_mu);
+
+    // The last sequence number of the last visible group.
+    SequenceNumber _published_sequence GUARDED_BY(_mu);
+
+    // The first failed log write, returned to every later write.
+    Status _error GUARDED_BY(_mu);
+
+    // The batches of the group being logged, when it has several; only
+    // touched by its leader.
+    WriteBatch _group_batch;
+
+    Stats _stats GUARDED_BY(_mu);
+};
+
+} // namespace leveldb.
@@ -0,0 +1,249 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "write_pipeline.h"
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "db/memtable.h"
+#include "db/write_batch_internal.h"
+#include "leveldb/env.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+class StringDest : public WritableFile {
+public:
+    Status Close() override {
+        return Status::OK();
+    }
+    Status Flush() override {
+        return Status::OK();
+    }
+    Status Sync() override {
+        _syncs++;
+        return Status::OK();
+    }
+    Status Append(const Slice& slice) override {
+        if (_fail) {
+            return Status::IOError("append failed");
+        }
+        _contents.append(slice.data(), slice.size());
+        return Status::OK();
+    }
+
+    string _contents;
+    int _syncs = 0;
+    bool _fail = false;
+};
+
+class StringSource : public SequentialFile {
+public:
+    explicit StringSource(const Slice& contents) : _contents(contents) {}
+
+    Status Read(size_t n, Slice *result, char *scratch) override {
+        n = min(n, _contents.size());
+        memcpy(scratch, _contents.data(), n);
+        *result = Slice(scratch, n);
+        _contents.remove_prefix(n);
+        return Status::OK();
+    }
+    Status Skip(uint64_t n) override {
+        _contents.remove_prefix(min<uint64_t>(n, _contents.size()));
+        return Status::OK();
+    }
+
+private:
+    Slice _contents;
+};
+
+static string Key(int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+}
+
+static string Get(const MemTable& mem, const string& key, SequenceNumber seq) {
+    string value;
+    Status s;
+    if (!mem.Get(key, seq, &value, &s)) {
+        return "NOT_FOUND";
+    }
+    if (s.IsNotFound()) {
+        return "DELETED";
+    }
+    return value;
+}
+
+TEST(WritePipelineTest, WriteAndGet)
+{
+    StringDest dest;
+    log::Writer log(&dest);
+    MemTable mem;
+    WritePipeline pipeline(&log, &mem, 100, WritePipeline::Options());
+
+    WriteBatch batch;
+    batch.Put("a", "1");
+    batch.Put("b", "2");
+    ASSERT_TRUE(pipeline.Write(&batch, false).ok());
+    ASSERT_EQ(101, WriteBatchInternal::Sequence(&batch));
+    ASSERT_EQ(102, pipeline.LastSequence());
+
+    WriteBatch overwrite;
+    overwrite.Put("a", "3");
+    overwrite.Delete("b");
+    ASSERT_TRUE(pipeline.Write(&overwrite, true).ok());
+    ASSERT_EQ(104, pipeline.LastSequence());
+    ASSERT_EQ(1, dest._syncs);
+
+    ASSERT_EQ("3", Get(mem, "a", 104));
+    ASSERT_EQ("DELETED", Get(mem, "b", 104));
+    ASSERT_EQ("1", Get(mem, "a", 102));
+    ASSERT_EQ("2", Get(mem, "b", 103));
+    ASSERT_EQ("NOT_FOUND", Get(mem, "a", 100));
+    ASSERT_EQ("NOT_FOUND", Get(mem, "c", 104));
+
+    // A write on its own logs its batch as is.
+    StringSource source(dest._contents);
+    log::Reader reader(&source, nullptr, true, 0);
+    Slice record;
+    string scratch;
+    ASSERT_TRUE(reader.ReadRecord(&record, &scratch));
+    ASSERT_EQ(WriteBatchInternal::Contents(&batch), record);
+    ASSERT_TRUE(reader.ReadRecord(&record, &scratch));
+    ASSERT_EQ(WriteBatchInternal::Contents(&overwrite), record);
+    ASSERT_FALSE(reader.ReadRecord(&record, &scratch));
+}
+
+static void ConcurrentWrites(bool concurrent_memtable_writes)
+{
+    const int kThreads = 4;
+    const int kWrites = 500;
+
+    StringDest dest;
+    log::Writer log(&dest);
+    MemTable mem;
+    WritePipeline::Options options;
+    options.concurrent_memtable_writes = concurrent_memtable_writes;
+    WritePipeline pipeline(&log, &mem, 0, options);
+
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kWrites; i++) {
+                const string key = Key(i * kThreads + t);
+                const string value = key + "-value";
+                WriteBatch batch;
+                batch.Put(key, value);
+                ASSERT_TRUE(pipeline.Write(&batch, i % 50 == 0).ok());
+
+                // A returned write is visible.
+                const SequenceNumber seq = pipeline.LastSequence();
+                ASSERT_EQ(value, Get(mem, key, seq));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(kThreads * kWrites, pipeline.LastSequence());
+    for (int i = 0; i < kThreads * kWrites; i++) {
+        ASSERT_EQ(Key(i) + "-value", Get(mem, Key(i), kThreads * kWrites));
+    }
+
+    // Every sequence number is logged exactly once, in order.
+    const WritePipeline::Stats stats = pipeline.GetStats();
+    ASSERT_EQ(kThreads * kWrites, stats.writes);
+    StringSource source(dest._contents);
+    log::Reader reader(&source, nullptr, true, 0);
+    Slice record;
+    string scratch;
+    uint64_t records = 0;
+    SequenceNumber next = 1;
+    WriteBatch batch;
+    while (reader.ReadRecord(&record, &scratch)) {
+        WriteBatchInternal::SetContents(&batch, record);
+        ASSERT_EQ(next, WriteBatchInternal::Sequence(&batch));
+        next += WriteBatchInternal::Count(&batch);
+        records++;
+    }
+    ASSERT_EQ(kThreads * kWrites + 1, next);
+    ASSERT_EQ(stats.groups, records);
+}
+
+TEST(WritePipelineTest, ConcurrentWriters)
+{
+    ConcurrentWrites(true);
+}
+
+TEST(WritePipelineTest, ConcurrentWritersSerialInserts)
+{
+    ConcurrentWrites(false);
+}
+
+TEST(WritePipelineTest, ConcurrentEmptyBatches)
+{
+    const int kThreads = 4;
+    const int kWrites = 500;
+
+    StringDest dest;
+    log::Writer log(&dest);
+    MemTable mem;
+    WritePipeline pipeline(&log, &mem, 0, WritePipeline::Options());
+
+    // Groups made up only of empty batches end at an already published
+    // sequence number.
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kWrites; i++) {
+                WriteBatch empty;
+                ASSERT_TRUE(pipeline.Write(&empty, true).ok());
+            }
+        });
+    }
+    for (int i = 0; i < kWrites; i++) {
+        WriteBatch batch;
+        batch.Put(Key(i), "value");
+        ASSERT_TRUE(pipeline.Write(&batch, true).ok());
+        ASSERT_EQ("value", Get(mem, Key(i), pipeline.LastSequence()));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(kWrites, pipeline.LastSequence());
+    ASSERT_EQ((kThreads + 1) * kWrites, pipeline.GetStats().writes);
+}
+
+TEST(WritePipelineTest, LogErrorIsSticky)
+{
+    StringDest dest;
+    log::Writer log(&dest);
+    MemTable mem;
+    WritePipeline pipeline(&log, &mem, 0, WritePipeline::Options());
+
+    WriteBatch batch;
+    batch.Put("a", "1");
+    ASSERT_TRUE(pipeline.Write(&batch, false).ok());
+
+    dest._fail = true;
+    batch.Clear();
+    batch.Put("a", "2");
+    ASSERT_TRUE(pipeline.Write(&batch, false).IsIOError());
+    dest._fail = false;
+    ASSERT_TRUE(pipeline.Write(&batch, false).IsIOError());
+
+    ASSERT_EQ(1, pipeline.LastSequence());
+    ASSERT_EQ("1", Get(mem, "a", kMaxSequenceNumber));
+}
+
+} // namespace leveldb.
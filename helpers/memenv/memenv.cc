@@ -0,0 +1,389 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "helpers/memenv/memenv.h"
+
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+#include "port/thread_annotations.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace leveldb {
+
+namespace {
+
+/*
+ * File contents are stored in chunks of this size. Larger chunks mean more
+ * reads can be served without copying, at the cost of memory for small
+ * files.
+ */
+static const size_t kChunkSize = 64 * 1024;
+
+/*
+ * The contents of one file, shared by the Env's file table and every open
+ * file object through a reference count.
+ *
+ * Bytes below Size() are never modified and chunks are only released
+ * when the last reference goes away, so a reader holding a reference may
+ * keep pointing into them without the lock.
+ */
+class FileState {
+public:
+    // FileStates are reference counted. The initial reference count is zero
+    // and the caller must call Ref() at least once.
+    FileState() : _refs(0), _size(0) {}
+
+    FileState(const FileState&) = delete;
+    FileState& operator=(const FileState&) = delete;
+
+    // Increase the reference count.
+    void Ref() {
+        _refs.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Decrease the reference count. Delete if this is the last reference.
+    void Unref() {
+        if (_refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    uint64_t Size() const {
+        lock_guard<mutex> lk(_mu);
+        return _size;
+    }
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const {
+        lock_guard<mutex> lk(_mu);
+        if (offset > _size) {
+            return Status::IOError("Offset greater than file size.");
+        }
+        const uint64_t available = _size - offset;
+        if (n > available) {
+            n = static_cast<size_t>(available);
+        }
+        if (n == 0) {
+            *result = Slice();
+            return Status::OK();
+        }
+
+        size_t chunk = static_cast<size_t>(offset / kChunkSize);
+        size_t chunk_offset = offset % kChunkSize;
+        if (chunk_offset + n <= kChunkSize) {
+            // Zero-copy: the whole range lives in one chunk.
+            *result = Slice(_chunks[chunk] + chunk_offset, n);
+            return Status::OK();
+        }
+
+        // The range straddles chunks; stitch it together in scratch.
+        size_t bytes_to_copy = n;
+        char *dst = scratch;
+        while (bytes_to_copy > 0) {
+            size_t avail = kChunkSize - chunk_offset;
+            if (avail > bytes_to_copy) {
+                avail = bytes_to_copy;
+            }
+            memcpy(dst, _chunks[chunk] + chunk_offset, avail);
+
+            bytes_to_copy -= avail;
+            dst += avail;
+            chunk++;
+            chunk_offset = 0;
+        }
+
+        *result = Slice(scratch, n);
+        return Status::OK();
+    }
+
+    Status Append(const Slice& data) {
+        const char *src = data.data();
+        size_t src_len = data.size();
+
+        lock_guard<mutex> lk(_mu);
+        while (src_len > 0) {
+            size_t avail;
+            size_t offset = _size % kChunkSize;
+
+            if (offset != 0) {
+                // There is some room in the last chunk.
+                avail = kChunkSize - offset;
+            } else {
+                // No room in the last chunk; push new one.
+                _chunks.push_back(new char[kChunkSize]);
+                avail = kChunkSize;
+            }
+
+            if (avail > src_len) {
+                avail = src_len;
+            }
+            memcpy(_chunks.back() + offset, src, avail);
+            src_len -= avail;
+            src += avail;
+            _size += avail;
+        }
+
+        return Status::OK();
+    }
+
+private:
+    // Private since only Unref() should be used to delete it.
+    ~FileState() {
+        for (char *chunk : _chunks) {
+            delete[] chunk;
+        }
+    }
+
+    atomic<int> _refs;
+
+    mutable mutex _mu;
+    vector<char *> _chunks GUARDED_BY(_mu);
+    uint64_t _size GUARDED_BY(_mu);
+};
+
+class SequentialFileImpl : public SequentialFile {
+public:
+    explicit SequentialFileImpl(FileState *file) : _file(file), _pos(0) {
+        _file->Ref();
+    }
+
+    ~SequentialFileImpl() override {
+        _file->Unref();
+    }
+
+    Status Read(size_t n, Slice *result, char *scratch) override {
+        Status s = _file->Read(_pos, n, result, scratch);
+        if (s.ok()) {
+            _pos += result->size();
+        }
+        return s;
+    }
+
+    Status Skip(uint64_t n) override {
+        if (_pos > _file->Size()) {
+            return Status::IOError("_pos > _file->Size()");
+        }
+        const uint64_t available = _file->Size() - _pos;
+        if (n > available) {
+            n = available;
+        }
+        _pos += n;
+        return Status::OK();
+    }
+
+private:
+    FileState *_file;
+    uint64_t _pos;
+};
+
+class RandomAccessFileImpl : public RandomAccessFile {
+public:
+    explicit RandomAccessFileImpl(FileState *file) : _file(file) {
+        _file->Ref();
+    }
+
+    ~RandomAccessFileImpl() override {
+        _file->Unref();
+    }
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+        return _file->Read(offset, n, result, scratch);
+    }
+
+private:
+    FileState *_file;
+};
+
+class WritableFileImpl : public WritableFile {
+public:
+    explicit WritableFileImpl(FileState *file) : _file(file) {
+        _file->Ref();
+    }
+
+    ~WritableFileImpl() override {
+        _file->Unref();
+    }
+
+    Status Append(const Slice& data) override {
+        return _file->Append(data);
+    }
+
+    Status Close() override {
+        return Status::OK();
+    }
+
+    Status Flush() override {
+        return Status::OK();
+    }
+
+    Status Sync() override {
+        return Status::OK();
+    }
+
+private:
+    FileState *_file;
+};
+
+class InMemoryEnv : public EnvWrapper {
+public:
+    explicit InMemoryEnv(Env *base_env) : EnvWrapper(base_env) {}
+
+    ~InMemoryEnv() override {
+        for (const auto& kvp : _file_map) {
+            kvp.second->Unref();
+        }
+    }
+
+    // Partial implementation of the Env interface.
+    Status NewSequentialFile(const string& fname, SequentialFile **result) override {
+        lock_guard<mutex> lk(_mu);
+        if (_file_map.find(fname) == _file_map.end()) {
+            *result = nullptr;
+            return Status::IOError(fname, "File not found");
+        }
+
+        *result = new SequentialFileImpl(_file_map[fname]);
+        return Status::OK();
+    }
+
+    Status NewRandomAccessFile(const string& fname, RandomAccessFile **result) override {
+        lock_guard<mutex> lk(_mu);
+        if (_file_map.find(fname) == _file_map.end()) {
+            *result = nullptr;
+            return Status::IOError(fname, "File not found");
+        }
+
+        *result = new RandomAccessFileImpl(_file_map[fname]);
+        return Status::OK();
+    }
+
+    /*
+     * An existing file is replaced by a new, empty one rather than truncated
+     * in place, so that readers still holding the old contents (and slices
+     * into them) are left undisturbed.
+     */
+    Status NewWritableFile(const string& fname, WritableFile **result) override {
+        lock_guard<mutex> lk(_mu);
+        FileSystem::iterator it = _file_map.find(fname);
+
+        FileState *file = new FileState();
+        file->Ref();
+        if (it != _file_map.end()) {
+            it->second->Unref();
+            it->second = file;
+        } else {
+            _file_map[fname] = file;
+        }
+
+        *result = new WritableFileImpl(file);
+        return Status::OK();
+    }
+
+    Status NewAppendableFile(const string& fname, WritableFile **result) override {
+        lock_guard<mutex> lk(_mu);
+        FileState **sptr = &_file_map[fname];
+        FileState *file = *sptr;
+        if (file == nullptr) {
+            file = new FileState();
+            file->Ref();
+            *sptr = file;
+        }
+        *result = new WritableFileImpl(file);
+        return Status::OK();
+    }
+
+    bool FileExists(const string& fname) override {
+        lock_guard<mutex> lk(_mu);
+        return _file_map.find(fname) != _file_map.end();
+    }
+
+    Status GetChildren(const string& dir, vector<string> *result) override {
+        lock_guard<mutex> lk(_mu);
+        result->clear();
+
+        for (const auto& kvp : _file_map) {
+            const string& filename = kvp.first;
+
+            if (filename.size() >= dir.size() + 1 && filename[dir.size()] == '/' &&
+                Slice(filename).starts_with(Slice(dir))) {
+                result->push_back(filename.substr(dir.size() + 1));
+            }
+        }
+
+        return Status::OK();
+    }
+
+    Status RemoveFile(const string& fname) override {
+        lock_guard<mutex> lk(_mu);
+        if (_file_map.find(fname) == _file_map.end()) {
+            return Status::IOError(fname, "File not found");
+        }
+
+        RemoveFileInternal(fname);
+        return Status::OK();
+    }
+
+    Status CreateDir(const string& dirname) override {
+        return Status::OK();
+    }
+
+    Status RemoveDir(const string& dirname) override {
+        return Status::OK();
+    }
+
+    Status GetFileSize(const string& fname, uint64_t *file_size) override {
+        lock_guard<mutex> lk(_mu);
+        if (_file_map.find(fname) == _file_map.end()) {
+            return Status::IOError(fname, "File not found");
+        }
+
+        *file_size = _file_map[fname]->Size();
+        return Status::OK();
+    }
+
+    Status RenameFile(const string& src, const string& target) override {
+        lock_guard<mutex> lk(_mu);
+        if (_file_map.find(src) == _file_map.end()) {
+            return Status::IOError(src, "File not found");
+        }
+
+        RemoveFileInternal(target);
+        _file_map[target] = _file_map[src];
+        _file_map.erase(src);
+        return Status::OK();
+    }
+
+private:
+    // Map from filenames to FileState objects, representing a simple file system.
+    typedef map<string, FileState *> FileSystem;
+
+    void RemoveFileInternal(const string& fname) {
+        if (_file_map.find(fname) == _file_map.end()) {
+            return;
+        }
+
+        _file_map[fname]->Unref();
+        _file_map.erase(fname);
+    }
+
+    mutex _mu;
+    FileSystem _file_map GUARDED_BY(_mu);
+};
+
+} // namespace
+
+Env *
+NewMemEnv(Env *base_env)
+{
+    return new InMemoryEnv(base_env);
+}
+
+} // namespace leveldb.
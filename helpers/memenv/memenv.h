@@ -0,0 +1,25 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+namespace leveldb {
+
+class Env;
+
+/*
+ * Returns a new environment that stores its data in memory and delegates
+ * all non-file-storage tasks (scheduling, clock, sleeping) to base_env.
+ *
+ * File contents live in reference counted chunks. Reads that fall inside
+ * one chunk return a Slice pointing straight into it instead of copying
+ * into the caller's scratch buffer; such a Slice stays valid as long as
+ * the file object it was read from.
+ *
+ * The caller must delete the result when it is no longer needed.
+ * *base_env must remain live while the result is in use.
+ */
+Env *NewMemEnv(Env *base_env);
+
+} // namespace leveldb.
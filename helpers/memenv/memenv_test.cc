@@ -0,0 +1,288 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "helpers/memenv/memenv.h"
+
+#include "leveldb/env.h"
+#include "util/random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+class MemEnvTest : public testing::Test {
+public:
+    MemEnvTest() : _env(NewMemEnv(Env::Default())) {}
+
+    ~MemEnvTest() {
+        delete _env;
+    }
+
+    Env *_env;
+};
+
+TEST_F(MemEnvTest, Basics) {
+    uint64_t file_size;
+    WritableFile *writable_file;
+    vector<string> children;
+
+    ASSERT_TRUE(_env->CreateDir("/dir").ok());
+
+    // Check that the directory is empty.
+    ASSERT_TRUE(!_env->FileExists("/dir/non_existent"));
+    ASSERT_TRUE(!_env->GetFileSize("/dir/non_existent", &file_size).ok());
+    ASSERT_TRUE(_env->GetChildren("/dir", &children).ok());
+    ASSERT_EQ(0, children.size());
+
+    // Create a file.
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(_env->GetFileSize("/dir/f", &file_size).ok());
+    ASSERT_EQ(0, file_size);
+    delete writable_file;
+
+    // Check that the file exists.
+    ASSERT_TRUE(_env->FileExists("/dir/f"));
+    ASSERT_TRUE(_env->GetFileSize("/dir/f", &file_size).ok());
+    ASSERT_EQ(0, file_size);
+    ASSERT_TRUE(_env->GetChildren("/dir", &children).ok());
+    ASSERT_EQ(1, children.size());
+    ASSERT_EQ("f", children[0]);
+
+    // Write to the file.
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append("abc").ok());
+    delete writable_file;
+
+    // Check that append works.
+    ASSERT_TRUE(_env->NewAppendableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(_env->GetFileSize("/dir/f", &file_size).ok());
+    ASSERT_EQ(3, file_size);
+    ASSERT_TRUE(writable_file->Append("hello").ok());
+    delete writable_file;
+
+    // Check for expected size.
+    ASSERT_TRUE(_env->GetFileSize("/dir/f", &file_size).ok());
+    ASSERT_EQ(8, file_size);
+
+    // Check that renaming works.
+    ASSERT_TRUE(!_env->RenameFile("/dir/non_existent", "/dir/g").ok());
+    ASSERT_TRUE(_env->RenameFile("/dir/f", "/dir/g").ok());
+    ASSERT_TRUE(!_env->FileExists("/dir/f"));
+    ASSERT_TRUE(_env->FileExists("/dir/g"));
+    ASSERT_TRUE(_env->GetFileSize("/dir/g", &file_size).ok());
+    ASSERT_EQ(8, file_size);
+
+    // Check that opening non-existent file fails.
+    SequentialFile *seq_file;
+    RandomAccessFile *rand_file;
+    ASSERT_TRUE(!_env->NewSequentialFile("/dir/non_existent", &seq_file).ok());
+    ASSERT_TRUE(!seq_file);
+    ASSERT_TRUE(!_env->NewRandomAccessFile("/dir/non_existent", &rand_file).ok());
+    ASSERT_TRUE(!rand_file);
+
+    // Check that deleting works.
+    ASSERT_TRUE(!_env->RemoveFile("/dir/non_existent").ok());
+    ASSERT_TRUE(_env->RemoveFile("/dir/g").ok());
+    ASSERT_TRUE(!_env->FileExists("/dir/g"));
+    ASSERT_TRUE(_env->GetChildren("/dir", &children).ok());
+    ASSERT_EQ(0, children.size());
+    ASSERT_TRUE(_env->RemoveDir("/dir").ok());
+}
+
+TEST_F(MemEnvTest, ReadWrite) {
+    WritableFile *writable_file;
+    SequentialFile *seq_file;
+    RandomAccessFile *rand_file;
+    Slice result;
+    char scratch[100];
+
+    ASSERT_TRUE(_env->CreateDir("/dir").ok());
+
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append("hello ").ok());
+    ASSERT_TRUE(writable_file->Append("world").ok());
+    delete writable_file;
+
+    // Read sequentially.
+    ASSERT_TRUE(_env->NewSequentialFile("/dir/f", &seq_file).ok());
+    ASSERT_TRUE(seq_file->Read(5, &result, scratch).ok());  // Read "hello".
+    ASSERT_EQ(0, result.compare("hello"));
+    ASSERT_TRUE(seq_file->Skip(1).ok());
+    ASSERT_TRUE(seq_file->Read(1000, &result, scratch).ok());  // Read "world".
+    ASSERT_EQ(0, result.compare("world"));
+    ASSERT_TRUE(seq_file->Read(1000, &result, scratch).ok());  // Try reading past EOF.
+    ASSERT_EQ(0, result.size());
+    ASSERT_TRUE(seq_file->Skip(100).ok());  // Try to skip past end of file.
+    ASSERT_TRUE(seq_file->Read(1000, &result, scratch).ok());
+    ASSERT_EQ(0, result.size());
+    delete seq_file;
+
+    // Random reads.
+    ASSERT_TRUE(_env->NewRandomAccessFile("/dir/f", &rand_file).ok());
+    ASSERT_TRUE(rand_file->Read(6, 5, &result, scratch).ok());  // Read "world".
+    ASSERT_EQ(0, result.compare("world"));
+    ASSERT_TRUE(rand_file->Read(0, 5, &result, scratch).ok());  // Read "hello".
+    ASSERT_EQ(0, result.compare("hello"));
+    ASSERT_TRUE(rand_file->Read(10, 100, &result, scratch).ok());  // Read "d".
+    ASSERT_EQ(0, result.compare("d"));
+
+    // Too high offset.
+    ASSERT_TRUE(!rand_file->Read(1000, 5, &result, scratch).ok());
+    delete rand_file;
+}
+
+TEST_F(MemEnvTest, LargeWrite) {
+    const size_t kWriteSize = 300 * 1024;
+    char *scratch = new char[kWriteSize * 2];
+
+    string write_data;
+    for (size_t i = 0; i < kWriteSize; ++i) {
+        write_data.append(1, static_cast<char>(i));
+    }
+
+    WritableFile *writable_file;
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append("foo").ok());
+    ASSERT_TRUE(writable_file->Append(write_data).ok());
+    delete writable_file;
+
+    SequentialFile *seq_file;
+    Slice result;
+    ASSERT_TRUE(_env->NewSequentialFile("/dir/f", &seq_file).ok());
+    ASSERT_TRUE(seq_file->Read(3, &result, scratch).ok());  // Read "foo".
+    ASSERT_EQ(0, result.compare("foo"));
+
+    size_t read = 0;
+    string read_data;
+    while (read < kWriteSize) {
+        ASSERT_TRUE(seq_file->Read(kWriteSize - read, &result, scratch).ok());
+        read_data.append(result.data(), result.size());
+        read += result.size();
+    }
+    ASSERT_TRUE(write_data == read_data);
+    delete seq_file;
+    delete[] scratch;
+}
+
+TEST_F(MemEnvTest, ZeroCopyReads) {
+    WritableFile *writable_file;
+    RandomAccessFile *rand_file;
+    char scratch[100];
+    Slice result;
+
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append(string(100 * 1024, 'x')).ok());
+    delete writable_file;
+
+    ASSERT_TRUE(_env->NewRandomAccessFile("/dir/f", &rand_file).ok());
+
+    // A read inside one chunk points into the file, not into scratch.
+    ASSERT_TRUE(rand_file->Read(10, 50, &result, scratch).ok());
+    ASSERT_EQ(50, result.size());
+    ASSERT_TRUE(result.data() < scratch || result.data() >= scratch + sizeof(scratch));
+
+    // A read across a chunk boundary is copied into scratch.
+    ASSERT_TRUE(rand_file->Read(64 * 1024 - 10, 20, &result, scratch).ok());
+    ASSERT_EQ(scratch, result.data());
+    ASSERT_EQ(string(20, 'x'), result.ToString());
+
+    // Recreating the file leaves the old contents intact for open readers.
+    ASSERT_TRUE(rand_file->Read(0, 5, &result, scratch).ok());
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append("yyyyy").ok());
+    delete writable_file;
+    ASSERT_EQ("xxxxx", result.ToString());
+    delete rand_file;
+}
+
+TEST_F(MemEnvTest, OverwriteOpenFile) {
+    const char kWrite1Data[] = "Write #1 data";
+    const size_t kFileDataLen = sizeof(kWrite1Data) - 1;
+    const string kTestFileName = "/tmp/leveldb-TestFile.dat";
+
+    WritableFile *writable_file;
+    ASSERT_TRUE(_env->NewWritableFile(kTestFileName, &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append(kWrite1Data).ok());
+    delete writable_file;
+
+    RandomAccessFile *rand_file;
+    ASSERT_TRUE(_env->NewRandomAccessFile(kTestFileName, &rand_file).ok());
+
+    const char kWrite2Data[] = "Write #2 data";
+    ASSERT_TRUE(_env->NewWritableFile(kTestFileName, &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append(kWrite2Data).ok());
+    delete writable_file;
+
+    // The old file object still reads the contents it was opened with.
+    char scratch[kFileDataLen];
+    Slice read_result;
+    ASSERT_TRUE(rand_file->Read(0, kFileDataLen, &read_result, scratch).ok());
+    ASSERT_EQ(0, read_result.compare(kWrite1Data));
+    delete rand_file;
+
+    ASSERT_TRUE(_env->NewRandomAccessFile(kTestFileName, &rand_file).ok());
+    ASSERT_TRUE(rand_file->Read(0, kFileDataLen, &read_result, scratch).ok());
+    ASSERT_EQ(0, read_result.compare(kWrite2Data));
+    delete rand_file;
+}
+
+TEST_F(MemEnvTest, ConcurrentReadersAndWriter) {
+    const int kReaders = 4;
+    const int kRecords = 20000;
+    const size_t kRecordSize = 100;
+
+    WritableFile *writable_file;
+    ASSERT_TRUE(_env->NewWritableFile("/dir/f", &writable_file).ok());
+
+    // Record i is kRecordSize copies of the byte (i % 256).
+    atomic<int> written(0);
+    atomic<bool> failed(false);
+    vector<thread> readers;
+    for (int t = 0; t < kReaders; t++) {
+        readers.emplace_back([this, t, &written, &failed]() {
+            RandomAccessFile *file;
+            if (!_env->NewRandomAccessFile("/dir/f", &file).ok()) {
+                failed = true;
+                return;
+            }
+            Random rnd(t + 1);
+            char scratch[kRecordSize];
+            Slice result;
+            while (written < kRecords) {
+                const int n = written;
+                if (n == 0) {
+                    continue;
+                }
+                const int record = rnd.Uniform(n);
+                if (!file->Read(record * kRecordSize, kRecordSize, &result, scratch).ok() ||
+                    result != Slice(string(kRecordSize, static_cast<char>(record % 256)))) {
+                    failed = true;
+                }
+            }
+            delete file;
+        });
+    }
+
+    for (int i = 0; i < kRecords; i++) {
+        ASSERT_TRUE(writable_file->Append(string(kRecordSize, static_cast<char>(i % 256))).ok());
+        written = i + 1;
+    }
+    for (thread& t : readers) {
+        t.join();
+    }
+    delete writable_file;
+
+    ASSERT_FALSE(failed);
+    uint64_t file_size;
+    ASSERT_TRUE(_env->GetFileSize("/dir/f", &file_size).ok());
+    ASSERT_EQ(kRecords * kRecordSize, file_size);
+}
+
+} // namespace leveldb.
@@ -4,7 +4,14 @@
 
 #pragma once
 
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+#include <cassert>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
 using namespace std;
 
 /*
@@ -19,6 +26,46 @@ using namespace std;
 
 namespace leveldb {
 
+class RandomAccessFile;
+class ScheduleHandle;
+class SequentialFile;
+class WritableFile;
+
+// How the threads that run background work are scheduled by the OS.
+struct BackgroundThreadOptions {
+    // CPUs the threads may run on. Empty means no restriction.
+    vector<int> cpu_set;
+
+    // When >= 0 and cpu_set is empty, restrict the threads to the CPUs
+    // of this NUMA node.
+    int numa_node = -1;
+
+    // Added to the process' nice value for the threads; positive values
+    // lower their priority. Without CAP_SYS_NICE the threads' nice value
+    // can only be raised, so a later smaller increment, including the
+    // default, fails.
+    int nice_increment = 0;
+
+    // Run the threads under the SCHED_BATCH policy, which treats them as
+    // CPU bound and never lets them preempt interactive threads.
+    bool batch_scheduling = false;
+};
+
+// How a file is about to be read. Passed to the OS as an advisory hint.
+enum class AccessPattern {
+    kNormal,        // No particular pattern; the OS default.
+    kSequential,    // Read front to back; read ahead aggressively.
+    kRandom,        // Read at scattered offsets; do not read ahead.
+    kWillNeed,      // The whole file will be read soon; start loading it.
+    kDontNeed,      // The file will not be read again soon; drop it from the cache.
+};
+
+// CPU time consumed by one background thread.
+struct BackgroundThreadCpuTime {
+    string name;
+    uint64_t cpu_micros;
+};
+
 class Env {
 public:
     Env();
@@ -35,6 +82,78 @@ public:
      */
     static Env *Default();
 
+    /*
+     * Create an object that sequentially reads the file with the specified name.
+     * On success, stores a pointer to the new file in *result and returns OK.
+     * On failure stores nullptr in *result and returns non-OK.  If the file does
+     * not exist, returns a non-OK status.  Implementations should return a
+     * NotFound status when the file does not exist.
+     *
+     * The returned file will only be accessed by one thread at a time.
+     * The default Env hints AccessPattern::kSequential for it.
+     */
+    virtual Status NewSequentialFile(const string& fname, SequentialFile **result) = 0;
+
+    /*
+     * Create an object supporting random-access reads from the file with the
+     * specified name.  On success, stores a pointer to the new file in
+     * *result and returns OK.  On failure stores nullptr in *result and
+     * returns non-OK.  If the file does not exist, returns a non-OK
+     * status.  Implementations should return a NotFound status when the file does
+     * not exist.
+     *
+     * The returned file may be concurrently accessed by multiple threads.
+     */
+    virtual Status NewRandomAccessFile(const string& fname, RandomAccessFile **result) = 0;
+
+    /*
+     * Create an object that writes to a new file with the specified
+     * name. Deletes any existing file with the same name and creates a
+     * new file. On success, stores a pointer to the new file in
+     * *result and returns OK. On failure stores nullptr in *result and
+     * returns non-OK.
+     *
+     * The returned file will only be accessed by one thread at a time.
+     * Files of the default Env additionally accept concurrent Append()
+     * and Sync() calls, and serve concurrent Sync() calls with one sync.
+     */
+    virtual Status NewWritableFile(const string& fname, WritableFile **result) = 0;
+
+    /*
+     * Create an object that either appends to an existing file, or
+     * writes to a new file (if the file does not exist to begin with).
+     * On success, stores a pointer to the new file in *result and
+     * returns OK.  On failure stores nullptr in *result and returns
+     * non-OK.
+     *
+     * The returned file will only be accessed by one thread at a time.
+     */
+    virtual Status NewAppendableFile(const string& fname, WritableFile **result) = 0;
+
+    // Returns true iff the named file exists.
+    virtual bool FileExists(const string& fname) = 0;
+
+    /*
+     * Store in *result the names of the children of the specified directory.
+     * The names are relative to "dir".
+     * Original contents of *results are dropped.
+     */
+    virtual Status GetChildren(const string& dir, vector<string> *result) = 0;
+
+    // Delete the named file.
+    virtual Status RemoveFile(const string& fname) = 0;
+
+    // Create the specified directory.
+    virtual Status CreateDir(const string& dirname) = 0;
+
+    // Delete the specified directory.
+    virtual Status RemoveDir(const string& dirname) = 0;
+
+    // Store the size of fname in *file_size.
+    virtual Status GetFileSize(const string& fname, uint64_t *file_size) = 0;
+
+    // Rename file src to target.
+    virtual Status RenameFile(const string& src, const string& target) = 0;
 
     /*
      * Arrange to run "func(arg)" once in a background thread.
@@ -44,6 +163,289 @@ public:
      * the caller may not assume that background work items are serialized.
      */
     virtual void Schedule(function<void(void *)> func, void *arg) = 0;
+
+    /*
+     * Like Schedule(), but returns a handle through which the caller can
+     * wait for "func(arg)" to finish, or cancel it before it starts.
+     */
+    virtual ScheduleHandle ScheduleWithHandle(function<void(void *)> func, void *arg) = 0;
+
+    /*
+     * Arrange to run "func(arg)" once in a background thread, no earlier
+     * than "micros" micro-seconds from now. Delays are rounded up to the
+     * timer resolution of the Env (a millisecond for the default Env).
+     */
+    virtual ScheduleHandle ScheduleAfter(function<void(void *)> func, void *arg, uint64_t micros) = 0;
+
+    /*
+     * Block until the work item behind "handle" has finished running or
+     * has been cancelled. Usually called through ScheduleHandle::Wait().
+     *
+     * Must not be called from a background work item whose completion
+     * depends on the waited-for item; it may deadlock.
+     */
+    virtual void WaitScheduled(const ScheduleHandle& handle) = 0;
+
+    /*
+     * Cancel the work item behind "handle" if it has not started yet.
+     * Returns true iff it was cancelled and will never run.
+     * Usually called through ScheduleHandle::Cancel().
+     */
+    virtual bool CancelScheduled(const ScheduleHandle& handle) = 0;
+
+    /*
+     * Returns the number of micro-seconds since some fixed point in time.
+     * Only useful for computing deltas of time.
+     */
+    virtual uint64_t NowMicros() = 0;
+
+    // Sleep/delay the thread for the prescribed number of micro-seconds.
+    virtual void SleepForMicroseconds(int micros) = 0;
+
+    /*
+     * Apply "options" to every thread that runs background work, now and
+     * in the future. Returns NotSupported if the Env or the platform can
+     * not honor them.
+     */
+    virtual Status SetBackgroundThreadOptions(const BackgroundThreadOptions& options);
+
+    // Store in *result the CPU time used so far by each background thread.
+    virtual Status GetBackgroundThreadCpuTimes(vector<BackgroundThreadCpuTime> *result);
+};
+
+/*
+ * Identifies a work item passed to Env::ScheduleWithHandle() or
+ * Env::ScheduleAfter(). Handles are small values that may be copied
+ * freely; they stay usable after the work item has finished.
+ */
+class ScheduleHandle {
+public:
+    // An invalid handle, not referring to any work item.
+    ScheduleHandle() : _env(nullptr), _id(0) {}
+
+    // "id" is opaque to everyone but "env".
+    ScheduleHandle(Env *env, uint64_t id) : _env(env), _id(id) {}
+
+    bool Valid() const {
+        return _env != nullptr;
+    }
+
+    // Block until the work item has finished running or has been cancelled.
+    void Wait() const {
+        assert(Valid());
+        _env->WaitScheduled(*this);
+    }
+
+    // Cancel the work item if it has not started yet. Returns true iff it
+    // was cancelled.
+    bool Cancel() const {
+        assert(Valid());
+        return _env->CancelScheduled(*this);
+    }
+
+    uint64_t id() const {
+        return _id;
+    }
+
+private:
+    Env *_env;
+    uint64_t _id;
+};
+
+// A file abstraction for reading sequentially through a file.
+class SequentialFile {
+public:
+    SequentialFile() = default;
+
+    SequentialFile(const SequentialFile&) = delete;
+    SequentialFile& operator=(const SequentialFile&) = delete;
+
+    virtual ~SequentialFile();
+
+    /*
+     * Read up to "n" bytes from the file.  "scratch[0..n-1]" may be
+     * written by this routine.  Sets "*result" to the data that was
+     * read (including if fewer than "n" bytes were successfully read).
+     * May set "*result" to point at data in "scratch[0..n-1]", so
+     * "scratch[0..n-1]" must be live when "*result" is used.
+     * If an error was encountered, returns a non-OK status.
+     *
+     * REQUIRES: External synchronization
+     */
+    virtual Status Read(size_t n, Slice *result, char *scratch) = 0;
+
+    /*
+     * Skip "n" bytes from the file. This is guaranteed to be no
+     * slower that reading the same data, but may be faster.
+     *
+     * If end of file is reached, skipping will stop at the end of the
+     * file, and Skip will return OK.
+     *
+     * REQUIRES: External synchronization
+     */
+    virtual Status Skip(uint64_t n) = 0;
+
+    /*
+     * Advise the OS about how the file will be read from now on. Hints
+     * never change what is read; the default implementation ignores them.
+     *
+     * REQUIRES: External synchronization
+     */
+    virtual Status Hint(AccessPattern pattern);
+};
+
+// A file abstraction for randomly reading the contents of a file.
+class RandomAccessFile {
+public:
+    RandomAccessFile() = default;
+
+    RandomAccessFile(const RandomAccessFile&) = delete;
+    RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+
+    virtual ~RandomAccessFile();
+
+    /*
+     * Read up to "n" bytes from the file starting at "offset".
+     * "scratch[0..n-1]" may be written by this routine.  Sets "*result"
+     * to the data that was read (including if fewer than "n" bytes were
+     * successfully read).  May set "*result" to point at data in
+     * "scratch[0..n-1]", so "scratch[0..n-1]" must be live when
+     * "*result" is used.  If an error was encountered, returns a non-OK
+     * status.
+     *
+     * Safe for concurrent use by multiple threads.
+     */
+    virtual Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const = 0;
+
+    /*
+     * Advise the OS about how the file will be read from now on. Hints
+     * never change what is read; the default implementation ignores them.
+     *
+     * Safe for concurrent use by multiple threads.
+     */
+    virtual Status Hint(AccessPattern pattern);
+};
+
+/*
+ * A file abstraction for sequential writing. The implementation
+ * must provide buffering since callers may append small fragments
+ * at a time to the file.
+ */
+class WritableFile {
+public:
+    WritableFile() = default;
+
+    WritableFile(const WritableFile&) = delete;
+    WritableFile& operator=(const WritableFile&) = delete;
+
+    virtual ~WritableFile();
+
+    virtual Status Append(const Slice& data) = 0;
+    virtual Status Close() = 0;
+    virtual Status Flush() = 0;
+    virtual Status Sync() = 0;
+};
+
+/*
+ * An implementation of Env that forwards all calls to another Env.
+ * May be useful to clients who wish to override just part of the
+ * functionality of another Env.
+ */
+class EnvWrapper : public Env {
+public:
+    // Initialize an EnvWrapper that delegates all calls to *t.
+    explicit EnvWrapper(Env *t) : _target(t) {}
+
+    virtual ~EnvWrapper();
+
+    // Return the target to which this Env forwards all calls.
+    Env *target() const {
+        return _target;
+    }
+
+    // The following text is boilerplate that forwards all methods to target().
+    Status NewSequentialFile(const string& f, SequentialFile **r) override {
+        return _target->NewSequentialFile(f, r);
+    }
+
+    Status NewRandomAccessFile(const string& f, RandomAccessFile **r) override {
+        return _target->NewRandomAccessFile(f, r);
+    }
+
+    Status NewWritableFile(const string& f, WritableFile **r) override {
+        return _target->NewWritableFile(f, r);
+    }
+
+    Status NewAppendableFile(const string& f, WritableFile **r) override {
+        return _target->NewAppendableFile(f, r);
+    }
+
+    bool FileExists(const string& f) override {
+        return _target->FileExists(f);
+    }
+
+    Status GetChildren(const string& dir, vector<string> *r) override {
+        return _target->GetChildren(dir, r);
+    }
+
+    Status RemoveFile(const string& f) override {
+        return _target->RemoveFile(f);
+    }
+
+    Status CreateDir(const string& d) override {
+        return _target->CreateDir(d);
+    }
+
+    Status RemoveDir(const string& d) override {
+        return _target->RemoveDir(d);
+    }
+
+    Status GetFileSize(const string& f, uint64_t *s) override {
+        return _target->GetFileSize(f, s);
+    }
+
+    Status RenameFile(const string& s, const string& t) override {
+        return _target->RenameFile(s, t);
+    }
+
+    void Schedule(function<void(void *)> f, void *a) override {
+        return _target->Schedule(f, a);
+    }
+
+    ScheduleHandle ScheduleWithHandle(function<void(void *)> f, void *a) override {
+        return _target->ScheduleWithHandle(f, a);
+    }
+
+    ScheduleHandle ScheduleAfter(function<void(void *)> f, void *a, uint64_t micros) override {
+        return _target->ScheduleAfter(f, a, micros);
+    }
+
+    void WaitScheduled(const ScheduleHandle& h) override {
+        _target->WaitScheduled(h);
+    }
+
+    bool CancelScheduled(const ScheduleHandle& h) override {
+        return _target->CancelScheduled(h);
+    }
+
+    uint64_t NowMicros() override {
+        return _target->NowMicros();
+    }
+
+    void SleepForMicroseconds(int micros) override {
+        _target->SleepForMicroseconds(micros);
+    }
+
+    Status SetBackgroundThreadOptions(const BackgroundThreadOptions& options) override {
+        return _target->SetBackgroundThreadOptions(options);
+    }
+
+    Status GetBackgroundThreadCpuTimes(vector<BackgroundThreadCpuTime> *result) override {
+        return _target->GetBackgroundThreadCpuTimes(result);
+    }
+
+private:
+    Env *_target;
 };
 
-}; // namespace leveldb.
\ No newline at end of file
+}; // namespace leveldb.
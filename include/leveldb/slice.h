@@ -0,0 +1,135 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Slice is a simple structure containing a pointer into some external
+ * storage and a size. The user of a Slice must ensure that the slice
+ * is not used after the corresponding external storage has been
+ * deallocated.
+ *
+ * Multiple threads can invoke const methods on a Slice without
+ * external synchronization, but if any of the threads may call a
+ * non-const method, all threads accessing the same Slice must use
+ * external synchronization.
+ */
+class Slice {
+public:
+    // Create an empty slice.
+    Slice() : _data(""), _size(0) {}
+
+    // Create a slice that refers to d[0,n-1].
+    Slice(const char *d, size_t n) : _data(d), _size(n) {}
+
+    // Create a slice that refers to the contents of "s".
+    Slice(const string& s) : _data(s.data()), _size(s.size()) {}
+
+    // Create a slice that refers to s[0,strlen(s)-1].
+    Slice(const char *s) : _data(s), _size(strlen(s)) {}
+
+    // Intentionally copyable.
+    Slice(const Slice&) = default;
+    Slice& operator=(const Slice&) = default;
+
+    // Returns a pointer to the beginning of the referenced data.
+    const char *data() const {
+        return _data;
+    }
+
+    // Returns the length (in bytes) of the referenced data.
+    size_t size() const {
+        return _size;
+    }
+
+    // Returns true iff the length of the referenced data is zero.
+    bool empty() const {
+        return _size == 0;
+    }
+
+    // Returns the ith byte in the referenced data.
+    // REQUIRES: n < size()
+    char operator[](size_t n) const {
+        assert(n < size());
+        return _data[n];
+    }
+
+    // Change this slice to refer to an empty array.
+    void clear() {
+        _data = "";
+        _size = 0;
+    }
+
+    // Drop the first "n" bytes from this slice.
+    void remove_prefix(size_t n) {
+        assert(n <= size());
+        _data += n;
+        _size -= n;
+    }
+
+    // Returns a string that contains the copy of the referenced data.
+    string ToString() const {
+        return string(_data, _size);
+    }
+
+    /*
+     * Three-way comparison. Returns value:
+     *   <  0 iff "*this" <  "b",
+     *   == 0 iff "*this" == "b",
+     *   >  0 iff "*this" >  "b"
+     */
+    int compare(const Slice& b) const;
+
+    // Returns true iff "x" is a prefix of "*this".
+    bool starts_with(const Slice& x) const {
+        return (_size >= x._size) && (memcmp(_data, x._data, x._size) == 0);
+    }
+
+    /*
+     * Returns the length of the longest common prefix of "*this" and "b",
+     * which is also the offset of the first byte at which they differ.
+     * Compares 16 or 32 bytes per step with SSE2 or AVX2 when the CPU has
+     * them, so keys sharing long prefixes cost little more than short ones.
+     */
+    size_t difference_offset(const Slice& b) const;
+
+private:
+    const char *_data;
+    size_t _size;
+};
+
+inline bool operator==(const Slice& x, const Slice& y) {
+    return (x.size() == y.size()) &&
+           (memcmp(x.data(), y.data(), x.size()) == 0);
+}
+
+inline bool operator!=(const Slice& x, const Slice& y) {
+    return !(x == y);
+}
+
+// Slice::difference_offset() without SIMD. Exposed for testing.
+size_t DifferenceOffsetPortable(const Slice& a, const Slice& b);
+
+inline int Slice::compare(const Slice& b) const {
+    const size_t min_len = (_size < b._size) ? _size : b._size;
+    int r = memcmp(_data, b._data, min_len);
+    if (r == 0) {
+        if (_size < b._size) {
+            r = -1;
+        } else if (_size > b._size) {
+            r = +1;
+        }
+    }
+    return r;
+}
+
+} // namespace leveldb.
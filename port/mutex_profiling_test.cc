@@ -0,0 +1,106 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "port/port.h"
+
+#include "util/mutexlock.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+static const port::MutexContentionStats *FindSite(const vector<port::MutexContentionStats>& sites,
+                                                  int line) {
+    for (const port::MutexContentionStats& site : sites) {
+        if (site.line == line && strstr(site.file, "mutex_profiling_test.cc") != nullptr) {
+            return &site;
+        }
+    }
+    return nullptr;
+}
+
+TEST(MutexProfilingTest, CallSites) {
+    ASSERT_TRUE(port::MutexProfilingEnabled());
+    port::ResetMutexContention();
+
+    port::Mutex mu;
+    const int kThreads = 4;
+    const int kIterations = 200;
+    // The line each thread locks at; only written by that thread.
+    vector<int> lines(kThreads);
+
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kIterations; i++) {
+                if (t == 0) {
+                    lines[t] = __LINE__ + 1;
+                    MutexLock l(&mu);
+                    this_thread::sleep_for(chrono::microseconds(100));
+                } else {
+                    lines[t] = __LINE__ + 1;
+                    MutexLock l(&mu);
+                }
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    const int holder_line = lines[0];
+    const int waiter_line = lines[1];
+
+    vector<port::MutexContentionStats> sites;
+    port::GetMutexContentionStats(&sites);
+    const port::MutexContentionStats *holder = FindSite(sites, holder_line);
+    const port::MutexContentionStats *waiter = FindSite(sites, waiter_line);
+    ASSERT_TRUE(holder != nullptr);
+    ASSERT_TRUE(waiter != nullptr);
+
+    ASSERT_EQ(kIterations, holder->acquisitions);
+    ASSERT_EQ((kThreads - 1) * kIterations, waiter->acquisitions);
+    ASSERT_GE(holder->hold_nanos, kIterations * 100 * 1000ULL);
+    ASSERT_GE(holder->max_hold_nanos, 100 * 1000ULL);
+    ASSERT_LT(waiter->hold_nanos, holder->hold_nanos);
+
+    // Waiters queue up behind the sleeping holder.
+    ASSERT_GT(waiter->contended_acquisitions, 0);
+    ASSERT_GT(waiter->wait_nanos, 0);
+    ASSERT_GE(waiter->wait_nanos, waiter->max_wait_nanos);
+
+    const string dump = port::DumpMutexContention();
+    ASSERT_NE(string::npos, dump.find("mutex_profiling_test.cc:" + to_string(holder_line)));
+
+    port::ResetMutexContention();
+    port::GetMutexContentionStats(&sites);
+    ASSERT_TRUE(FindSite(sites, holder_line) == nullptr);
+}
+
+TEST(MutexProfilingTest, CondVarWaitIsNotHeld) {
+    port::ResetMutexContention();
+    port::Mutex mu;
+    port::CondVar cv(&mu);
+
+    int line;
+    {
+        line = __LINE__ + 1;
+        MutexLock l(&mu);
+        cv.WaitFor(20000);
+    }
+
+    vector<port::MutexContentionStats> sites;
+    port::GetMutexContentionStats(&sites);
+    const port::MutexContentionStats *site = FindSite(sites, line);
+    ASSERT_TRUE(site != nullptr);
+    ASSERT_EQ(1, site->acquisitions);
+    ASSERT_LT(site->hold_nanos, 10 * 1000 * 1000ULL);
+}
+
+} // namespace leveldb.
@@ -0,0 +1,271 @@
+// Copyright (c) 2018 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "port/port_stdcxx.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace leveldb {
+namespace port {
+
+void
+CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Bounds of the adaptive spin limit.
+static const int kMinSpins = 16;
+static const int kMaxSpins = 1024;
+
+// Spinning only helps when the owner can run while we wait.
+static const bool spinning_enabled = std::thread::hardware_concurrency() > 1;
+
+void
+Mutex::LockSlow()
+{
+    if (spinning_enabled) {
+        const int limit = _spin_limit.load(std::memory_order_relaxed);
+        for (int i = 0; i < limit; i++) {
+            CpuRelax();
+            if (_mu.try_lock()) {
+                // Move the limit towards twice what this acquisition needed.
+                const int target = std::min(2 * (i + 1), kMaxSpins);
+                _spin_limit.store(std::max(kMinSpins, limit + (target - limit) / 8),
+                                  std::memory_order_relaxed);
+                return;
+            }
+        }
+        // The owner held on for longer than we are willing to spin.
+        _spin_limit.store(std::max(kMinSpins, limit - limit / 8), std::memory_order_relaxed);
+    }
+    _mu.lock();
+}
+
+#if defined(LEVELDB_MUTEX_PROFILING)
+
+// Counters of one call site. Sites are never removed, so pointers to
+// them stay valid for the life of the process.
+struct ContentionSite {
+    // (file pointer, line) packed by SiteKey(); 0 while the slot is free.
+    std::atomic<uint64_t> key;
+    std::atomic<const char *> file;
+    std::atomic<int> line;
+
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended_acquisitions;
+    std::atomic<uint64_t> wait_nanos;
+    std::atomic<uint64_t> max_wait_nanos;
+    std::atomic<uint64_t> hold_nanos;
+    std::atomic<uint64_t> max_hold_nanos;
+};
+
+// Open addressing table of call sites. The last slot collects every site
+// that does not fit.
+static const size_t kMaxContentionSites = 1024;
+static ContentionSite contention_sites[kMaxContentionSites + 1];
+
+static uint64_t
+NowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t
+SiteKey(const char *file, int line)
+{
+    // User space addresses fit in 48 bits on every supported platform.
+    const uint64_t address = reinterpret_cast<uintptr_t>(file) & ((1ULL << 48) - 1);
+    const uint64_t line_bits = static_cast<uint64_t>(std::min(std::max(line, 0), 0xffff));
+    return address | (line_bits << 48) | (address == 0 ? 1 : 0);
+}
+
+static ContentionSite *
+FindSite(const char *file, int line)
+{
+    const uint64_t key = SiteKey(file, line);
+    size_t index = static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) % kMaxContentionSites;
+    for (size_t probes = 0; probes < kMaxContentionSites; probes++) {
+        ContentionSite *site = &contention_sites[index];
+        uint64_t current = site->key.load(std::memory_order_acquire);
+        if (current == 0 &&
+            site->key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+            site->file.store(file, std::memory_order_release);
+            site->line.store(line, std::memory_order_release);
+            return site;
+        }
+        if (current == key) {
+            return site;
+        }
+        index = (index + 1) % kMaxContentionSites;
+    }
+    return &contention_sites[kMaxContentionSites];
+}
+
+static void
+UpdateMax(std::atomic<uint64_t> *max_value, uint64_t value)
+{
+    uint64_t current = max_value->load(std::memory_order_relaxed);
+    while (value > current &&
+           !max_value->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void
+Mutex::LockProfiled(CallSite site)
+{
+    if (_mu.try_lock()) {
+        ProfileAcquired(site, false, 0);
+        return;
+    }
+    const uint64_t start = NowNanos();
+    LockSlow();
+    ProfileAcquired(site, true, NowNanos() - start);
+}
+
+void
+Mutex::ProfileAcquired(CallSite site, bool contended, uint64_t wait_nanos)
+{
+    ContentionSite *holder = FindSite(site.file, site.line);
+    holder->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended) {
+        holder->contended_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        holder->wait_nanos.fetch_add(wait_nanos, std::memory_order_relaxed);
+        UpdateMax(&holder->max_wait_nanos, wait_nanos);
+    }
+    ProfileReacquired(holder);
+}
+
+ContentionSite *
+Mutex::ProfileRelease()
+{
+    ContentionSite *holder = _holder;
+    const uint64_t held = NowNanos() - _acquired_nanos;
+    holder->hold_nanos.fetch_add(held, std::memory_order_relaxed);
+    UpdateMax(&holder->max_hold_nanos, held);
+    return holder;
+}
+
+void
+Mutex::ProfileReacquired(ContentionSite *holder)
+{
+    _holder = holder;
+    _acquired_nanos = NowNanos();
+}
+
+bool
+MutexProfilingEnabled()
+{
+    return true;
+}
+
+void
+GetMutexContentionStats(std::vector<MutexContentionStats> *result)
+{
+    result->clear();
+    for (ContentionSite& site : contention_sites) {
+        if (site.acquisitions.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        MutexContentionStats stats;
+        if (&site == &contention_sites[kMaxContentionSites]) {
+            stats.file = "(other)";
+            stats.line = 0;
+        } else {
+            // Null while the site is still being inserted.
+            stats.file = site.file.load(std::memory_order_acquire);
+            stats.line = site.line.load(std::memory_order_acquire);
+        }
+        stats.acquisitions = site.acquisitions.load(std::memory_order_relaxed);
+        stats.contended_acquisitions = site.contended_acquisitions.load(std::memory_order_relaxed);
+        stats.wait_nanos = site.wait_nanos.load(std::memory_order_relaxed);
+        stats.max_wait_nanos = site.max_wait_nanos.load(std::memory_order_relaxed);
+        stats.hold_nanos = site.hold_nanos.load(std::memory_order_relaxed);
+        stats.max_hold_nanos = site.max_hold_nanos.load(std::memory_order_relaxed);
+        if (stats.file != nullptr) {
+            result->push_back(stats);
+        }
+    }
+    std::sort(result->begin(), result->end(),
+              [](const MutexContentionStats& a, const MutexContentionStats& b) {
+                  return a.wait_nanos > b.wait_nanos;
+              });
+}
+
+void
+ResetMutexContention()
+{
+    for (ContentionSite& site : contention_sites) {
+        site.acquisitions.store(0, std::memory_order_relaxed);
+        site.contended_acquisitions.store(0, std::memory_order_relaxed);
+        site.wait_nanos.store(0, std::memory_order_relaxed);
+        site.max_wait_nanos.store(0, std::memory_order_relaxed);
+        site.hold_nanos.store(0, std::memory_order_relaxed);
+        site.max_hold_nanos.store(0, std::memory_order_relaxed);
+    }
+}
+
+#else
+
+bool
+MutexProfilingEnabled()
+{
+    return false;
+}
+
+void
+GetMutexContentionStats(std::vector<MutexContentionStats> *result)
+{
+    result->clear();
+}
+
+void
+ResetMutexContention()
+{
+}
+
+#endif  // defined(LEVELDB_MUTEX_PROFILING)
+
+std::string
+DumpMutexContention()
+{
+    if (!MutexProfilingEnabled()) {
+        return "mutex profiling disabled; build with -DLEVELDB_MUTEX_PROFILING\n";
+    }
+
+    std::vector<MutexContentionStats> sites;
+    GetMutexContentionStats(&sites);
+
+    std::string r;
+    char buf[300];
+    snprintf(buf, sizeof(buf), "%-40s %12s %12s %12s %12s %12s %12s\n",
+             "call site", "acquired", "contended", "wait (us)", "max wait", "hold (us)", "max hold");
+    r.append(buf);
+    for (const MutexContentionStats& site : sites) {
+        char location[200];
+        snprintf(location, sizeof(location), "%s:%d", site.file, site.line);
+        snprintf(buf, sizeof(buf), "%-40s %12llu %12llu %12.1f %12.1f %12.1f %12.1f\n",
+                 location,
+                 static_cast<unsigned long long>(site.acquisitions),
+                 static_cast<unsigned long long>(site.contended_acquisitions),
+                 site.wait_nanos / 1e3, site.max_wait_nanos / 1e3,
+                 site.hold_nanos / 1e3, site.max_hold_nanos / 1e3);
+        r.append(buf);
+    }
+    return r;
+}
+
+} // namespace port.
+} // namespace leveldb.
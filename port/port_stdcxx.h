@@ -0,0 +1,206 @@
+// Copyright (c) 2018 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "port/thread_annotations.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace leveldb {
+namespace port {
+
+class CondVar;
+struct ContentionSite;
+
+/*
+ * Where a mutex is acquired, captured implicitly through default
+ * arguments. Empty, and free to pass around, unless mutex profiling is
+ * compiled in with LEVELDB_MUTEX_PROFILING.
+ */
+struct CallSite {
+#if defined(LEVELDB_MUTEX_PROFILING)
+    CallSite(const char *file = __builtin_FILE(), int line = __builtin_LINE())
+        : file(file), line(line) {}
+
+    const char *file;
+    int line;
+#endif
+};
+
+/*
+ * A mutex that spins briefly before blocking.
+ *
+ * Critical sections in hot paths usually last far less than the cost of
+ * parking a thread in the kernel, so a contended Lock() first retries for
+ * a while on the assumption that the owner is running on another CPU.
+ * The length of the spin adapts to how long recent acquisitions had to
+ * wait: it grows while spinning succeeds and shrinks when it does not,
+ * so mutexes guarding long critical sections quickly stop spinning.
+ * Machines with a single CPU never spin.
+ */
+class CAPABILITY("mutex") Mutex {
+public:
+    Mutex() : _spin_limit(kInitialSpins) {}
+    ~Mutex() = default;
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void Lock(CallSite site = CallSite()) ACQUIRE() {
+#if defined(LEVELDB_MUTEX_PROFILING)
+        LockProfiled(site);
+#else
+        if (!_mu.try_lock()) {
+            LockSlow();
+        }
+#endif
+    }
+
+    bool TryLock(CallSite site = CallSite()) TRY_ACQUIRE(true) {
+        const bool locked = _mu.try_lock();
+#if defined(LEVELDB_MUTEX_PROFILING)
+        if (locked) {
+            ProfileAcquired(site, false, 0);
+        }
+#endif
+        return locked;
+    }
+
+    void Unlock() RELEASE() {
+#if defined(LEVELDB_MUTEX_PROFILING)
+        ProfileRelease();
+#endif
+        _mu.unlock();
+    }
+
+    // Not checked; documents that the caller holds the mutex.
+    void AssertHeld() ASSERT_CAPABILITY(this) {}
+
+private:
+    friend class CondVar;
+
+    // Spin iterations (roughly 10-100ns each) of a fresh mutex.
+    static const int kInitialSpins = 64;
+
+    void LockSlow();
+
+    std::mutex _mu;
+
+    // Number of failed attempts after which Lock() blocks.
+    std::atomic<int> _spin_limit;
+
+#if defined(LEVELDB_MUTEX_PROFILING)
+    void LockProfiled(CallSite site);
+    void ProfileAcquired(CallSite site, bool contended, uint64_t wait_nanos);
+
+    // Charges the hold time to the owner's call site, which is returned.
+    ContentionSite *ProfileRelease();
+    void ProfileReacquired(ContentionSite *holder);
+
+    // Call site and time of the current acquisition. Written by the owner.
+    ContentionSite *_holder;
+    uint64_t _acquired_nanos;
+#endif
+};
+
+// Thinly wraps std::condition_variable.
+class CondVar {
+public:
+    explicit CondVar(Mutex *mu) : _mu(mu) {
+        assert(mu != nullptr);
+    }
+    ~CondVar() = default;
+
+    CondVar(const CondVar&) = delete;
+    CondVar& operator=(const CondVar&) = delete;
+
+    // Atomically releases the mutex and waits; re-acquires it before
+    // returning. May wake up spuriously.
+    void Wait() {
+#if defined(LEVELDB_MUTEX_PROFILING)
+        ContentionSite *holder = _mu->ProfileRelease();
+#endif
+        std::unique_lock<std::mutex> lock(_mu->_mu, std::adopt_lock);
+        _cv.wait(lock);
+        lock.release();
+#if defined(LEVELDB_MUTEX_PROFILING)
+        _mu->ProfileReacquired(holder);
+#endif
+    }
+
+    // Like Wait(), but gives up after "micros" micro-seconds. Returns
+    // false on timeout.
+    bool WaitFor(uint64_t micros) {
+#if defined(LEVELDB_MUTEX_PROFILING)
+        ContentionSite *holder = _mu->ProfileRelease();
+#endif
+        std::unique_lock<std::mutex> lock(_mu->_mu, std::adopt_lock);
+        const std::cv_status status = _cv.wait_for(lock, std::chrono::microseconds(micros));
+        lock.release();
+#if defined(LEVELDB_MUTEX_PROFILING)
+        _mu->ProfileReacquired(holder);
+#endif
+        return status == std::cv_status::no_timeout;
+    }
+
+    void Signal() {
+        _cv.notify_one();
+    }
+
+    void SignalAll() {
+        _cv.notify_all();
+    }
+
+private:
+    std::condition_variable _cv;
+    Mutex *const _mu;
+};
+
+// Tells the CPU that the calling thread is busy-waiting.
+void CpuRelax();
+
+// Lock contention recorded for one call site that acquires mutexes.
+struct MutexContentionStats {
+    const char *file;
+    int line;
+
+    uint64_t acquisitions;
+    // Acquisitions that found the mutex held by another thread.
+    uint64_t contended_acquisitions;
+
+    // Time spent waiting by contended acquisitions.
+    uint64_t wait_nanos;
+    uint64_t max_wait_nanos;
+
+    // Time the mutex was held after being acquired here. Condition
+    // variable waits do not count as holding.
+    uint64_t hold_nanos;
+    uint64_t max_hold_nanos;
+};
+
+// True iff LEVELDB_MUTEX_PROFILING was defined when building the port.
+bool MutexProfilingEnabled();
+
+/*
+ * Stores the contention recorded so far by every call site in *result,
+ * most waited-on first. Empty unless profiling is enabled.
+ */
+void GetMutexContentionStats(std::vector<MutexContentionStats> *result);
+
+// One line per call site, in the order of GetMutexContentionStats().
+std::string DumpMutexContention();
+
+// Clears the recorded contention.
+void ResetMutexContention();
+
+} // namespace port.
+} // namespace leveldb.
@@ -0,0 +1,80 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "port/port.h"
+
+#include "util/mutexlock.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(PortTest, MutualExclusion) {
+    port::Mutex mu;
+    const int kThreads = 4;
+    const int kIncrements = 100000;
+    // Not atomic: increments are only safe under the mutex.
+    int counter = 0;
+
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&mu, &counter]() {
+            for (int i = 0; i < kIncrements; i++) {
+                MutexLock l(&mu);
+                counter++;
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(kThreads * kIncrements, counter);
+}
+
+TEST(PortTest, TryLock) {
+    port::Mutex mu;
+    ASSERT_TRUE(mu.TryLock());
+    thread other([&mu]() {
+        ASSERT_FALSE(mu.TryLock());
+    });
+    other.join();
+    mu.Unlock();
+}
+
+TEST(PortTest, CondVar) {
+    port::Mutex mu;
+    port::CondVar cv(&mu);
+    bool ready = false;
+
+    thread signaller([&]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        MutexLock l(&mu);
+        ready = true;
+        cv.SignalAll();
+    });
+    {
+        MutexLock l(&mu);
+        while (!ready) {
+            cv.Wait();
+        }
+    }
+    signaller.join();
+
+    // Nobody signals; the wait times out with the mutex held again.
+    MutexLock l(&mu);
+    const auto start = chrono::steady_clock::now();
+    ASSERT_FALSE(cv.WaitFor(10000));
+    ASSERT_GE(chrono::steady_clock::now() - start, chrono::microseconds(10000));
+    mu.AssertHeld();
+    thread other([&mu]() {
+        ASSERT_FALSE(mu.TryLock());
+    });
+    other.join();
+}
+
+} // namespace leveldb.
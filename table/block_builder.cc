@@ -0,0 +1,84 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "block_builder.h"
+
+#include "util/coding.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+
+BlockBuilder::BlockBuilder(int block_restart_interval)
+    : _block_restart_interval(block_restart_interval), _counter(0), _finished(false)
+{
+    assert(block_restart_interval >= 1);
+    _restarts.push_back(0);  // First restart point is at offset 0.
+}
+
+void
+BlockBuilder::Reset()
+{
+    _buffer.clear();
+    _restarts.clear();
+    _restarts.push_back(0);  // First restart point is at offset 0.
+    _counter = 0;
+    _finished = false;
+    _last_key.clear();
+}
+
+size_t
+BlockBuilder::CurrentSizeEstimate() const
+{
+    return (_buffer.size() +                        // Raw data buffer.
+            _restarts.size() * sizeof(uint32_t) +   // Restart array.
+            sizeof(uint32_t));                      // Restart array length.
+}
+
+Slice
+BlockBuilder::Finish()
+{
+    // Append restart array.
+    for (size_t i = 0; i < _restarts.size(); i++) {
+        PutFixed32(&_buffer, _restarts[i]);
+    }
+    PutFixed32(&_buffer, _restarts.size());
+    _finished = true;
+    return Slice(_buffer);
+}
+
+void
+BlockBuilder::Add(const Slice& key, const Slice& value)
+{
+    assert(!_finished);
+    assert(_counter <= _block_restart_interval);
+    size_t shared = 0;
+    if (_counter < _block_restart_interval) {
+        // See how much sharing to do with previous string.
+        shared = key.difference_offset(Slice(_last_key));
+    } else {
+        // Restart compression.
+        _restarts.push_back(_buffer.size());
+        _counter = 0;
+    }
+    const size_t non_shared = key.size() - shared;
+
+    // Add "<shared><non_shared><value_size>" to _buffer.
+    PutVarint32(&_buffer, shared);
+    PutVarint32(&_buffer, non_shared);
+    PutVarint32(&_buffer, value.size());
+
+    // Add string delta to _buffer followed by value.
+    _buffer.append(key.data() + shared, non_shared);
+    _buffer.append(value.data(), value.size());
+
+    // Update state.
+    _last_key.resize(shared);
+    _last_key.append(key.data() + shared, non_shared);
+    assert(Slice(_last_key) == key);
+    _counter++;
+}
+
+} // namespace leveldb.
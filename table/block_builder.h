@@ -0,0 +1,83 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/slice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Builds a block of key/value entries in the order they are added.
+ *
+ * Each key is stored as the length of the prefix it shares with the
+ * previous key and the rest of its bytes:
+ *
+ *     shared_bytes: varint32
+ *     unshared_bytes: varint32
+ *     value_length: varint32
+ *     key_delta: char[unshared_bytes]
+ *     value: char[value_length]
+ *
+ * Every "block_restart_interval" keys the sharing restarts, with the key
+ * stored whole, so that a reader can binary search the restart points.
+ * The block ends with the offsets of the restart points and their count,
+ * all fixed32.
+ *
+ * The buffers are kept across Reset(), so once they have grown to a
+ * block's size, building further blocks allocates nothing.
+ */
+class BlockBuilder {
+public:
+    explicit BlockBuilder(int block_restart_interval);
+
+    BlockBuilder(const BlockBuilder&) = delete;
+    BlockBuilder& operator=(const BlockBuilder&) = delete;
+
+    // Reset the contents as if the BlockBuilder was just constructed.
+    void Reset();
+
+    // REQUIRES: Finish() has not been called since the last call to Reset().
+    void Add(const Slice& key, const Slice& value);
+
+    /*
+     * Finish building the block and return a slice that refers to the
+     * block contents. The returned slice will remain valid for the
+     * lifetime of this builder or until Reset() is called.
+     */
+    Slice Finish();
+
+    /*
+     * Returns an estimate of the current (uncompressed) size of the block
+     * we are building.
+     */
+    size_t CurrentSizeEstimate() const;
+
+    // Return true iff no entries have been added since the last Reset().
+    bool empty() const {
+        return _buffer.empty();
+    }
+
+    // The key most recently added.
+    Slice last_key() const {
+        return Slice(_last_key);
+    }
+
+private:
+    const int _block_restart_interval;
+
+    string _buffer;               // Destination buffer.
+    vector<uint32_t> _restarts;   // Restart points.
+    int _counter;                 // Number of entries emitted since restart.
+    bool _finished;               // Has Finish() been called?
+    string _last_key;
+};
+
+} // namespace leveldb.
@@ -0,0 +1,72 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "format.h"
+
+#include "util/coding.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+
+BlockHandle::BlockHandle() : _offset(~static_cast<uint64_t>(0)), _size(~static_cast<uint64_t>(0))
+{
+}
+
+void
+BlockHandle::EncodeTo(string *dst) const
+{
+    // Sanity check that all fields have been set.
+    assert(_offset != ~static_cast<uint64_t>(0));
+    assert(_size != ~static_cast<uint64_t>(0));
+    PutVarint64(dst, _offset);
+    PutVarint64(dst, _size);
+}
+
+Status
+BlockHandle::DecodeFrom(Slice *input)
+{
+    if (GetVarint64(input, &_offset) && GetVarint64(input, &_size)) {
+        return Status::OK();
+    }
+    return Status::Corruption("bad block handle");
+}
+
+void
+Footer::EncodeTo(string *dst) const
+{
+    const size_t original_size = dst->size();
+    _metaindex_handle.EncodeTo(dst);
+    _index_handle.EncodeTo(dst);
+    dst->resize(original_size + 2 * BlockHandle::kMaxEncodedLength);  // Padding.
+    PutFixed64(dst, kTableMagicNumber);
+    assert(dst->size() == original_size + kEncodedLength);
+}
+
+Status
+Footer::DecodeFrom(Slice *input)
+{
+    if (input->size() < kEncodedLength) {
+        return Status::Corruption("not an sstable (footer too short)");
+    }
+
+    const char *magic_ptr = input->data() + kEncodedLength - 8;
+    if (DecodeFixed64(magic_ptr) != kTableMagicNumber) {
+        return Status::Corruption("not an sstable (bad magic number)");
+    }
+
+    Status result = _metaindex_handle.DecodeFrom(input);
+    if (result.ok()) {
+        result = _index_handle.DecodeFrom(input);
+    }
+    if (result.ok()) {
+        // Skip over any leftover data (just padding for now) in "input".
+        const char *end = magic_ptr + 8;
+        *input = Slice(end, input->data() + input->size() - end);
+    }
+    return result;
+}
+
+} // namespace leveldb.
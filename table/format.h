@@ -0,0 +1,109 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * BlockHandle is a pointer to the extent of a file that stores a data
+ * block or a meta block.
+ */
+class BlockHandle {
+public:
+    // Maximum encoding length of a BlockHandle.
+    enum { kMaxEncodedLength = 10 + 10 };
+
+    BlockHandle();
+
+    // The offset of the block in the file.
+    uint64_t offset() const {
+        return _offset;
+    }
+    void set_offset(uint64_t offset) {
+        _offset = offset;
+    }
+
+    // The size of the stored block, without its trailer.
+    uint64_t size() const {
+        return _size;
+    }
+    void set_size(uint64_t size) {
+        _size = size;
+    }
+
+    void EncodeTo(string *dst) const;
+    Status DecodeFrom(Slice *input);
+
+private:
+    uint64_t _offset;
+    uint64_t _size;
+};
+
+/*
+ * Footer encapsulates the fixed information stored at the tail
+ * end of every table file.
+ */
+class Footer {
+public:
+    /*
+     * Encoded length of a Footer. Note that the serialization of a
+     * Footer will always occupy exactly this many bytes. It consists
+     * of two block handles and a magic number.
+     */
+    enum { kEncodedLength = 2 * BlockHandle::kMaxEncodedLength + 8 };
+
+    Footer() = default;
+
+    // The block handle for the metaindex block of the table.
+    const BlockHandle& metaindex_handle() const {
+        return _metaindex_handle;
+    }
+    void set_metaindex_handle(const BlockHandle& h) {
+        _metaindex_handle = h;
+    }
+
+    // The block handle for the index block of the table.
+    const BlockHandle& index_handle() const {
+        return _index_handle;
+    }
+    void set_index_handle(const BlockHandle& h) {
+        _index_handle = h;
+    }
+
+    void EncodeTo(string *dst) const;
+    Status DecodeFrom(Slice *input);
+
+private:
+    BlockHandle _metaindex_handle;
+    BlockHandle _index_handle;
+};
+
+/*
+ * kTableMagicNumber was picked by running
+ *    echo http://code.google.com/p/leveldb/ | sha1sum
+ * and taking the leading 64 bits.
+ */
+static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
+
+// Every block is followed by a 1-byte type and a 32-bit masked crc.
+static const size_t kBlockTrailerSize = 5;
+
+/*
+ * DO NOT CHANGE THESE ENUM VALUES: they are embedded in the on-disk
+ * data structures.
+ */
+enum CompressionType {
+    kNoCompression = 0x0
+};
+
+} // namespace leveldb.
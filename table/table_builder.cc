@@ -0,0 +1,139 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table_builder.h"
+
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+#include <cassert>
+using namespace std;
+
+namespace leveldb {
+
+TableBuilder::TableBuilder(const TableOptions& options, WritableFile *file)
+    : _options(options),
+      _file(file),
+      _offset(0),
+      _data_block(options.block_restart_interval),
+      _index_block(1),
+      _num_entries(0),
+      _closed(false)
+{
+}
+
+TableBuilder::~TableBuilder()
+{
+    assert(_closed);  // Catch errors where caller forgot to call Finish().
+}
+
+void
+TableBuilder::Add(const Slice& key, const Slice& value)
+{
+    assert(!_closed);
+    if (!ok()) {
+        return;
+    }
+
+    _data_block.Add(key, value);
+    _num_entries++;
+
+    if (_data_block.CurrentSizeEstimate() >= _options.block_size) {
+        Flush();
+    }
+}
+
+void
+TableBuilder::Flush()
+{
+    assert(!_closed);
+    if (!ok() || _data_block.empty()) {
+        return;
+    }
+
+    /*
+     * The block's last key separates it from the next block: it is at
+     * least every key in the block and before every key after it.
+     */
+    BlockHandle handle;
+    WriteRawBlock(_data_block.Finish(), kNoCompression, &handle);
+    if (ok()) {
+        _handle_encoding.clear();
+        handle.EncodeTo(&_handle_encoding);
+        _index_block.Add(_data_block.last_key(), Slice(_handle_encoding));
+        _status = _file->Flush();
+    }
+    _data_block.Reset();
+}
+
+void
+TableBuilder::WriteBlock(BlockBuilder *block, BlockHandle *handle)
+{
+    WriteRawBlock(block->Finish(), kNoCompression, handle);
+    block->Reset();
+}
+
+void
+TableBuilder::WriteRawBlock(const Slice& block_contents, CompressionType type, BlockHandle *handle)
+{
+    handle->set_offset(_offset);
+    handle->set_size(block_contents.size());
+    _status = _file->Append(block_contents);
+    if (ok()) {
+        char trailer[kBlockTrailerSize];
+        trailer[0] = type;
+        uint32_t crc = crc32c::Value(block_contents.data(), block_contents.size());
+        crc = crc32c::Extend(crc, trailer, 1);  // Extend crc to cover block type.
+        EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+        _status = _file->Append(Slice(trailer, kBlockTrailerSize));
+        if (ok()) {
+            _offset += block_contents.size() + kBlockTrailerSize;
+        }
+    }
+}
+
+Status
+TableBuilder::Finish()
+{
+    Flush();
+    assert(!_closed);
+    _closed = true;
+
+    BlockHandle metaindex_block_handle, index_block_handle;
+
+    // Write metaindex block.
+    if (ok()) {
+        BlockBuilder meta_index_block(_options.block_restart_interval);
+        WriteBlock(&meta_index_block, &metaindex_block_handle);
+    }
+
+    // Write index block.
+    if (ok()) {
+        WriteBlock(&_index_block, &index_block_handle);
+    }
+
+    // Write footer.
+    if (ok()) {
+        Footer footer;
+        footer.set_metaindex_handle(metaindex_block_handle);
+        footer.set_index_handle(index_block_handle);
+        string footer_encoding;
+        footer.EncodeTo(&footer_encoding);
+        _status = _file->Append(footer_encoding);
+        if (ok()) {
+            _offset += footer_encoding.size();
+        }
+    }
+    return _status;
+}
+
+void
+TableBuilder::Abandon()
+{
+    assert(!_closed);
+    _closed = true;
+}
+
+} // namespace leveldb.
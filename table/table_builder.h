@@ -0,0 +1,148 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+class WritableFile;
+
+struct TableOptions {
+    // Approximate size of the key/value data packed per block.
+    size_t block_size = 4096;
+
+    // Number of keys between restart points for delta encoding of keys.
+    int block_restart_interval = 16;
+};
+
+/*
+ * Builds a sorted table file from keys added in order:
+ *
+ *     data block 1 .. data block n
+ *     metaindex block (empty)
+ *     index block
+ *     footer
+ *
+ * Each block is followed by its type and a masked crc32c of the block
+ * and type. The index block has one entry per data block, keyed by the
+ * block's last key, whose value is the block's encoded BlockHandle.
+ *
+ * A data block goes to the file as soon as it is full, so building
+ * holds one data block and the index block in memory, whatever the
+ * number of keys. Block buffers are reused, so adding a key allocates
+ * nothing once they have grown to their working size.
+ *
+ * Not thread-safe.
+ */
+class TableBuilder {
+public:
+    /*
+     * Create a builder that will store the contents of the table it is
+     * building in *file. Does not close the file. It is up to the
+     * caller to close the file after calling Finish().
+     */
+    TableBuilder(const TableOptions& options, WritableFile *file);
+
+    TableBuilder(const TableBuilder&) = delete;
+    TableBuilder& operator=(const TableBuilder&) = delete;
+
+    // REQUIRES: Either Finish() or Abandon() has been called.
+    ~TableBuilder();
+
+    /*
+     * Add key,value to the table being constructed.
+     * REQUIRES: key is after any previously added key in the order the
+     * table will be read in.
+     * REQUIRES: Finish(), Abandon() have not been called
+     */
+    void Add(const Slice& key, const Slice& value);
+
+    /*
+     * Writes the buffered data block to the file, if any. Can be used
+     * to ensure that two adjacent entries never live in the same data
+     * block. Most clients should not need to use this method.
+     * REQUIRES: Finish(), Abandon() have not been called
+     */
+    void Flush();
+
+    // Return non-ok iff some error has been detected.
+    Status status() const {
+        return _status;
+    }
+
+    /*
+     * Finish building the table. Stops using the file passed to the
+     * constructor after this function returns.
+     * REQUIRES: Finish(), Abandon() have not been called
+     */
+    Status Finish();
+
+    /*
+     * Indicate that the contents of this builder should be abandoned.
+     * Stops using the file passed to the constructor after this function
+     * returns.
+     * REQUIRES: Finish(), Abandon() have not been called
+     */
+    void Abandon();
+
+    // Number of calls to Add() so far.
+    uint64_t NumEntries() const {
+        return _num_entries;
+    }
+
+    // Size of the file generated so far.
+    uint64_t FileSize() const {
+        return _offset;
+    }
+
+private:
+    bool ok() const {
+        return _status.ok();
+    }
+
+    // Finishes *block, writes it, and resets it.
+    void WriteBlock(BlockBuilder *block, BlockHandle *handle);
+    void WriteRawBlock(const Slice& data, CompressionType type, BlockHandle *handle);
+
+    const TableOptions _options;
+    WritableFile *const _file;
+    uint64_t _offset;
+    Status _status;
+    BlockBuilder _data_block;
+    BlockBuilder _index_block;
+    uint64_t _num_entries;
+    bool _closed;  // Either Finish() or Abandon() has been called.
+
+    // Reused for every index entry's value.
+    string _handle_encoding;
+};
+
+/*
+ * Adds the entries of "*iter" from its current position to the end,
+ * then finishes the table. "Iterator" needs Valid(), Next(), key() and
+ * value(); for example MemTable::Iterator.
+ */
+template <typename Iterator>
+Status BuildTable(Iterator *iter, TableBuilder *builder) {
+    for (; iter->Valid() && builder->status().ok(); iter->Next()) {
+        builder->Add(iter->key(), iter->value());
+    }
+    if (!builder->status().ok()) {
+        builder->Abandon();
+        return builder->status();
+    }
+    return builder->Finish();
+}
+
+} // namespace leveldb.
@@ -0,0 +1,227 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table_builder.h"
+#include "db/memtable.h"
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/random.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+class StringDest : public WritableFile {
+public:
+    Status Close() override {
+        return Status::OK();
+    }
+    Status Flush() override {
+        return Status::OK();
+    }
+    Status Sync() override {
+        return Status::OK();
+    }
+    Status Append(const Slice& slice) override {
+        if (_fail) {
+            return Status::IOError("append failed");
+        }
+        _contents.append(slice.data(), slice.size());
+        return Status::OK();
+    }
+
+    string _contents;
+    bool _fail = false;
+};
+
+typedef vector<pair<string, string>> Entries;
+
+/*
+ * Decodes the block at "handle" in "file" into *entries, checking its
+ * trailer, and stores its restart count in *restarts.
+ */
+static void ReadBlock(const string& file, const BlockHandle& handle, Entries *entries,
+                      uint32_t *restarts) {
+    ASSERT_LE(handle.offset() + handle.size() + kBlockTrailerSize, file.size());
+    const char *data = file.data() + handle.offset();
+    const size_t n = handle.size();
+    ASSERT_EQ(kNoCompression, data[n]);
+    const uint32_t crc = crc32c::Unmask(DecodeFixed32(data + n + 1));
+    ASSERT_EQ(crc32c::Value(data, n + 1), crc);
+
+    ASSERT_GE(n, sizeof(uint32_t));
+    *restarts = DecodeFixed32(data + n - sizeof(uint32_t));
+    const char *limit = data + n - (1 + *restarts) * sizeof(uint32_t);
+    vector<uint32_t> restart_offsets;
+    for (uint32_t i = 0; i < *restarts; i++) {
+        restart_offsets.push_back(DecodeFixed32(limit + i * sizeof(uint32_t)));
+    }
+
+    string key;
+    size_t restart = 0;
+    for (const char *p = data; p < limit;) {
+        const bool at_restart = restart < restart_offsets.size() &&
+                                restart_offsets[restart] == static_cast<uint32_t>(p - data);
+        uint32_t shared, non_shared, value_length;
+        p = GetVarint32Ptr(p, limit, &shared);
+        p = GetVarint32Ptr(p, limit, &non_shared);
+        p = GetVarint32Ptr(p, limit, &value_length);
+        ASSERT_TRUE(p != nullptr);
+        if (at_restart) {
+            // Keys at restart points are stored whole.
+            ASSERT_EQ(0, shared);
+            restart++;
+        }
+        ASSERT_LE(shared, key.size());
+        key.resize(shared);
+        key.append(p, non_shared);
+        p += non_shared;
+        entries->emplace_back(key, string(p, value_length));
+        p += value_length;
+    }
+    if (!entries->empty()) {
+        ASSERT_EQ(restart_offsets.size(), restart);
+    }
+}
+
+/*
+ * Reads back every entry of a table through its footer and index, and
+ * the size of each data block.
+ */
+static void ReadTable(const string& file, Entries *entries, vector<uint64_t> *block_sizes) {
+    ASSERT_GE(file.size(), Footer::kEncodedLength);
+    Slice footer_input(file.data() + file.size() - Footer::kEncodedLength, Footer::kEncodedLength);
+    Footer footer;
+    ASSERT_TRUE(footer.DecodeFrom(&footer_input).ok());
+
+    Entries meta;
+    uint32_t restarts;
+    ReadBlock(file, footer.metaindex_handle(), &meta, &restarts);
+    ASSERT_TRUE(meta.empty());
+
+    Entries index;
+    ReadBlock(file, footer.index_handle(), &index, &restarts);
+    uint64_t offset = 0;
+    for (const auto& index_entry : index) {
+        Slice input(index_entry.second);
+        BlockHandle handle;
+        ASSERT_TRUE(handle.DecodeFrom(&input).ok());
+        ASSERT_EQ(offset, handle.offset());
+        offset += handle.size() + kBlockTrailerSize;
+        block_sizes->push_back(handle.size());
+
+        Entries block;
+        ReadBlock(file, handle, &block, &restarts);
+        ASSERT_FALSE(block.empty());
+        ASSERT_EQ((block.size() + 15) / 16, restarts);
+
+        // The index key is the block's last key.
+        ASSERT_EQ(block.back().first, index_entry.first);
+        entries->insert(entries->end(), block.begin(), block.end());
+    }
+    ASSERT_EQ(footer.metaindex_handle().offset(), offset);
+}
+
+TEST(TableBuilderTest, Empty)
+{
+    StringDest dest;
+    TableBuilder builder(TableOptions(), &dest);
+    ASSERT_TRUE(builder.Finish().ok());
+    ASSERT_EQ(dest._contents.size(), builder.FileSize());
+
+    Entries entries;
+    vector<uint64_t> blocks;
+    ReadTable(dest._contents, &entries, &blocks);
+    ASSERT_TRUE(entries.empty());
+    ASSERT_TRUE(blocks.empty());
+}
+
+TEST(TableBuilderTest, RoundTrip)
+{
+    Random rnd(301);
+    Entries expected;
+    for (int i = 0; i < 5000; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%08d", i * 7);
+        expected.emplace_back(key, string(rnd.Uniform(200), 'a' + i % 26));
+    }
+
+    StringDest dest;
+    TableBuilder builder(TableOptions(), &dest);
+    for (const auto& e : expected) {
+        builder.Add(e.first, e.second);
+    }
+    ASSERT_TRUE(builder.Finish().ok());
+    ASSERT_EQ(expected.size(), builder.NumEntries());
+    ASSERT_EQ(dest._contents.size(), builder.FileSize());
+
+    Entries entries;
+    vector<uint64_t> blocks;
+    ReadTable(dest._contents, &entries, &blocks);
+    ASSERT_EQ(expected, entries);
+
+    // Blocks close at the first entry reaching 4 KB.
+    ASSERT_GT(blocks.size(), 10);
+    for (size_t i = 0; i + 1 < blocks.size(); i++) {
+        ASSERT_GE(blocks[i], 4096);
+        ASSERT_LT(blocks[i], 4096 + 256);
+    }
+
+    // The keys are prefix compressed.
+    size_t raw = 0;
+    for (const auto& e : expected) {
+        raw += e.first.size() + e.second.size();
+    }
+    ASSERT_LT(dest._contents.size(), raw);
+}
+
+TEST(TableBuilderTest, FromMemTable)
+{
+    MemTable mem;
+    SequenceNumber seq = 1;
+    for (int i = 0; i < 1000; i++) {
+        const string key = "k" + to_string(i % 300);
+        mem.Add(seq++, kTypeValue, key, "value" + to_string(i));
+    }
+
+    StringDest dest;
+    TableBuilder builder(TableOptions(), &dest);
+    MemTable::Iterator iter(&mem);
+    iter.SeekToFirst();
+    ASSERT_TRUE(BuildTable(&iter, &builder).ok());
+
+    Entries entries;
+    vector<uint64_t> blocks;
+    ReadTable(dest._contents, &entries, &blocks);
+    ASSERT_EQ(1000, entries.size());
+
+    // The table holds the memtable's entries in the memtable's order.
+    iter.SeekToFirst();
+    for (const auto& e : entries) {
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(iter.key().ToString(), e.first);
+        ASSERT_EQ(iter.value().ToString(), e.second);
+        iter.Next();
+    }
+    ASSERT_FALSE(iter.Valid());
+}
+
+TEST(TableBuilderTest, WriteError)
+{
+    StringDest dest;
+    TableBuilder builder(TableOptions(), &dest);
+    dest._fail = true;
+    for (int i = 0; i < 1000; i++) {
+        builder.Add("key" + to_string(100000 + i), string(100, 'v'));
+    }
+    ASSERT_TRUE(builder.status().IsIOError());
+    ASSERT_TRUE(builder.Finish().IsIOError());
+}
+
+} // namespace leveldb.
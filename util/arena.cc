@@ -5,6 +5,7 @@
 #include "arena.h"
 
 #include <cassert>
+#include <cstdint>
 using namespace std;
 
 namespace leveldb {
@@ -82,7 +83,7 @@ char *
 Arena::AllocateNewBlock(size_t block_bytes) {
     char *result = new char[block_bytes];
     _blocks.push_back(result);
-    _memory_usage += block_bytes + sizeof(char *);
+    _memory_usage.fetch_add(block_bytes + sizeof(char *), memory_order_relaxed);
     return result;
 }
 
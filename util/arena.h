@@ -4,15 +4,25 @@
 
 #pragma once
 
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+#include <atomic>
 #include <cstddef>
 #include <vector>
 using namespace std;
 
 namespace leveldb {
 
-
+/*
+ * Allocates many small objects that are all freed with the arena.
+ *
+ * Allocate() and AllocateAligned() are not thread-safe. Their
+ * ...Concurrent() variants may be called from several threads at once,
+ * and serialize on a mutex, but must not run alongside the plain ones.
+ * MemoryUsage() may be called at any time.
+ */
 class Arena {
-// TODO: not thread safe currently, should check if there is such a need.
 public:
     Arena() : _alloc_ptr(nullptr),
               _alloc_bytes_remaining(0),
@@ -34,9 +44,20 @@ public:
     // Allocate memory with the normal alignment strategy.
     char *AllocateAligned(size_t bytes);
 
+    // Thread-safe Allocate() and AllocateAligned().
+    char *AllocateConcurrent(size_t bytes) EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        return Allocate(bytes);
+    }
+
+    char *AllocateAlignedConcurrent(size_t bytes) EXCLUDES(_mu) {
+        MutexLock l(&_mu);
+        return AllocateAligned(bytes);
+    }
+
     // Returns an estimate of the total memory usage of data allocated.
     size_t MemoryUsage() const {
-        return _memory_usage;
+        return _memory_usage.load(memory_order_relaxed);
     }
 
 private:
@@ -50,7 +71,10 @@ private:
     size_t _alloc_bytes_remaining;
 
     // Total memory usage of the arena.
-    size_t _memory_usage;
+    atomic<size_t> _memory_usage;
+
+    // Serializes the ...Concurrent() allocations.
+    port::Mutex _mu;
 
     // Array of new[] allocated memory blocks.
     vector<char *> _blocks;
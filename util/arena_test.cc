@@ -5,6 +5,10 @@
 #include "arena.h"
 #include "random.h"
 
+#include <cstring>
+
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 using namespace std;
 
@@ -64,4 +68,39 @@ TEST(ArenaTest, Simple) {
     }
 }
 
+TEST(ArenaTest, Concurrent) {
+    const int kThreads = 4;
+    const int kAllocations = 20000;
+    Arena arena;
+    vector<vector<pair<size_t, char *>>> allocated(kThreads);
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&arena, &allocated, t]() {
+            Random rnd(301 + t);
+            for (int i = 0; i < kAllocations; i++) {
+                const size_t s = 1 + (rnd.OneIn(100) ? rnd.Uniform(3000) : rnd.Uniform(50));
+                char *r = rnd.OneIn(2) ? arena.AllocateAlignedConcurrent(s)
+                                       : arena.AllocateConcurrent(s);
+                memset(r, t, s);
+                allocated[t].emplace_back(s, r);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    // No two threads were handed overlapping memory.
+    size_t bytes = 0;
+    for (int t = 0; t < kThreads; t++) {
+        for (const auto& a : allocated[t]) {
+            for (size_t b = 0; b < a.first; b++) {
+                ASSERT_EQ(t, a.second[b]);
+            }
+            bytes += a.first;
+        }
+    }
+    ASSERT_GE(arena.MemoryUsage(), bytes);
+}
+
 } // namespace leveldb.
\ No newline at end of file
@@ -0,0 +1,440 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+/*
+ * Coroutine support for multi-step asynchronous work on top of an Env.
+ *
+ *     Task<Status> Lookup(Env *env, RandomAccessFile *file, ...) {
+ *         Status s = co_await ReadAsync(env, file, index_offset, ...);
+ *         ...
+ *         s = co_await ReadAsync(env, file, block_offset, ...);
+ *         co_return s;
+ *     }
+ *
+ * A suspended coroutine holds no thread. Reads run on the threads of an
+ * AsyncIoPool, so as many of them proceed at once as the pool has
+ * threads, independently of the Env's background work. Yield() and
+ * SleepAsync() resume on the Env's single background thread instead,
+ * behind whatever work, such as a compaction, is queued there.
+ *
+ * The rest of leveldb builds as C++14, so this header is only usable from
+ * translation units compiled as C++20.
+ */
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include "leveldb/env.h"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+namespace leveldb {
+
+template <typename T>
+class Task;
+
+namespace async_internal {
+
+/*
+ * State shared by the promises of every Task<T>: who to resume once the
+ * coroutine finishes. A Task that is co_await'ed resumes its awaiter;
+ * a Task started by SyncWait() or WhenAll() calls "done(done_arg)".
+ */
+class PromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        coroutine_handle<> await_suspend(coroutine_handle<Promise> h) noexcept {
+            PromiseBase& promise = h.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            // The frame may be destroyed by "done"; do not touch it after.
+            void (*done)(void *) = promise.done;
+            void *done_arg = promise.done_arg;
+            if (done != nullptr) {
+                done(done_arg);
+            }
+            return noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    // leveldb does not use exceptions.
+    void unhandled_exception() const noexcept {
+        abort();
+    }
+
+    coroutine_handle<> continuation;
+    void (*done)(void *) = nullptr;
+    void *done_arg = nullptr;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) {
+        _value.emplace(std::forward<U>(value));
+    }
+
+    T& value() {
+        return *_value;
+    }
+
+private:
+    optional<T> _value;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void value() const noexcept {}
+};
+
+} // namespace async_internal
+
+/*
+ * The result of a coroutine producing a T. Tasks are lazy: the body does
+ * not run until the task is co_await'ed, or passed to SyncWait() or
+ * WhenAll(). A Task owns its coroutine frame and is move-only.
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = async_internal::Promise<T>;
+
+    Task() : _handle(nullptr) {}
+
+    explicit Task(coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) {
+                _handle.destroy();
+            }
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool Valid() const {
+        return static_cast<bool>(_handle);
+    }
+
+    bool Done() const {
+        return _handle.done();
+    }
+
+    // Starts the task and suspends the awaiting coroutine until it finishes.
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            coroutine_handle<> await_suspend(coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            decltype(auto) await_resume() {
+                return handle.promise().value();
+            }
+        };
+        assert(Valid());
+        return Awaiter{_handle};
+    }
+
+    /*
+     * Starts the task; "done(arg)" is called from whichever thread
+     * finishes it. The task must not be co_await'ed afterwards.
+     */
+    void Start(void (*done)(void *), void *arg) {
+        assert(Valid());
+        _handle.promise().done = done;
+        _handle.promise().done_arg = arg;
+        _handle.resume();
+    }
+
+    // REQUIRES: Done()
+    decltype(auto) Result() {
+        assert(Done());
+        return _handle.promise().value();
+    }
+
+private:
+    coroutine_handle<promise_type> _handle;
+};
+
+namespace async_internal {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace async_internal
+
+/*
+ * Runs "task" to completion, blocking the calling thread, and returns its
+ * result. Must not be called from a background work item of the Env the
+ * task runs on; it may deadlock.
+ */
+template <typename T>
+T SyncWait(Task<T> task) {
+    struct Event {
+        mutex mu;
+        condition_variable cv;
+        bool done = false;
+
+        static void Signal(void *arg) {
+            Event *event = reinterpret_cast<Event *>(arg);
+            lock_guard<mutex> l(event->mu);
+            event->done = true;
+            event->cv.notify_one();
+        }
+    };
+
+    Event event;
+    task.Start(&Event::Signal, &event);
+    {
+        unique_lock<mutex> l(event.mu);
+        event.cv.wait(l, [&event] { return event.done; });
+    }
+    if constexpr (is_void<T>::value) {
+        return;
+    } else {
+        return std::move(task.Result());
+    }
+}
+
+/*
+ * Starts every task in "tasks" and suspends the awaiting coroutine until
+ * all of them have finished. Results are read back with Task::Result().
+ */
+template <typename T>
+auto WhenAll(vector<Task<T>> *tasks) {
+    struct Awaiter {
+        vector<Task<T>> *tasks;
+        coroutine_handle<> awaiting;
+        // One per task, plus one held by await_suspend while starting them.
+        atomic<size_t> pending;
+
+        static void Finished(void *arg) {
+            Awaiter *self = reinterpret_cast<Awaiter *>(arg);
+            if (self->pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+                self->awaiting.resume();
+            }
+        }
+
+        bool await_ready() const noexcept {
+            return tasks->empty();
+        }
+
+        bool await_suspend(coroutine_handle<> h) noexcept {
+            awaiting = h;
+            pending.store(tasks->size() + 1, memory_order_relaxed);
+            for (Task<T>& task : *tasks) {
+                task.Start(&Finished, this);
+            }
+            // Stay suspended unless every task finished synchronously.
+            return pending.fetch_sub(1, memory_order_acq_rel) != 1;
+        }
+
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{tasks, nullptr, {0}};
+}
+
+/*
+ * Threads that perform blocking reads for ReadAsync(). Each thread has
+ * one read in flight, so the pool size bounds the I/O concurrency; it
+ * should cover the queue depth the device needs.
+ *
+ * The destructor finishes the queued reads. Thread-safe.
+ */
+class AsyncIoPool {
+public:
+    explicit AsyncIoPool(int num_threads) : _shutting_down(false) {
+        for (int i = 0; i < num_threads; i++) {
+            _threads.emplace_back([this]() { ThreadMain(); });
+        }
+    }
+
+    AsyncIoPool(const AsyncIoPool&) = delete;
+    AsyncIoPool& operator=(const AsyncIoPool&) = delete;
+
+    ~AsyncIoPool() {
+        {
+            lock_guard<mutex> l(_mu);
+            _shutting_down = true;
+        }
+        _cv.notify_all();
+        for (thread& t : _threads) {
+            t.join();
+        }
+    }
+
+    // Runs "work" on one of the pool's threads.
+    void Submit(function<void()> work) {
+        {
+            lock_guard<mutex> l(_mu);
+            _queue.push_back(std::move(work));
+        }
+        _cv.notify_one();
+    }
+
+private:
+    void ThreadMain() {
+        unique_lock<mutex> l(_mu);
+        while (true) {
+            _cv.wait(l, [this] { return _shutting_down || !_queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            function<void()> work = std::move(_queue.front());
+            _queue.pop_front();
+            l.unlock();
+            work();
+            l.lock();
+        }
+    }
+
+    mutex _mu;
+    condition_variable _cv;
+    deque<function<void()>> _queue;
+    bool _shutting_down;
+    vector<thread> _threads;
+};
+
+/*
+ * Reads up to "n" bytes at "offset" of "file" on a thread of "pool", then
+ * resumes the awaiting coroutine on that thread. The result of the
+ * co_await is the Status of the read; see RandomAccessFile::Read() for
+ * "result" and "scratch".
+ */
+inline auto ReadAsync(AsyncIoPool *pool, RandomAccessFile *file, uint64_t offset, size_t n,
+                      Slice *result, char *scratch) {
+    struct Awaiter {
+        AsyncIoPool *pool;
+        RandomAccessFile *file;
+        uint64_t offset;
+        size_t n;
+        Slice *result;
+        char *scratch;
+        Status status;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(coroutine_handle<> h) {
+            pool->Submit([this, h]() {
+                status = file->Read(offset, n, result, scratch);
+                h.resume();
+            });
+        }
+
+        Status await_resume() {
+            return std::move(status);
+        }
+    };
+    return Awaiter{pool, file, offset, n, result, scratch, Status()};
+}
+
+/*
+ * Suspends the awaiting coroutine and resumes it from the background
+ * thread of "env", behind the work already queued there. The coroutine
+ * then runs on that thread until its next suspension.
+ */
+inline auto Yield(Env *env) {
+    struct Awaiter {
+        Env *env;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(coroutine_handle<> h) {
+            env->Schedule([h](void *) { h.resume(); }, nullptr);
+        }
+
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{env};
+}
+
+// Suspends the awaiting coroutine for at least "micros" micro-seconds and
+// resumes it on the background thread of "env", like Yield().
+inline auto SleepAsync(Env *env, uint64_t micros) {
+    struct Awaiter {
+        Env *env;
+        uint64_t micros;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(coroutine_handle<> h) {
+            env->ScheduleAfter([h](void *) { h.resume(); }, nullptr, micros);
+        }
+
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{env, micros};
+}
+
+} // namespace leveldb.
+
+#endif
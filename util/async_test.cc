@@ -0,0 +1,206 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/async.h"
+
+#include "helpers/memenv/memenv.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+class AsyncTest : public testing::Test {
+public:
+    AsyncTest() : _env(NewMemEnv(Env::Default())), _file(nullptr), _pool(4) {
+        // Record i holds its own index and the offset of record i + 1.
+        WritableFile *writable_file;
+        EXPECT_TRUE(_env->NewWritableFile("/f", &writable_file).ok());
+        for (int i = 0; i < kRecords; i++) {
+            char record[kRecordSize + 1];
+            snprintf(record, sizeof(record), "%07d %07d", i, ((i + 1) % kRecords) * kRecordSize);
+            EXPECT_TRUE(writable_file->Append(Slice(record, kRecordSize)).ok());
+        }
+        EXPECT_TRUE(writable_file->Close().ok());
+        delete writable_file;
+        EXPECT_TRUE(_env->NewRandomAccessFile("/f", &_file).ok());
+    }
+
+    ~AsyncTest() {
+        delete _file;
+        delete _env;
+    }
+
+    static const int kRecords = 1000;
+    static const int kRecordSize = 15;
+
+    Env *_env;
+    RandomAccessFile *_file;
+    AsyncIoPool _pool;
+};
+
+static Task<int> Add(int a, int b) {
+    co_return a + b;
+}
+
+static Task<int> AddThree(int a, int b, int c) {
+    int ab = co_await Add(a, b);
+    co_return co_await Add(ab, c);
+}
+
+TEST_F(AsyncTest, NestedTasks) {
+    ASSERT_EQ(6, SyncWait(AddThree(1, 2, 3)));
+
+    // Nothing runs before the task is started.
+    bool ran = false;
+    auto body = [](bool *ran) -> Task<void> {
+        *ran = true;
+        co_return;
+    };
+    Task<void> task = body(&ran);
+    ASSERT_FALSE(ran);
+    SyncWait(std::move(task));
+    ASSERT_TRUE(ran);
+}
+
+// Reads record "index", then follows it to the next record.
+static Task<Status> ReadChain(AsyncIoPool *pool, RandomAccessFile *file, int index, string *out) {
+    char scratch[AsyncTest::kRecordSize];
+    Slice record;
+    Status s = co_await ReadAsync(pool, file, index * AsyncTest::kRecordSize,
+                                  AsyncTest::kRecordSize, &record, scratch);
+    if (!s.ok()) {
+        co_return s;
+    }
+    out->assign(record.data(), 7);
+
+    // The record is not NUL-terminated.
+    const uint64_t next_offset = stoull(string(record.data() + 8, 7));
+    s = co_await ReadAsync(pool, file, next_offset, AsyncTest::kRecordSize, &record, scratch);
+    if (s.ok()) {
+        out->append(" ");
+        out->append(record.data(), 7);
+    }
+    co_return s;
+}
+
+TEST_F(AsyncTest, ReadAsync) {
+    string out;
+    ASSERT_TRUE(SyncWait(ReadChain(&_pool, _file, 41, &out)).ok());
+    ASSERT_EQ("0000041 0000042", out);
+
+    ASSERT_TRUE(SyncWait(ReadChain(&_pool, _file, kRecords - 1, &out)).ok());
+    ASSERT_EQ("0000999 0000000", out);
+
+    // Reads past the end of the file fail.
+    ASSERT_FALSE(SyncWait(ReadChain(&_pool, _file, kRecords + 1, &out)).ok());
+}
+
+TEST_F(AsyncTest, WhenAll) {
+    const int kTasks = 5000;
+    vector<string> outs(kTasks);
+    vector<Task<Status>> tasks;
+    for (int i = 0; i < kTasks; i++) {
+        tasks.push_back(ReadChain(&_pool, _file, i % kRecords, &outs[i]));
+    }
+
+    auto run = [](vector<Task<Status>> *tasks) -> Task<void> {
+        co_await WhenAll(tasks);
+    };
+    SyncWait(run(&tasks));
+
+    for (int i = 0; i < kTasks; i++) {
+        ASSERT_TRUE(tasks[i].Done());
+        ASSERT_TRUE(tasks[i].Result().ok());
+        char expected[20];
+        snprintf(expected, sizeof(expected), "%07d %07d", i % kRecords, (i + 1) % kRecords);
+        ASSERT_EQ(expected, outs[i]);
+    }
+
+    // Waiting for nothing completes immediately.
+    vector<Task<Status>> none;
+    SyncWait(run(&none));
+}
+
+// Blocks every read until "expected" reads are in flight at once.
+class RendezvousFile : public RandomAccessFile {
+public:
+    RendezvousFile(RandomAccessFile *target, int expected)
+        : _target(target), _expected(expected), _arrived(0) {}
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+        {
+            unique_lock<mutex> l(_mu);
+            _arrived++;
+            _cv.notify_all();
+            if (!_cv.wait_for(l, chrono::seconds(10), [this] { return _arrived >= _expected; })) {
+                return Status::IOError("reads did not overlap");
+            }
+        }
+        return _target->Read(offset, n, result, scratch);
+    }
+
+private:
+    RandomAccessFile *const _target;
+    const int _expected;
+    mutable mutex _mu;
+    mutable condition_variable _cv;
+    mutable int _arrived;
+};
+
+TEST_F(AsyncTest, ReadsRunConcurrently) {
+    const int kTasks = 4;
+    RendezvousFile file(_file, kTasks);
+
+    // Keep the Env's background thread busy; reads must not need it.
+    mutex mu;
+    condition_variable cv;
+    bool release = false;
+    Env::Default()->Schedule([&](void *) {
+        unique_lock<mutex> l(mu);
+        cv.wait(l, [&] { return release; });
+    }, nullptr);
+
+    vector<string> outs(kTasks);
+    vector<Task<Status>> tasks;
+    for (int i = 0; i < kTasks; i++) {
+        tasks.push_back(ReadChain(&_pool, &file, i, &outs[i]));
+    }
+    auto run = [](vector<Task<Status>> *tasks) -> Task<void> {
+        co_await WhenAll(tasks);
+    };
+    SyncWait(run(&tasks));
+
+    {
+        lock_guard<mutex> l(mu);
+        release = true;
+    }
+    cv.notify_all();
+    Env::Default()->ScheduleWithHandle([](void *) {}, nullptr).Wait();
+
+    for (int i = 0; i < kTasks; i++) {
+        ASSERT_TRUE(tasks[i].Result().ok());
+    }
+}
+
+TEST_F(AsyncTest, YieldAndSleep) {
+    auto body = [](Env *env) -> Task<uint64_t> {
+        const thread::id caller = this_thread::get_id();
+        co_await Yield(env);
+        EXPECT_NE(caller, this_thread::get_id());
+
+        const uint64_t start = env->NowMicros();
+        co_await SleepAsync(env, 20000);
+        co_return env->NowMicros() - start;
+    };
+    ASSERT_GE(SyncWait(body(Env::Default())), 20000);
+}
+
+} // namespace leveldb.
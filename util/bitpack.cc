@@ -0,0 +1,352 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "bitpack.h"
+
+#include "coding.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_BITPACK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace leveldb {
+namespace bitpack {
+
+namespace {
+
+const size_t kLanes = 4;
+const size_t kRows = kBlockSize / kLanes;
+
+inline uint32_t LowMask(int bits) {
+    return bits == 32 ? 0xffffffffu : (1u << bits) - 1;
+}
+
+// Bytes of a packed block that hold its first "n" values; the rest are
+// zero and are not stored.
+inline size_t PackedSize(size_t n, int bits) {
+    const size_t rows = (n + kLanes - 1) / kLanes;
+    return 16 * ((rows * bits + 31) / 32);
+}
+
+#if defined(LEVELDB_BITPACK_SSE2)
+
+// Fully unrolled rows turn every shift count into a constant.
+#if defined(__clang__)
+#define LEVELDB_UNROLL_ROWS _Pragma("unroll")
+#else
+#define LEVELDB_UNROLL_ROWS _Pragma("GCC unroll 32")
+#endif
+
+// SSE2 is part of x86-64, so these need no runtime check. One kernel per
+// width lets the compiler unroll the rows and use immediate shifts.
+template <size_t B>
+void PackSse2(const uint32_t *in, char *out) {
+    __m128i *o = reinterpret_cast<__m128i *>(out);
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(LowMask(B)));
+    __m128i acc = _mm_setzero_si128();
+    int shift = 0;
+    LEVELDB_UNROLL_ROWS
+    for (size_t row = 0; B > 0 && row < kRows; row++) {
+        const __m128i v = _mm_and_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + row * kLanes)), mask);
+        acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+        shift += B;
+        if (shift >= 32) {
+            _mm_storeu_si128(o++, acc);
+            shift -= 32;
+            acc = shift > 0 ? _mm_srl_epi32(v, _mm_cvtsi32_si128(B - shift)) : _mm_setzero_si128();
+        }
+    }
+}
+
+template <size_t B>
+void UnpackSse2(const char *in, uint32_t *out) {
+    if (B == 0) {
+        memset(out, 0, kBlockSize * sizeof(uint32_t));
+        return;
+    }
+    const __m128i *p = reinterpret_cast<const __m128i *>(in);
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(LowMask(B)));
+    __m128i w = _mm_loadu_si128(p++);
+    int shift = 0;
+    LEVELDB_UNROLL_ROWS
+    for (size_t row = 0; row < kRows; row++) {
+        __m128i v = _mm_srl_epi32(w, _mm_cvtsi32_si128(shift));
+        if (shift + B > 32) {
+            // The value continues in the next word.
+            w = _mm_loadu_si128(p++);
+            v = _mm_or_si128(v, _mm_sll_epi32(w, _mm_cvtsi32_si128(32 - shift)));
+            shift = shift + B - 32;
+        } else if (shift + B == 32) {
+            // The last word of the block ends exactly with the last row.
+            if (row + 1 < kRows) {
+                w = _mm_loadu_si128(p++);
+            }
+            shift = 0;
+        } else {
+            shift += B;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + row * kLanes), _mm_and_si128(v, mask));
+    }
+}
+
+using PackFunction = void (*)(const uint32_t *, char *);
+using UnpackFunction = void (*)(const char *, uint32_t *);
+
+template <size_t... B>
+constexpr array<PackFunction, sizeof...(B)> MakePackKernels(index_sequence<B...>) {
+    return {{&PackSse2<B>...}};
+}
+
+template <size_t... B>
+constexpr array<UnpackFunction, sizeof...(B)> MakeUnpackKernels(index_sequence<B...>) {
+    return {{&UnpackSse2<B>...}};
+}
+
+const array<PackFunction, 33> kPackKernels = MakePackKernels(make_index_sequence<33>());
+const array<UnpackFunction, 33> kUnpackKernels = MakeUnpackKernels(make_index_sequence<33>());
+
+#endif
+
+// Turns decoded differences into values, in place: undoes the zigzag
+// encoding if "zigzag", then takes the prefix sums starting from "first".
+void UndoDeltas(uint32_t *values, size_t n, uint32_t first, bool zigzag) {
+    size_t i = 0;
+    uint32_t sum = first;
+#if defined(LEVELDB_BITPACK_SSE2)
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i carry = _mm_set1_epi32(static_cast<int>(first));
+    for (; i + kLanes <= n; i += kLanes) {
+        __m128i *p = reinterpret_cast<__m128i *>(values + i);
+        __m128i x = _mm_loadu_si128(p);
+        if (zigzag) {
+            x = _mm_xor_si128(_mm_srli_epi32(x, 1),
+                              _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(x, one)));
+        }
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128(p, x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+    for (; i < n; i++) {
+        uint32_t d = values[i];
+        if (zigzag) {
+            d = (d >> 1) ^ (0u - (d & 1));
+        }
+        sum += d;
+        values[i] = sum;
+    }
+}
+
+// Appends the frame of reference block of values[0,n-1].
+void PutFrame(string *dst, const uint32_t *values, size_t n) {
+    uint32_t min = n > 0 ? *min_element(values, values + n) : 0;
+    uint32_t offsets[kBlockSize] = {};
+    for (size_t i = 0; i < n; i++) {
+        offsets[i] = values[i] - min;
+    }
+    const int bits = MaxBits(offsets, n);
+    PutVarint32(dst, min);
+    dst->push_back(static_cast<char>(bits));
+
+    char packed[16 * 32];
+    Pack(offsets, bits, packed);
+    dst->append(packed, PackedSize(n, bits));
+}
+
+const char *GetFrame(const char *p, const char *limit, uint32_t *values, size_t n) {
+    uint32_t min;
+    p = GetVarint32Ptr(p, limit, &min);
+    if (p == nullptr || p == limit) {
+        return nullptr;
+    }
+    const int bits = static_cast<uint8_t>(*p++);
+    if (bits > 32) {
+        return nullptr;
+    }
+    const size_t size = PackedSize(n, bits);
+    if (static_cast<size_t>(limit - p) < size) {
+        return nullptr;
+    }
+
+    if (n == kBlockSize) {
+        Unpack(p, bits, values);
+    } else {
+        // Restore the zero tail that was not stored.
+        char padded[16 * 32];
+        memcpy(padded, p, size);
+        memset(padded + size, 0, 16 * bits - size);
+        uint32_t decoded[kBlockSize];
+        Unpack(padded, bits, decoded);
+        memcpy(values, decoded, n * sizeof(uint32_t));
+    }
+    if (min != 0) {
+        for (size_t i = 0; i < n; i++) {
+            values[i] += min;
+        }
+    }
+    return p + size;
+}
+
+void PutDeltas(string *dst, const uint32_t *values, size_t n, bool zigzag) {
+    if (n == 0) {
+        return;
+    }
+    PutVarint32(dst, values[0]);
+    uint32_t deltas[kBlockSize];
+    for (size_t i = 1; i < n; i++) {
+        const uint32_t d = values[i] - values[i - 1];
+        deltas[i] = zigzag ? (d << 1) ^ (0u - (d >> 31)) : d;
+    }
+    // Slot 0 keeps the block full, so that whole blocks decode without a
+    // copy; it repeats a difference so it can not widen the frame.
+    deltas[0] = n > 1 ? deltas[1] : 0;
+    PutFrame(dst, deltas, n);
+}
+
+const char *GetDeltas(const char *p, const char *limit, uint32_t *values, size_t n, bool zigzag) {
+    if (n == 0) {
+        return p;
+    }
+    uint32_t first;
+    p = GetVarint32Ptr(p, limit, &first);
+    if (p == nullptr) {
+        return nullptr;
+    }
+    p = GetFrame(p, limit, values, n);
+    if (p == nullptr) {
+        return nullptr;
+    }
+    values[0] = 0;
+    UndoDeltas(values, n, first, zigzag);
+    return p;
+}
+
+} // namespace
+
+int
+MaxBits(const uint32_t *values, size_t n)
+{
+    uint32_t all = 0;
+    for (size_t i = 0; i < n; i++) {
+        all |= values[i];
+    }
+    int bits = 0;
+    while (all != 0) {
+        all >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+void
+PackPortable(const uint32_t *in, int bits, char *out)
+{
+    memset(out, 0, 16 * bits);
+    const uint32_t mask = LowMask(bits);
+    for (size_t lane = 0; bits > 0 && lane < kLanes; lane++) {
+        size_t bit_pos = 0;
+        for (size_t row = 0; row < kRows; row++) {
+            const uint32_t v = in[row * kLanes + lane] & mask;
+            const int offset = bit_pos % 32;
+            char *word = out + 4 * ((bit_pos / 32) * kLanes + lane);
+            EncodeFixed32(word, DecodeFixed32(word) | (v << offset));
+            if (offset + bits > 32) {
+                char *next = word + 4 * kLanes;
+                EncodeFixed32(next, DecodeFixed32(next) | (v >> (32 - offset)));
+            }
+            bit_pos += bits;
+        }
+    }
+}
+
+void
+UnpackPortable(const char *in, int bits, uint32_t *out)
+{
+    const uint32_t mask = LowMask(bits);
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        size_t bit_pos = 0;
+        for (size_t row = 0; row < kRows; row++) {
+            uint32_t v = 0;
+            if (bits > 0) {
+                const int offset = bit_pos % 32;
+                const char *word = in + 4 * ((bit_pos / 32) * kLanes + lane);
+                v = DecodeFixed32(word) >> offset;
+                if (offset + bits > 32) {
+                    v |= DecodeFixed32(word + 4 * kLanes) << (32 - offset);
+                }
+            }
+            out[row * kLanes + lane] = v & mask;
+            bit_pos += bits;
+        }
+    }
+}
+
+void
+Pack(const uint32_t *in, int bits, char *out)
+{
+#if defined(LEVELDB_BITPACK_SSE2)
+    kPackKernels[bits](in, out);
+#else
+    PackPortable(in, bits, out);
+#endif
+}
+
+void
+Unpack(const char *in, int bits, uint32_t *out)
+{
+#if defined(LEVELDB_BITPACK_SSE2)
+    kUnpackKernels[bits](in, out);
+#else
+    UnpackPortable(in, bits, out);
+#endif
+}
+
+void
+PutBlock(string *dst, const uint32_t *values, size_t n)
+{
+    PutFrame(dst, values, n);
+}
+
+const char *
+GetBlock(const char *p, const char *limit, uint32_t *values, size_t n)
+{
+    return GetFrame(p, limit, values, n);
+}
+
+void
+PutDeltaBlock(string *dst, const uint32_t *values, size_t n)
+{
+    PutDeltas(dst, values, n, false);
+}
+
+const char *
+GetDeltaBlock(const char *p, const char *limit, uint32_t *values, size_t n)
+{
+    return GetDeltas(p, limit, values, n, false);
+}
+
+void
+PutZigZagDeltaBlock(string *dst, const uint32_t *values, size_t n)
+{
+    PutDeltas(dst, values, n, true);
+}
+
+const char *
+GetZigZagDeltaBlock(const char *p, const char *limit, uint32_t *values, size_t n)
+{
+    return GetDeltas(p, limit, values, n, true);
+}
+
+} // namespace bitpack.
+} // namespace leveldb.
@@ -0,0 +1,71 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+namespace bitpack {
+
+/*
+ * Compact blocks of integers: sequence numbers, lengths and offsets as
+ * stored in index and metadata blocks.
+ *
+ * Values are packed kBlockSize at a time with a fixed number of bits
+ * each, in four interleaved 32-bit lanes: value i goes to lane i % 4, so
+ * that one SSE2 register holds four consecutive values and packing and
+ * unpacking shift whole registers. A packed block of "bits" bits takes
+ * 16 * bits bytes.
+ *
+ * On top of that, the Put...Block() functions append up to kBlockSize
+ * values as a self-describing block of
+ *
+ *     frame of reference    varint32 min, byte bits, packed (v[i] - min)
+ *     delta                 varint32 v[0], then the frame of reference
+ *                           block of v[i] - v[i-1] (slot 0 is unused)
+ *     zigzag delta          the same, with the differences zigzag
+ *                           encoded so that decreases stay small
+ *
+ * and the Get...Block() functions decode one into a caller supplied array
+ * without allocating. All arithmetic is modulo 2^32, so every sequence
+ * round-trips; the delta form is compact for non-decreasing sequences and
+ * the zigzag form for sequences that move both ways.
+ */
+
+static const size_t kBlockSize = 128;
+
+// The number of bits needed to hold every one of values[0,n-1].
+int MaxBits(const uint32_t *values, size_t n);
+
+// Packs in[0,kBlockSize-1] with "bits" bits each into out[0,16*bits-1].
+// Bits of the values above "bits" are dropped.
+// REQUIRES: 0 <= bits <= 32
+void Pack(const uint32_t *in, int bits, char *out);
+
+// Reverses Pack().
+void Unpack(const char *in, int bits, uint32_t *out);
+
+// Pack() and Unpack() without SIMD. Exposed for testing.
+void PackPortable(const uint32_t *in, int bits, char *out);
+void UnpackPortable(const char *in, int bits, uint32_t *out);
+
+// Each Put...Block() appends values[0,n-1] to *dst, and the matching
+// Get...Block() decodes the n values at [p..limit-1] into values[0,n-1],
+// returning a pointer just past them, or nullptr on malformed input.
+// REQUIRES: n <= kBlockSize
+void PutBlock(string *dst, const uint32_t *values, size_t n);
+const char *GetBlock(const char *p, const char *limit, uint32_t *values, size_t n);
+
+void PutDeltaBlock(string *dst, const uint32_t *values, size_t n);
+const char *GetDeltaBlock(const char *p, const char *limit, uint32_t *values, size_t n);
+
+void PutZigZagDeltaBlock(string *dst, const uint32_t *values, size_t n);
+const char *GetZigZagDeltaBlock(const char *p, const char *limit, uint32_t *values, size_t n);
+
+} // namespace bitpack.
+} // namespace leveldb.
@@ -0,0 +1,148 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "bitpack.h"
+
+#include "random.h"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+namespace bitpack {
+
+static uint32_t Random32(Random *rnd) {
+    return (rnd->Uniform(1 << 16) << 16) ^ rnd->Uniform(1 << 16);
+}
+
+TEST(Bitpack, MaxBits) {
+    const uint32_t values[] = {0, 5, 1, 0x80000000u};
+    ASSERT_EQ(0, MaxBits(values, 1));
+    ASSERT_EQ(3, MaxBits(values, 3));
+    ASSERT_EQ(32, MaxBits(values, 4));
+    ASSERT_EQ(0, MaxBits(values, 0));
+}
+
+TEST(Bitpack, PackUnpack) {
+    Random rnd(301);
+    for (int bits = 0; bits <= 32; bits++) {
+        const uint32_t mask = bits == 32 ? 0xffffffffu : (1u << bits) - 1;
+        uint32_t in[kBlockSize];
+        for (uint32_t& v : in) {
+            v = Random32(&rnd);
+        }
+
+        // Both implementations write the same bytes, and drop the bits
+        // above "bits".
+        string packed(16 * bits, '\0');
+        string portable(16 * bits, '\0');
+        Pack(in, bits, &packed[0]);
+        PackPortable(in, bits, &portable[0]);
+        ASSERT_EQ(portable, packed) << bits << " bits";
+
+        uint32_t out[kBlockSize + 1];
+        uint32_t out_portable[kBlockSize];
+        out[kBlockSize] = 0xdeadbeef;
+        Unpack(packed.data(), bits, out);
+        UnpackPortable(packed.data(), bits, out_portable);
+        ASSERT_EQ(0xdeadbeef, out[kBlockSize]) << "wrote past the end";
+        for (size_t i = 0; i < kBlockSize; i++) {
+            ASSERT_EQ(in[i] & mask, out[i]) << bits << " bits, value " << i;
+            ASSERT_EQ(in[i] & mask, out_portable[i]) << bits << " bits, value " << i;
+        }
+    }
+}
+
+// The shapes of integer columns: sorted, sorted with a fixed stride,
+// clustered around a base, and unrelated.
+static vector<uint32_t> Column(Random *rnd, int shape, size_t n) {
+    vector<uint32_t> values(n);
+    uint32_t v = Random32(rnd);
+    for (size_t i = 0; i < n; i++) {
+        switch (shape) {
+            case 0:
+                v += rnd->Uniform(1000);
+                break;
+            case 1:
+                v += 4096;
+                break;
+            case 2:
+                v = 1000000 + rnd->Uniform(300) - 150;
+                break;
+            default:
+                v = Random32(rnd);
+                break;
+        }
+        values[i] = v;
+    }
+    return values;
+}
+
+TEST(Bitpack, BlocksRoundTrip) {
+    using PutFunction = void (*)(string *, const uint32_t *, size_t);
+    using GetFunction = const char *(*)(const char *, const char *, uint32_t *, size_t);
+    const struct {
+        PutFunction put;
+        GetFunction get;
+    } kEncodings[] = {
+        {&PutBlock, &GetBlock},
+        {&PutDeltaBlock, &GetDeltaBlock},
+        {&PutZigZagDeltaBlock, &GetZigZagDeltaBlock},
+    };
+
+    Random rnd(301);
+    for (size_t n : {0, 1, 2, 3, 4, 5, 31, 64, 127, 128}) {
+        for (int shape = 0; shape < 4; shape++) {
+            for (const auto& encoding : kEncodings) {
+                const vector<uint32_t> values = Column(&rnd, shape, n);
+                string s;
+                encoding.put(&s, values.data(), n);
+                // Decoders must not read past what they were given.
+                const size_t size = s.size();
+                s.append("trailer");
+
+                vector<uint32_t> decoded(n + 1, 0xdeadbeef);
+                const char *end = encoding.get(s.data(), s.data() + size, decoded.data(), n);
+                ASSERT_EQ(s.data() + size, end) << "n " << n << " shape " << shape;
+                ASSERT_EQ(0xdeadbeef, decoded[n]) << "wrote past the end";
+                decoded.resize(n);
+                ASSERT_EQ(values, decoded) << "n " << n << " shape " << shape;
+
+                for (size_t len = 0; len < size; len++) {
+                    ASSERT_TRUE(encoding.get(s.data(), s.data() + len, decoded.data(), n) == nullptr);
+                }
+            }
+        }
+    }
+}
+
+TEST(Bitpack, CompactColumns) {
+    Random rnd(301);
+
+    // A fixed stride needs no packed bits at all.
+    vector<uint32_t> values = Column(&rnd, 1, kBlockSize);
+    string s;
+    PutDeltaBlock(&s, values.data(), values.size());
+    ASSERT_LE(s.size(), 8);
+
+    // Small steps pack into 10 bits, against 2 or 3 varint bytes.
+    values = Column(&rnd, 0, kBlockSize);
+    s.clear();
+    PutDeltaBlock(&s, values.data(), values.size());
+    ASSERT_LE(s.size(), 10 + 16 * 10);
+
+    // Values that move both ways stay small as zigzag differences.
+    values = Column(&rnd, 2, kBlockSize);
+    s.clear();
+    PutZigZagDeltaBlock(&s, values.data(), values.size());
+    ASSERT_LE(s.size(), 10 + 16 * 10);
+    s.clear();
+    PutBlock(&s, values.data(), values.size());
+    ASSERT_LE(s.size(), 10 + 16 * 9);
+}
+
+} // namespace bitpack.
+} // namespace leveldb.
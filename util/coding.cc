@@ -0,0 +1,272 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "coding.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_CODING_SSSE3 1
+#include <immintrin.h>
+#endif
+
+namespace leveldb {
+
+void PutFixed32(string *dst, uint32_t value) {
+  char buf[sizeof(value)];
+  EncodeFixed32(buf, value);
+  dst->append(buf, sizeof(buf));
+}
+
+void PutFixed64(string *dst, uint64_t value) {
+  char buf[sizeof(value)];
+  EncodeFixed64(buf, value);
+  dst->append(buf, sizeof(buf));
+}
+
+char *EncodeVarint32(char *dst, uint32_t v) {
+  // Operate on characters as unsigneds
+  uint8_t *ptr = reinterpret_cast<uint8_t *>(dst);
+  static const int B = 128;
+  if (v < (1 << 7)) {
+    *(ptr++) = v;
+  } else if (v < (1 << 14)) {
+    *(ptr++) = v | B;
+    *(ptr++) = v >> 7;
+  } else if (v < (1 << 21)) {
+    *(ptr++) = v | B;
+    *(ptr++) = (v >> 7) | B;
+    *(ptr++) = v >> 14;
+  } else if (v < (1 << 28)) {
+    *(ptr++) = v | B;
+    *(ptr++) = (v >> 7) | B;
+    *(ptr++) = (v >> 14) | B;
+    *(ptr++) = v >> 21;
+  } else {
+    *(ptr++) = v | B;
+    *(ptr++) = (v >> 7) | B;
+    *(ptr++) = (v >> 14) | B;
+    *(ptr++) = (v >> 21) | B;
+    *(ptr++) = v >> 28;
+  }
+  return reinterpret_cast<char *>(ptr);
+}
+
+char *EncodeVarint64(char *dst, uint64_t v) {
+  static const int B = 128;
+  uint8_t *ptr = reinterpret_cast<uint8_t *>(dst);
+  while (v >= B) {
+    *(ptr++) = v | B;
+    v >>= 7;
+  }
+  *(ptr++) = static_cast<uint8_t>(v);
+  return reinterpret_cast<char *>(ptr);
+}
+
+void PutVarint64(string *dst, uint64_t v) {
+  if (v < 128) {
+    dst->push_back(static_cast<char>(v));
+    return;
+  }
+  char buf[10];
+  char *ptr = EncodeVarint64(buf, v);
+  dst->append(buf, ptr - buf);
+}
+
+void PutLengthPrefixedSlice(string *dst, const Slice& value) {
+  PutVarint32(dst, value.size());
+  dst->append(value.data(), value.size());
+}
+
+const char *GetVarint32PtrFallback(const char *p, const char *limit, uint32_t *value) {
+  uint32_t result = 0;
+  for (uint32_t shift = 0; shift <= 28 && p < limit; shift += 7) {
+    uint32_t byte = *(reinterpret_cast<const uint8_t *>(p));
+    p++;
+    if (byte & 128) {
+      // More bytes are present
+      result |= ((byte & 127) << shift);
+    } else {
+      result |= (byte << shift);
+      *value = result;
+      return reinterpret_cast<const char *>(p);
+    }
+  }
+  return nullptr;
+}
+
+bool GetVarint32(Slice *input, uint32_t *value) {
+  const char *p = input->data();
+  const char *limit = p + input->size();
+  const char *q = GetVarint32Ptr(p, limit, value);
+  if (q == nullptr) {
+    return false;
+  }
+  *input = Slice(q, limit - q);
+  return true;
+}
+
+const char *GetVarint64PtrFallback(const char *p, const char *limit, uint64_t *value) {
+  uint64_t result = 0;
+  for (uint32_t shift = 0; shift <= 63 && p < limit; shift += 7) {
+    uint64_t byte = *(reinterpret_cast<const uint8_t *>(p));
+    p++;
+    if (byte & 128) {
+      // More bytes are present
+      result |= ((byte & 127) << shift);
+    } else {
+      result |= (byte << shift);
+      *value = result;
+      return reinterpret_cast<const char *>(p);
+    }
+  }
+  return nullptr;
+}
+
+bool GetVarint64(Slice *input, uint64_t *value) {
+  const char *p = input->data();
+  const char *limit = p + input->size();
+  const char *q = GetVarint64Ptr(p, limit, value);
+  if (q == nullptr) {
+    return false;
+  }
+  *input = Slice(q, limit - q);
+  return true;
+}
+
+bool GetLengthPrefixedSlice(Slice *input, Slice *result) {
+  uint32_t len;
+  if (GetVarint32(input, &len) && input->size() >= len) {
+    *result = Slice(input->data(), len);
+    input->remove_prefix(len);
+    return true;
+  }
+  return false;
+}
+
+const char *GetVarint32ArrayPortable(const char *p, const char *limit, uint32_t *values,
+                                     size_t n) {
+  for (size_t i = 0; i < n && p != nullptr; i++) {
+    p = GetVarint32Ptr(p, limit, &values[i]);
+  }
+  return p;
+}
+
+namespace {
+
+#if defined(LEVELDB_CODING_SSSE3)
+
+/*
+ * How to decode the leading one and two byte varints of 8 input bytes,
+ * indexed by the continuation bits of those bytes. "shuffle" moves varint
+ * j into 16-bit lane j, zero extending one byte varints; decoding stops at
+ * the first varint that is longer or not complete in the 8 bytes.
+ */
+struct VarintShuffle {
+  uint8_t shuffle[16];
+  uint8_t count;
+  uint8_t consumed;
+};
+
+struct VarintShuffleTable {
+  VarintShuffle entries[256] = {};
+
+  constexpr VarintShuffleTable() {
+    for (int mask = 0; mask < 256; mask++) {
+      VarintShuffle& e = entries[mask];
+      for (int j = 0; j < 16; j++) {
+        e.shuffle[j] = 0x80;  // pshufb writes zero.
+      }
+      int pos = 0;
+      int count = 0;
+      while (pos < 8) {
+        if ((mask & (1 << pos)) == 0) {
+          e.shuffle[2 * count] = pos;
+          pos += 1;
+        } else if (pos + 1 < 8 && (mask & (1 << (pos + 1))) == 0) {
+          e.shuffle[2 * count] = pos;
+          e.shuffle[2 * count + 1] = pos + 1;
+          pos += 2;
+        } else {
+          break;
+        }
+        count++;
+      }
+      e.count = count;
+      e.consumed = pos;
+    }
+  }
+};
+
+constexpr VarintShuffleTable kVarintShuffles;
+
+__attribute__((target("ssse3")))
+const char *GetVarint32ArraySsse3(const char *p, const char *limit, uint32_t *values, size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i low_bits = _mm_set1_epi16(0x007f);
+  const __m128i high_bits = _mm_set1_epi16(0x3f80);
+  size_t i = 0;
+
+  // Whole 16 byte loads only, and only while 16 output slots remain, so
+  // that neither the loads nor the stores can run past an end.
+  while (n - i >= 16 && limit - p >= 16) {
+    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const int continuation = _mm_movemask_epi8(input);
+    if (continuation == 0) {
+      // Sixteen one byte varints.
+      const __m128i lo = _mm_unpacklo_epi8(input, zero);
+      const __m128i hi = _mm_unpackhi_epi8(input, zero);
+      __m128i *out = reinterpret_cast<__m128i *>(values + i);
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+      p += 16;
+      i += 16;
+      continue;
+    }
+
+    const VarintShuffle& e = kVarintShuffles.entries[continuation & 0xff];
+    if (e.count == 0) {
+      // A varint of three or more bytes, or one crossing the 8 byte window.
+      p = GetVarint32Ptr(p, limit, &values[i]);
+      if (p == nullptr) {
+        return nullptr;
+      }
+      i++;
+      continue;
+    }
+    const __m128i shuffled = _mm_shuffle_epi8(
+        input, _mm_loadu_si128(reinterpret_cast<const __m128i *>(e.shuffle)));
+    const __m128i decoded = _mm_or_si128(_mm_and_si128(shuffled, low_bits),
+                                         _mm_and_si128(_mm_srli_epi16(shuffled, 1), high_bits));
+    __m128i *out = reinterpret_cast<__m128i *>(values + i);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(decoded, zero));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(decoded, zero));
+    p += e.consumed;
+    i += e.count;
+  }
+  return GetVarint32ArrayPortable(p, limit, values + i, n - i);
+}
+
+#endif
+
+using Varint32ArrayFunction = const char *(*)(const char *, const char *, uint32_t *, size_t);
+
+Varint32ArrayFunction ChooseVarint32Array() {
+#if defined(LEVELDB_CODING_SSSE3)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3")) {
+    return &GetVarint32ArraySsse3;
+  }
+#endif
+  return &GetVarint32ArrayPortable;
+}
+
+}  // namespace
+
+const char *GetVarint32Array(const char *p, const char *limit, uint32_t *values, size_t n) {
+  static const Varint32ArrayFunction decode = ChooseVarint32Array();
+  return decode(p, limit, values, n);
+}
+
+} // namespace leveldb.
@@ -10,10 +10,60 @@
  */
 
 #pragma once
+
+#include "leveldb/slice.h"
+
 #include <cstdint>
+#include <string>
+using namespace std;
 
 namespace leveldb {
 
+// Standard Put... routines append to a string
+void PutFixed32(string *dst, uint32_t value);
+void PutFixed64(string *dst, uint64_t value);
+void PutVarint64(string *dst, uint64_t value);
+void PutLengthPrefixedSlice(string *dst, const Slice& value);
+
+// Standard Get... routines parse a value from the beginning of a Slice
+// and advance the slice past the parsed value.
+bool GetVarint32(Slice *input, uint32_t *value);
+bool GetVarint64(Slice *input, uint64_t *value);
+bool GetLengthPrefixedSlice(Slice *input, Slice *result);
+
+// Lower-level versions of Put... that write directly into a character buffer
+// and return a pointer just past the last byte written.
+// REQUIRES: dst has enough space for the value being written
+char *EncodeVarint32(char *dst, uint32_t value);
+char *EncodeVarint64(char *dst, uint64_t value);
+
+// Lower-level versions of Put... that write directly into a character buffer
+// REQUIRES: dst has enough space for the value being written
+
+inline void EncodeFixed32(char *dst, uint32_t value) {
+  uint8_t * const buffer = reinterpret_cast<uint8_t *>(dst);
+
+  // Recent clang and gcc optimize this to a single mov / str instruction.
+  buffer[0] = static_cast<uint8_t>(value);
+  buffer[1] = static_cast<uint8_t>(value >> 8);
+  buffer[2] = static_cast<uint8_t>(value >> 16);
+  buffer[3] = static_cast<uint8_t>(value >> 24);
+}
+
+inline void EncodeFixed64(char *dst, uint64_t value) {
+  uint8_t * const buffer = reinterpret_cast<uint8_t *>(dst);
+
+  // Recent clang and gcc optimize this to a single mov / str instruction.
+  buffer[0] = static_cast<uint8_t>(value);
+  buffer[1] = static_cast<uint8_t>(value >> 8);
+  buffer[2] = static_cast<uint8_t>(value >> 16);
+  buffer[3] = static_cast<uint8_t>(value >> 24);
+  buffer[4] = static_cast<uint8_t>(value >> 32);
+  buffer[5] = static_cast<uint8_t>(value >> 40);
+  buffer[6] = static_cast<uint8_t>(value >> 48);
+  buffer[7] = static_cast<uint8_t>(value >> 56);
+}
+
 // Lower-level versions of Get... that read directly from a character buffer
 // without any bounds checking.
 
@@ -26,4 +76,94 @@ inline uint32_t DecodeFixed32(const char *ptr) {
          (static_cast<uint32_t>(buffer[2]) << 16) |
          (static_cast<uint32_t>(buffer[3]) << 24);
 }
-} // namespace leveldb.
\ No newline at end of file
+
+inline uint64_t DecodeFixed64(const char *ptr) {
+  const uint8_t * const buffer = reinterpret_cast<const uint8_t *>(ptr);
+
+  // Recent clang and gcc optimize this to a single mov / ldr instruction.
+  return (static_cast<uint64_t>(buffer[0])) |
+         (static_cast<uint64_t>(buffer[1]) << 8) |
+         (static_cast<uint64_t>(buffer[2]) << 16) |
+         (static_cast<uint64_t>(buffer[3]) << 24) |
+         (static_cast<uint64_t>(buffer[4]) << 32) |
+         (static_cast<uint64_t>(buffer[5]) << 40) |
+         (static_cast<uint64_t>(buffer[6]) << 48) |
+         (static_cast<uint64_t>(buffer[7]) << 56);
+}
+
+/*
+ * Decodes the "n" consecutive varint32s at [p..limit-1] into values[0,n-1].
+ * Returns a pointer just past the last one, or nullptr if the input ends
+ * or holds a malformed varint before "n" values are decoded.
+ *
+ * Runs of one and two byte varints, the common case for lengths, offsets
+ * and deltas, are decoded 8 or 16 at a time with SSSE3 byte shuffles when
+ * the CPU has them.
+ */
+const char *GetVarint32Array(const char *p, const char *limit, uint32_t *values, size_t n);
+
+// GetVarint32Array() without SIMD. Exposed for testing.
+const char *GetVarint32ArrayPortable(const char *p, const char *limit, uint32_t *values,
+                                     size_t n);
+
+// Internal routines for use by the inline fast paths below.
+const char *GetVarint32PtrFallback(const char *p, const char *limit, uint32_t *value);
+const char *GetVarint64PtrFallback(const char *p, const char *limit, uint64_t *value);
+
+// Most varints are small: lengths of keys and values, tags. Decoding and
+// encoding values below 128 takes one compare and no loop.
+
+// Pointer-based variants of GetVarint...  These either store a value
+// in *v and return a pointer just past the parsed value, or return
+// nullptr on error.  These routines only look at bytes in the range
+// [p..limit-1]
+inline const char *GetVarint32Ptr(const char *p, const char *limit, uint32_t *value) {
+  if (p < limit) {
+    uint32_t result = *(reinterpret_cast<const uint8_t *>(p));
+    if ((result & 128) == 0) {
+      *value = result;
+      return p + 1;
+    }
+  }
+  return GetVarint32PtrFallback(p, limit, value);
+}
+
+inline const char *GetVarint64Ptr(const char *p, const char *limit, uint64_t *value) {
+  if (p < limit) {
+    uint64_t result = *(reinterpret_cast<const uint8_t *>(p));
+    if ((result & 128) == 0) {
+      *value = result;
+      return p + 1;
+    }
+  }
+  return GetVarint64PtrFallback(p, limit, value);
+}
+
+// Appends the varint32 encoding of "v" to "dst".
+inline void PutVarint32(string *dst, uint32_t v) {
+  if (v < 128) {
+    dst->push_back(static_cast<char>(v));
+    return;
+  }
+  char buf[5];
+  char *ptr = EncodeVarint32(buf, v);
+  dst->append(buf, ptr - buf);
+}
+
+// Returns the length of the varint32 or varint64 encoding of "v"
+inline int VarintLength(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  // One byte per started group of 7 bits; v | 1 keeps zero at one byte.
+  const int bits = 64 - __builtin_clzll(v | 1);
+  return (bits + 6) / 7;
+#else
+  int len = 1;
+  while (v >= 128) {
+    v >>= 7;
+    len++;
+  }
+  return len;
+#endif
+}
+
+} // namespace leveldb.
@@ -0,0 +1,339 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "coding.h"
+
+#include "random.h"
+
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(Coding, Fixed32) {
+    string s;
+    for (uint32_t v = 0; v < 100000; v++) {
+        PutFixed32(&s, v);
+    }
+
+    const char *p = s.data();
+    for (uint32_t v = 0; v < 100000; v++) {
+        uint32_t actual = DecodeFixed32(p);
+        ASSERT_EQ(v, actual);
+        p += sizeof(uint32_t);
+    }
+}
+
+TEST(Coding, Fixed64) {
+    string s;
+    for (int power = 0; power <= 63; power++) {
+        uint64_t v = static_cast<uint64_t>(1) << power;
+        PutFixed64(&s, v - 1);
+        PutFixed64(&s, v + 0);
+        PutFixed64(&s, v + 1);
+    }
+
+    const char *p = s.data();
+    for (int power = 0; power <= 63; power++) {
+        uint64_t v = static_cast<uint64_t>(1) << power;
+        ASSERT_EQ(v - 1, DecodeFixed64(p));
+        p += sizeof(uint64_t);
+        ASSERT_EQ(v + 0, DecodeFixed64(p));
+        p += sizeof(uint64_t);
+        ASSERT_EQ(v + 1, DecodeFixed64(p));
+        p += sizeof(uint64_t);
+    }
+}
+
+// Test that encoding routines generate little-endian encodings
+TEST(Coding, EncodingOutput) {
+    string dst;
+    PutFixed32(&dst, 0x04030201);
+    ASSERT_EQ(4, dst.size());
+    ASSERT_EQ(0x01, static_cast<int>(dst[0]));
+    ASSERT_EQ(0x02, static_cast<int>(dst[1]));
+    ASSERT_EQ(0x03, static_cast<int>(dst[2]));
+    ASSERT_EQ(0x04, static_cast<int>(dst[3]));
+
+    dst.clear();
+    PutFixed64(&dst, 0x0807060504030201ull);
+    ASSERT_EQ(8, dst.size());
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(i + 1, static_cast<int>(dst[i]));
+    }
+}
+
+TEST(Coding, Varint32) {
+    string s;
+    for (uint32_t i = 0; i < (32 * 32); i++) {
+        uint32_t v = (i / 32) << (i % 32);
+        PutVarint32(&s, v);
+    }
+
+    const char *p = s.data();
+    const char *limit = p + s.size();
+    for (uint32_t i = 0; i < (32 * 32); i++) {
+        uint32_t expected = (i / 32) << (i % 32);
+        uint32_t actual;
+        const char *start = p;
+        p = GetVarint32Ptr(p, limit, &actual);
+        ASSERT_TRUE(p != nullptr);
+        ASSERT_EQ(expected, actual);
+        ASSERT_EQ(VarintLength(actual), p - start);
+    }
+    ASSERT_EQ(p, s.data() + s.size());
+}
+
+TEST(Coding, Varint64) {
+    // Construct the list of values to check
+    vector<uint64_t> values;
+    // Some special values
+    values.push_back(0);
+    values.push_back(100);
+    values.push_back(~static_cast<uint64_t>(0));
+    values.push_back(~static_cast<uint64_t>(0) - 1);
+    for (uint32_t k = 0; k < 64; k++) {
+        // Test values near powers of two
+        const uint64_t power = 1ull << k;
+        values.push_back(power);
+        values.push_back(power - 1);
+        values.push_back(power + 1);
+    }
+
+    string s;
+    for (size_t i = 0; i < values.size(); i++) {
+        PutVarint64(&s, values[i]);
+    }
+
+    const char *p = s.data();
+    const char *limit = p + s.size();
+    for (size_t i = 0; i < values.size(); i++) {
+        ASSERT_TRUE(p < limit);
+        uint64_t actual;
+        const char *start = p;
+        p = GetVarint64Ptr(p, limit, &actual);
+        ASSERT_TRUE(p != nullptr);
+        ASSERT_EQ(values[i], actual);
+        ASSERT_EQ(VarintLength(actual), p - start);
+    }
+    ASSERT_EQ(p, limit);
+}
+
+TEST(Coding, Varint32Overflow) {
+    uint32_t result;
+    string input("\x81\x82\x83\x84\x85\x11");
+    ASSERT_TRUE(GetVarint32Ptr(input.data(), input.data() + input.size(), &result) == nullptr);
+}
+
+TEST(Coding, Varint32Truncation) {
+    uint32_t large_value = (1u << 31) + 100;
+    string s;
+    PutVarint32(&s, large_value);
+    uint32_t result;
+    for (size_t len = 0; len < s.size() - 1; len++) {
+        ASSERT_TRUE(GetVarint32Ptr(s.data(), s.data() + len, &result) == nullptr);
+    }
+    ASSERT_TRUE(GetVarint32Ptr(s.data(), s.data() + s.size(), &result) != nullptr);
+    ASSERT_EQ(large_value, result);
+}
+
+TEST(Coding, Varint64Overflow) {
+    uint64_t result;
+    string input("\x81\x82\x83\x84\x85\x81\x82\x83\x84\x85\x11");
+    ASSERT_TRUE(GetVarint64Ptr(input.data(), input.data() + input.size(), &result) == nullptr);
+}
+
+TEST(Coding, Varint64Truncation) {
+    uint64_t large_value = (1ull << 63) + 100ull;
+    string s;
+    PutVarint64(&s, large_value);
+    uint64_t result;
+    for (size_t len = 0; len < s.size() - 1; len++) {
+        ASSERT_TRUE(GetVarint64Ptr(s.data(), s.data() + len, &result) == nullptr);
+    }
+    ASSERT_TRUE(GetVarint64Ptr(s.data(), s.data() + s.size(), &result) != nullptr);
+    ASSERT_EQ(large_value, result);
+}
+
+TEST(Coding, Strings) {
+    string s;
+    PutLengthPrefixedSlice(&s, Slice(""));
+    PutLengthPrefixedSlice(&s, Slice("foo"));
+    PutLengthPrefixedSlice(&s, Slice("bar"));
+    PutLengthPrefixedSlice(&s, Slice(string(200, 'x')));
+
+    Slice input(s);
+    Slice v;
+    ASSERT_TRUE(GetLengthPrefixedSlice(&input, &v));
+    ASSERT_EQ("", v.ToString());
+    ASSERT_TRUE(GetLengthPrefixedSlice(&input, &v));
+    ASSERT_EQ("foo", v.ToString());
+    ASSERT_TRUE(GetLengthPrefixedSlice(&input, &v));
+    ASSERT_EQ("bar", v.ToString());
+    ASSERT_TRUE(GetLengthPrefixedSlice(&input, &v));
+    ASSERT_EQ(string(200, 'x'), v.ToString());
+    ASSERT_EQ("", input.ToString());
+
+    // A length running past the end of the input fails.
+    string truncated;
+    PutVarint32(&truncated, 10);
+    truncated.append("short");
+    input = Slice(truncated);
+    ASSERT_FALSE(GetLengthPrefixedSlice(&input, &v));
+}
+
+TEST(Coding, Varint32Array) {
+    // Runs of one byte, of one and two byte, and of any length varints,
+    // and mixes of the three, so every path of the bulk decoder and every
+    // switch between them is taken.
+    Random rnd(301);
+    for (int iteration = 0; iteration < 300; iteration++) {
+        const size_t n = rnd.Uniform(200);
+        vector<uint32_t> expected(n);
+        string s;
+        int max_bits = 7;
+        for (size_t i = 0; i < n; i++) {
+            if (rnd.OneIn(20)) {
+                max_bits = rnd.OneIn(3) ? 7 : (rnd.OneIn(2) ? 14 : 32);
+            }
+            const uint32_t r = (rnd.Uniform(1 << 16) << 16) ^ rnd.Uniform(1 << 16);
+            expected[i] = max_bits == 32 ? r : r & ((1u << max_bits) - 1);
+            PutVarint32(&s, expected[i]);
+        }
+        // Decoders may read ahead; keep junk after the varints.
+        const size_t encoded_size = s.size();
+        s.append(20, '\xff');
+
+        vector<uint32_t> actual(n + 1, 0xdeadbeef);
+        const char *end = GetVarint32Array(s.data(), s.data() + s.size(), actual.data(), n);
+        ASSERT_EQ(s.data() + encoded_size, end);
+        ASSERT_EQ(0xdeadbeef, actual[n]) << "wrote past the end";
+        actual.resize(n);
+        ASSERT_EQ(expected, actual);
+
+        vector<uint32_t> portable(n);
+        ASSERT_EQ(end, GetVarint32ArrayPortable(s.data(), s.data() + s.size(), portable.data(), n));
+        ASSERT_EQ(expected, portable);
+
+        // Input that ends before the last varint fails.
+        if (n > 0) {
+            ASSERT_TRUE(GetVarint32Array(s.data(), s.data() + encoded_size - 1, actual.data(), n) ==
+                        nullptr);
+        }
+    }
+
+    // So does a malformed varint after a run of good ones.
+    string s(40, '\x01');
+    s.append("\x81\x82\x83\x84\x85\x11");
+    s.append(40, '\x01');
+    vector<uint32_t> values(100);
+    ASSERT_TRUE(GetVarint32Array(s.data(), s.data() + s.size(), values.data(), 81) == nullptr);
+    ASSERT_TRUE(GetVarint32Array(s.data(), s.data() + s.size(), values.data(), 40) != nullptr);
+    ASSERT_EQ(s.data(), GetVarint32Array(s.data(), s.data() + s.size(), values.data(), 0));
+}
+
+TEST(Coding, RandomRoundTrip) {
+    // Random mixes of every encoding, with values spread over all lengths,
+    // decode back to what was written; and every truncation of the
+    // encoding fails cleanly instead of reading past its end.
+    Random rnd(301);
+    for (int iteration = 0; iteration < 200; iteration++) {
+        struct Item {
+            int kind;
+            uint64_t value;
+            string str;
+        };
+        vector<Item> items;
+        string s;
+        const int n = rnd.Uniform(50);
+        for (int i = 0; i < n; i++) {
+            Item item;
+            item.kind = rnd.Uniform(5);
+            // Mostly small values, like real lengths and tags.
+            const int bits = rnd.OneIn(2) ? rnd.Uniform(8) : rnd.Uniform(65);
+            item.value = bits == 0 ? 0 : ((uint64_t{rnd.Uniform(1 << 30)} << 34 ^
+                                           uint64_t{rnd.Uniform(1 << 30)} << 4 ^
+                                           rnd.Uniform(16)) >> (64 - bits));
+            switch (item.kind) {
+                case 0:
+                    item.value &= 0xffffffff;
+                    PutFixed32(&s, static_cast<uint32_t>(item.value));
+                    break;
+                case 1:
+                    PutFixed64(&s, item.value);
+                    break;
+                case 2:
+                    item.value &= 0xffffffff;
+                    PutVarint32(&s, static_cast<uint32_t>(item.value));
+                    break;
+                case 3:
+                    PutVarint64(&s, item.value);
+                    break;
+                case 4:
+                    item.str.assign(rnd.Uniform(300), static_cast<char>('a' + rnd.Uniform(26)));
+                    PutLengthPrefixedSlice(&s, item.str);
+                    break;
+            }
+            items.push_back(item);
+        }
+
+        for (size_t len = 0; len <= s.size(); len++) {
+            Slice input(s.data(), len);
+            size_t decoded = 0;
+            for (const Item& item : items) {
+                uint32_t v32;
+                uint64_t v64;
+                Slice str;
+                bool ok;
+                switch (item.kind) {
+                    case 0:
+                        ok = input.size() >= 4;
+                        if (ok) {
+                            ASSERT_EQ(item.value, DecodeFixed32(input.data()));
+                            input.remove_prefix(4);
+                        }
+                        break;
+                    case 1:
+                        ok = input.size() >= 8;
+                        if (ok) {
+                            ASSERT_EQ(item.value, DecodeFixed64(input.data()));
+                            input.remove_prefix(8);
+                        }
+                        break;
+                    case 2:
+                        ok = GetVarint32(&input, &v32);
+                        if (ok) {
+                            ASSERT_EQ(item.value, v32);
+                        }
+                        break;
+                    case 3:
+                        ok = GetVarint64(&input, &v64);
+                        if (ok) {
+                            ASSERT_EQ(item.value, v64);
+                        }
+                        break;
+                    default:
+                        ok = GetLengthPrefixedSlice(&input, &str);
+                        if (ok) {
+                            ASSERT_EQ(item.str, str.ToString());
+                        }
+                        break;
+                }
+                if (!ok) {
+                    break;
+                }
+                decoded++;
+            }
+            if (len == s.size()) {
+                ASSERT_EQ(items.size(), decoded);
+                ASSERT_TRUE(input.empty());
+            } else {
+                ASSERT_LT(decoded, items.size());
+            }
+        }
+    }
+}
+
+} // namespace leveldb.
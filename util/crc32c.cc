@@ -0,0 +1,357 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "crc32c.h"
+
+#include "coding.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define LEVELDB_CRC32C_ARM64 1
+#include <arm_acle.h>
+#endif
+
+namespace leveldb {
+namespace crc32c {
+
+namespace {
+
+// The Castagnoli polynomial, bit reflected.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+/*
+ * table[k][b] is the CRC of byte b followed by k zero bytes, which lets
+ * the portable implementation consume eight bytes per step
+ * ("slicing-by-8").
+ */
+struct SlicingTables {
+    uint32_t table[8][256] = {};
+
+    constexpr SlicingTables() {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+            }
+            table[0][b] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (uint32_t b = 0; b < 256; b++) {
+                const uint32_t prev = table[k - 1][b];
+                table[k][b] = (prev >> 8) ^ table[0][prev & 0xff];
+            }
+        }
+    }
+};
+
+constexpr SlicingTables kSlicing;
+
+inline uint32_t StepByte(uint32_t crc, uint8_t byte) {
+    return (crc >> 8) ^ kSlicing.table[0][(crc ^ byte) & 0xff];
+}
+
+#if defined(LEVELDB_CRC32C_SSE42) || defined(LEVELDB_CRC32C_ARM64)
+
+/*
+ * The hardware path runs three independent CRCs over adjacent blocks, so
+ * that the multi-cycle latency of the CRC instruction overlaps, and then
+ * merges them. Merging needs the CRC "shifted" over a block of zeros,
+ * which is a linear map applied here with four byte-indexed tables.
+ */
+constexpr size_t kLongBlock = 8192;
+constexpr size_t kShortBlock = 256;
+
+// Multiplies the 32x32 GF(2) matrix "mat" by "vec".
+uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec != 0) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = Gf2MatrixTimes(mat, mat[n]);
+    }
+}
+
+// Tables applying the operator that appends "len" zero bytes to a CRC.
+struct ShiftTables {
+    uint32_t table[4][256];
+
+    // REQUIRES: "len" is a power of two.
+    explicit ShiftTables(size_t len) {
+        uint32_t even[32];
+        uint32_t odd[32];
+
+        // The operator for one zero bit.
+        odd[0] = kPolynomial;
+        uint32_t row = 1;
+        for (int n = 1; n < 32; n++) {
+            odd[n] = row;
+            row <<= 1;
+        }
+        Gf2MatrixSquare(even, odd);  // 2 zero bits.
+        Gf2MatrixSquare(odd, even);  // 4 zero bits.
+
+        // Square up to 8 * len zero bits; the result ends up in "even"
+        // or "odd" depending on the parity of log2(len).
+        const uint32_t *op;
+        while (true) {
+            Gf2MatrixSquare(even, odd);
+            len >>= 1;
+            if (len == 0) {
+                op = even;
+                break;
+            }
+            Gf2MatrixSquare(odd, even);
+            len >>= 1;
+            if (len == 0) {
+                op = odd;
+                break;
+            }
+        }
+
+        for (uint32_t n = 0; n < 256; n++) {
+            table[0][n] = Gf2MatrixTimes(op, n);
+            table[1][n] = Gf2MatrixTimes(op, n << 8);
+            table[2][n] = Gf2MatrixTimes(op, n << 16);
+            table[3][n] = Gf2MatrixTimes(op, n << 24);
+        }
+    }
+
+    uint32_t Shift(uint32_t crc) const {
+        return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+               table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+    }
+};
+
+const ShiftTables& LongShift() {
+    static const ShiftTables tables(kLongBlock);
+    return tables;
+}
+
+const ShiftTables& ShortShift() {
+    static const ShiftTables tables(kShortBlock);
+    return tables;
+}
+
+inline uint64_t LoadUnaligned64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+#endif
+
+#if defined(LEVELDB_CRC32C_SSE42)
+
+__attribute__((target("sse4.2")))
+uint32_t ExtendHardware(uint32_t init_crc, const char *data, size_t n) {
+    const ShiftTables& long_shift = LongShift();
+    const ShiftTables& short_shift = ShortShift();
+    const char *p = data;
+    uint64_t crc0 = init_crc ^ 0xffffffffu;
+
+    // Align to 8 bytes.
+    while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), static_cast<uint8_t>(*p));
+        p++;
+        n--;
+    }
+
+    while (n >= 3 * kLongBlock) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const char *end = p + kLongBlock;
+        do {
+            crc0 = _mm_crc32_u64(crc0, LoadUnaligned64(p));
+            crc1 = _mm_crc32_u64(crc1, LoadUnaligned64(p + kLongBlock));
+            crc2 = _mm_crc32_u64(crc2, LoadUnaligned64(p + 2 * kLongBlock));
+            p += 8;
+        } while (p < end);
+        crc0 = long_shift.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = long_shift.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+        p += 2 * kLongBlock;
+        n -= 3 * kLongBlock;
+    }
+
+    while (n >= 3 * kShortBlock) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const char *end = p + kShortBlock;
+        do {
+            crc0 = _mm_crc32_u64(crc0, LoadUnaligned64(p));
+            crc1 = _mm_crc32_u64(crc1, LoadUnaligned64(p + kShortBlock));
+            crc2 = _mm_crc32_u64(crc2, LoadUnaligned64(p + 2 * kShortBlock));
+            p += 8;
+        } while (p < end);
+        crc0 = short_shift.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = short_shift.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+        p += 2 * kShortBlock;
+        n -= 3 * kShortBlock;
+    }
+
+    while (n >= 8) {
+        crc0 = _mm_crc32_u64(crc0, LoadUnaligned64(p));
+        p += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), static_cast<uint8_t>(*p));
+        p++;
+        n--;
+    }
+    return static_cast<uint32_t>(crc0) ^ 0xffffffffu;
+}
+
+bool CanUseHardware() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(LEVELDB_CRC32C_ARM64)
+
+uint32_t ExtendHardware(uint32_t init_crc, const char *data, size_t n) {
+    const ShiftTables& long_shift = LongShift();
+    const ShiftTables& short_shift = ShortShift();
+    const char *p = data;
+    uint32_t crc0 = init_crc ^ 0xffffffffu;
+
+    // Align to 8 bytes.
+    while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc0 = __crc32cb(crc0, static_cast<uint8_t>(*p));
+        p++;
+        n--;
+    }
+
+    while (n >= 3 * kLongBlock) {
+        uint32_t crc1 = 0;
+        uint32_t crc2 = 0;
+        const char *end = p + kLongBlock;
+        do {
+            crc0 = __crc32cd(crc0, LoadUnaligned64(p));
+            crc1 = __crc32cd(crc1, LoadUnaligned64(p + kLongBlock));
+            crc2 = __crc32cd(crc2, LoadUnaligned64(p + 2 * kLongBlock));
+            p += 8;
+        } while (p < end);
+        crc0 = long_shift.Shift(crc0) ^ crc1;
+        crc0 = long_shift.Shift(crc0) ^ crc2;
+        p += 2 * kLongBlock;
+        n -= 3 * kLongBlock;
+    }
+
+    while (n >= 3 * kShortBlock) {
+        uint32_t crc1 = 0;
+        uint32_t crc2 = 0;
+        const char *end = p + kShortBlock;
+        do {
+            crc0 = __crc32cd(crc0, LoadUnaligned64(p));
+            crc1 = __crc32cd(crc1, LoadUnaligned64(p + kShortBlock));
+            crc2 = __crc32cd(crc2, LoadUnaligned64(p + 2 * kShortBlock));
+            p += 8;
+        } while (p < end);
+        crc0 = short_shift.Shift(crc0) ^ crc1;
+        crc0 = short_shift.Shift(crc0) ^ crc2;
+        p += 2 * kShortBlock;
+        n -= 3 * kShortBlock;
+    }
+
+    while (n >= 8) {
+        crc0 = __crc32cd(crc0, LoadUnaligned64(p));
+        p += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        crc0 = __crc32cb(crc0, static_cast<uint8_t>(*p));
+        p++;
+        n--;
+    }
+    return crc0 ^ 0xffffffffu;
+}
+
+// The compiler was told the target has the CRC extension.
+bool CanUseHardware() {
+    return true;
+}
+
+#endif
+
+using ExtendFunction = uint32_t (*)(uint32_t, const char *, size_t);
+
+ExtendFunction ChooseExtend() {
+#if defined(LEVELDB_CRC32C_SSE42) || defined(LEVELDB_CRC32C_ARM64)
+    if (CanUseHardware()) {
+        // Build the shift tables before the first caller needs them.
+        LongShift();
+        ShortShift();
+        return &ExtendHardware;
+    }
+#endif
+    return &ExtendPortable;
+}
+
+ExtendFunction Chosen() {
+    static const ExtendFunction extend = ChooseExtend();
+    return extend;
+}
+
+} // namespace
+
+uint32_t
+ExtendPortable(uint32_t init_crc, const char *data, size_t n)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    const uint8_t *limit = p + n;
+    uint32_t crc = init_crc ^ 0xffffffffu;
+
+    // Align to 4 bytes so the 8 byte steps read aligned words.
+    while (p != limit && (reinterpret_cast<uintptr_t>(p) & 3) != 0) {
+        crc = StepByte(crc, *p);
+        p++;
+    }
+
+    const auto& t = kSlicing.table;
+    while (limit - p >= 8) {
+        const uint32_t lo = DecodeFixed32(reinterpret_cast<const char *>(p)) ^ crc;
+        const uint32_t hi = DecodeFixed32(reinterpret_cast<const char *>(p + 4));
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+              t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+              t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+    }
+
+    while (p != limit) {
+        crc = StepByte(crc, *p);
+        p++;
+    }
+    return crc ^ 0xffffffffu;
+}
+
+uint32_t
+Extend(uint32_t init_crc, const char *data, size_t n)
+{
+    return Chosen()(init_crc, data, n);
+}
+
+bool
+IsHardwareAccelerated()
+{
+    return Chosen() != &ExtendPortable;
+}
+
+} // namespace crc32c.
+} // namespace leveldb.
@@ -0,0 +1,93 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "crc32c.h"
+
+#include "random.h"
+
+#include <cstring>
+#include <string>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+namespace crc32c {
+
+TEST(CRC, StandardResults) {
+    // From rfc3720 section B.4.
+    char buf[32];
+
+    memset(buf, 0, sizeof(buf));
+    ASSERT_EQ(0x8a9136aa, Value(buf, sizeof(buf)));
+
+    memset(buf, 0xff, sizeof(buf));
+    ASSERT_EQ(0x62a8ab43, Value(buf, sizeof(buf)));
+
+    for (int i = 0; i < 32; i++) {
+        buf[i] = i;
+    }
+    ASSERT_EQ(0x46dd794e, Value(buf, sizeof(buf)));
+
+    for (int i = 0; i < 32; i++) {
+        buf[i] = 31 - i;
+    }
+    ASSERT_EQ(0x113fdb5c, Value(buf, sizeof(buf)));
+
+    uint8_t data[48] = {
+        0x01, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+        0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18, 0x28, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    ASSERT_EQ(0xd9963a56, Value(reinterpret_cast<char *>(data), sizeof(data)));
+    ASSERT_EQ(0xd9963a56, ExtendPortable(0, reinterpret_cast<char *>(data), sizeof(data)));
+}
+
+TEST(CRC, Values) {
+    ASSERT_NE(Value("a", 1), Value("foo", 3));
+}
+
+TEST(CRC, Extend) {
+    ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
+}
+
+TEST(CRC, Mask) {
+    uint32_t crc = Value("foo", 3);
+    ASSERT_NE(crc, Mask(crc));
+    ASSERT_NE(crc, Mask(Mask(crc)));
+    ASSERT_EQ(crc, Unmask(Mask(crc)));
+    ASSERT_EQ(crc, Unmask(Unmask(Mask(Mask(crc)))));
+}
+
+TEST(CRC, HardwareUsedWhenSupported) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        ASSERT_TRUE(IsHardwareAccelerated());
+    }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    ASSERT_TRUE(IsHardwareAccelerated());
+#endif
+}
+
+TEST(CRC, HardwareMatchesPortable) {
+    // Long enough for the three-way interleaved blocks of both sizes, at
+    // every alignment and with every tail length.
+    Random rnd(301);
+    string data(3 * 8192 * 2 + 3 * 256 + 100, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rnd.Uniform(256));
+    }
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t n : {0, 1, 7, 8, 9, 100, 767, 768, 769, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 13,
+                         static_cast<int>(data.size() - 16)}) {
+            ASSERT_EQ(ExtendPortable(0x12345678, data.data() + offset, n),
+                      Extend(0x12345678, data.data() + offset, n))
+                << "offset " << offset << " length " << n;
+        }
+    }
+}
+
+} // namespace crc32c.
+} // namespace leveldb.
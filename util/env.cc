@@ -0,0 +1,46 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/env.h"
+
+namespace leveldb {
+
+Env::Env() = default;
+
+Env::~Env() = default;
+
+Status
+Env::SetBackgroundThreadOptions(const BackgroundThreadOptions& options)
+{
+    return Status::NotSupported("SetBackgroundThreadOptions");
+}
+
+Status
+Env::GetBackgroundThreadCpuTimes(vector<BackgroundThreadCpuTime> *result)
+{
+    result->clear();
+    return Status::NotSupported("GetBackgroundThreadCpuTimes");
+}
+
+SequentialFile::~SequentialFile() = default;
+
+Status
+SequentialFile::Hint(AccessPattern pattern)
+{
+    return Status::OK();
+}
+
+RandomAccessFile::~RandomAccessFile() = default;
+
+Status
+RandomAccessFile::Hint(AccessPattern pattern)
+{
+    return Status::OK();
+}
+
+WritableFile::~WritableFile() = default;
+
+EnvWrapper::~EnvWrapper() {}
+
+} // namespace leveldb.
@@ -1,17 +1,481 @@
 
 #include "leveldb/env.h"
+#include "port/port.h"
 #include "port/thread_annotations.h"
+#include "util/group_commit.h"
+#include "util/mutexlock.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
-#include <condition_variable>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <functional>
-#include <mutex>
+#include <new>
 #include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 using namespace std;
 
 namespace leveldb
 {
 
+    namespace
+    {
+
+        constexpr const size_t kWritableFileBufferSize = 65536;
+
+        // Resolution of ScheduleAfter() delays.
+        constexpr const uint64_t kTimerTickMicros = 1000;
+
+        // Number of slots in the timer wheel; one revolution covers ~0.5s.
+        constexpr const size_t kTimerWheelSize = 512;
+
+        Status PosixError(const string &context, int error_number)
+        {
+            if (error_number == ENOENT)
+            {
+                return Status::NotFound(context, strerror(error_number));
+            }
+            else
+            {
+                return Status::IOError(context, strerror(error_number));
+            }
+        }
+
+#if defined(__linux__)
+        // Reads the CPUs of a NUMA node from its sysfs cpulist, e.g. "0-3,8,10-11".
+        Status NumaNodeCpus(int node, vector<int> *cpus)
+        {
+            char path[100];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            FILE *file = ::fopen(path, "r");
+            if (file == nullptr)
+            {
+                return PosixError(path, errno);
+            }
+            char buf[4096];
+            const size_t n = ::fread(buf, 1, sizeof(buf) - 1, file);
+            ::fclose(file);
+            buf[n] = '\0';
+
+            cpus->clear();
+            const char *p = buf;
+            while (*p != '\0' && *p != '\n')
+            {
+                char *end;
+                const long first = strtol(p, &end, 10);
+                if (end == p)
+                {
+                    break;
+                }
+                long last = first;
+                p = end;
+                if (*p == '-')
+                {
+                    last = strtol(p + 1, &end, 10);
+                    p = end;
+                }
+                for (long cpu = first; cpu <= last; cpu++)
+                {
+                    cpus->push_back(static_cast<int>(cpu));
+                }
+                if (*p == ',')
+                {
+                    p++;
+                }
+            }
+            if (cpus->empty())
+            {
+                return Status::InvalidArgument(path, "no CPUs listed");
+            }
+            return Status::OK();
+        }
+#endif
+
+        // Stores the CPU time consumed so far by "thread" in *micros.
+        Status ThreadCpuMicros(pthread_t thread, uint64_t *micros)
+        {
+#if defined(__APPLE__)
+            thread_basic_info_data_t info;
+            mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+            if (::thread_info(::pthread_mach_thread_np(thread), THREAD_BASIC_INFO,
+                              reinterpret_cast<thread_info_t>(&info), &count) != KERN_SUCCESS)
+            {
+                return Status::IOError("thread_info");
+            }
+            *micros = (info.user_time.seconds + info.system_time.seconds) * 1000000ULL +
+                      info.user_time.microseconds + info.system_time.microseconds;
+            return Status::OK();
+#else
+            clockid_t clock;
+            int error = ::pthread_getcpuclockid(thread, &clock);
+            if (error != 0)
+            {
+                return PosixError("pthread_getcpuclockid", error);
+            }
+            struct timespec ts;
+            if (::clock_gettime(clock, &ts) != 0)
+            {
+                return PosixError("clock_gettime", errno);
+            }
+            *micros = static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+            return Status::OK();
+#endif
+        }
+
+        // Passes "pattern" for the whole of "fd" to the kernel.
+        Status AdviseAccessPattern(int fd, const string &filename, AccessPattern pattern)
+        {
+#if defined(POSIX_FADV_NORMAL)
+            int advice;
+            switch (pattern)
+            {
+            case AccessPattern::kSequential:
+                advice = POSIX_FADV_SEQUENTIAL;
+                break;
+            case AccessPattern::kRandom:
+                advice = POSIX_FADV_RANDOM;
+                break;
+            case AccessPattern::kWillNeed:
+                advice = POSIX_FADV_WILLNEED;
+                break;
+            case AccessPattern::kDontNeed:
+                advice = POSIX_FADV_DONTNEED;
+                break;
+            default:
+                advice = POSIX_FADV_NORMAL;
+                break;
+            }
+            // posix_fadvise() returns the error instead of setting errno.
+            const int error = ::posix_fadvise(fd, 0, 0, advice);
+            if (error != 0)
+            {
+                return PosixError(filename, error);
+            }
+#elif defined(__APPLE__) && defined(F_RDAHEAD)
+            // macOS has no fadvise; only the readahead switch applies.
+            if (pattern == AccessPattern::kSequential || pattern == AccessPattern::kRandom)
+            {
+                if (::fcntl(fd, F_RDAHEAD, pattern == AccessPattern::kSequential ? 1 : 0) < 0)
+                {
+                    return PosixError(filename, errno);
+                }
+            }
+#endif
+            return Status::OK();
+        }
+
+        void SetCurrentThreadName(const char *name)
+        {
+#if defined(__APPLE__)
+            ::pthread_setname_np(name);
+#elif defined(__linux__)
+            ::pthread_setname_np(::pthread_self(), name);
+#endif
+        }
+
+        /*
+         * Implements sequential read access in a file using read().
+         *
+         * Instances of this class are thread-friendly but not thread-safe, as
+         * required by the SequentialFile API.
+         */
+        class PosixSequentialFile final : public SequentialFile
+        {
+        public:
+            PosixSequentialFile(string filename, int fd)
+                : _fd(fd), _filename(move(filename)) {}
+
+            ~PosixSequentialFile() override
+            {
+                ::close(_fd);
+            }
+
+            Status Read(size_t n, Slice *result, char *scratch) override
+            {
+                Status status;
+                while (true)
+                {
+                    ::ssize_t read_size = ::read(_fd, scratch, n);
+                    if (read_size < 0)
+                    {
+                        // Read error.
+                        if (errno == EINTR)
+                        {
+                            continue; // Retry
+                        }
+                        status = PosixError(_filename, errno);
+                        break;
+                    }
+                    *result = Slice(scratch, read_size);
+                    break;
+                }
+                return status;
+            }
+
+            Status Skip(uint64_t n) override
+            {
+                if (::lseek(_fd, n, SEEK_CUR) == static_cast<off_t>(-1))
+                {
+                    return PosixError(_filename, errno);
+                }
+                return Status::OK();
+            }
+
+            Status Hint(AccessPattern pattern) override
+            {
+                return AdviseAccessPattern(_fd, _filename, pattern);
+            }
+
+        private:
+            const int _fd;
+            const string _filename;
+        };
+
+        /*
+         * Implements random read access in a file using pread().
+         *
+         * Instances of this class are thread-safe, as required by the
+         * RandomAccessFile API. Instances are immutable and Read() only calls
+         * thread-safe library functions.
+         */
+        class PosixRandomAccessFile final : public RandomAccessFile
+        {
+        public:
+            PosixRandomAccessFile(string filename, int fd)
+                : _fd(fd), _filename(move(filename)) {}
+
+            ~PosixRandomAccessFile() override
+            {
+                ::close(_fd);
+            }
+
+            Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override
+            {
+                Status status;
+                ::ssize_t read_size = ::pread(_fd, scratch, n, static_cast<off_t>(offset));
+                *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
+                if (read_size < 0)
+                {
+                    // An error: return a non-ok status.
+                    status = PosixError(_filename, errno);
+                }
+                return status;
+            }
+
+            Status Hint(AccessPattern pattern) override
+            {
+                return AdviseAccessPattern(_fd, _filename, pattern);
+            }
+
+        private:
+            const int _fd;
+            const string _filename;
+        };
+
+        /*
+         * Append(), Flush() and Sync() may be called concurrently. Syncs
+         * issued by concurrent writers are coalesced (see GroupCommit).
+         */
+        class PosixWritableFile final : public WritableFile
+        {
+        public:
+            PosixWritableFile(string filename, int fd)
+                : _pos(0), _appended(0), _fd(fd), _filename(move(filename)) {}
+
+            ~PosixWritableFile() override
+            {
+                if (_fd >= 0)
+                {
+                    // Ignoring any potential errors
+                    Close();
+                }
+            }
+
+            Status Append(const Slice &data) override
+            {
+                MutexLock lk(&_mu);
+                size_t write_size = data.size();
+                const char *write_data = data.data();
+
+                /*
+                 * _appended only advances once the data is buffered or
+                 * written, so that a later Sync() never reports bytes a
+                 * failed Append() dropped.
+                 */
+
+                // Fit as much as possible into buffer.
+                size_t copy_size = min(write_size, kWritableFileBufferSize - _pos);
+                memcpy(_buf + _pos, write_data, copy_size);
+                write_data += copy_size;
+                write_size -= copy_size;
+                _pos += copy_size;
+                if (write_size == 0)
+                {
+                    _appended += data.size();
+                    return Status::OK();
+                }
+
+                // Can't fit in buffer, so need to do at least one write.
+                Status status = FlushBuffer();
+                if (!status.ok())
+                {
+                    return status;
+                }
+
+                // Small writes go to buffer, large writes are written directly.
+                if (write_size < kWritableFileBufferSize)
+                {
+                    memcpy(_buf, write_data, write_size);
+                    _pos = write_size;
+                    _appended += data.size();
+                    return Status::OK();
+                }
+                status = WriteUnbuffered(write_data, write_size);
+                if (status.ok())
+                {
+                    _appended += data.size();
+                }
+                return status;
+            }
+
+            Status Close() override
+            {
+                MutexLock lk(&_mu);
+                Status status = FlushBuffer();
+                const int close_result = ::close(_fd);
+                if (close_result < 0 && status.ok())
+                {
+                    status = PosixError(_filename, errno);
+                }
+                _fd = -1;
+                return status;
+            }
+
+            Status Flush() override
+            {
+                MutexLock lk(&_mu);
+                return FlushBuffer();
+            }
+
+            Status Sync() override
+            {
+                uint64_t offset;
+                {
+                    MutexLock lk(&_mu);
+                    offset = _appended;
+                }
+                return _group_commit.Sync(offset, [this](uint64_t *synced_offset) {
+                    {
+                        MutexLock lk(&_mu);
+                        Status status = FlushBuffer();
+                        if (!status.ok())
+                        {
+                            return status;
+                        }
+                        *synced_offset = _appended;
+                    }
+                    // Writers keep appending while the leader syncs.
+                    return SyncFd(_fd, _filename);
+                });
+            }
+
+        private:
+            Status FlushBuffer()
+            {
+                Status status = WriteUnbuffered(_buf, _pos);
+                _pos = 0;
+                return status;
+            }
+
+            Status WriteUnbuffered(const char *data, size_t size)
+            {
+                while (size > 0)
+                {
+                    ssize_t write_result = ::write(_fd, data, size);
+                    if (write_result < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue; // Retry
+                        }
+                        return PosixError(_filename, errno);
+                    }
+                    data += write_result;
+                    size -= write_result;
+                }
+                return Status::OK();
+            }
+
+            /*
+             * Ensures that all the caches associated with the given file
+             * descriptor's data are flushed all the way to durable media.
+             */
+            static Status SyncFd(int fd, const string &fd_path)
+            {
+#if defined(__APPLE__) && defined(F_FULLFSYNC)
+                // On macOS and iOS, fsync() doesn't guarantee durability past
+                // power failures. fcntl(F_FULLFSYNC) is required for that
+                // purpose.
+                if (::fcntl(fd, F_FULLFSYNC) == 0)
+                {
+                    return Status::OK();
+                }
+#endif
+
+#if defined(__linux__)
+                bool sync_success = ::fdatasync(fd) == 0;
+#else
+                bool sync_success = ::fsync(fd) == 0;
+#endif
+
+                if (sync_success)
+                {
+                    return Status::OK();
+                }
+                return PosixError(fd_path, errno);
+            }
+
+            port::Mutex _mu;
+
+            // _buf[0, _pos - 1] contains data to be written to _fd.
+            char _buf[kWritableFileBufferSize] GUARDED_BY(_mu);
+            size_t _pos GUARDED_BY(_mu);
+
+            // Bytes passed to Append() so far.
+            uint64_t _appended GUARDED_BY(_mu);
+            int _fd;
+
+            const string _filename;
+            GroupCommit _group_commit;
+        };
+
+    } // namespace
+
     class PosixEnv : public Env
     {
     public:
@@ -24,11 +488,161 @@ namespace leveldb
             abort();
         }
 
+        Status NewSequentialFile(const string &filename, SequentialFile **result) override
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                *result = nullptr;
+                return PosixError(filename, errno);
+            }
+
+            // Best effort; the file reads the same without the hint.
+            AdviseAccessPattern(fd, filename, AccessPattern::kSequential);
+            *result = new PosixSequentialFile(filename, fd);
+            return Status::OK();
+        }
+
+        Status NewRandomAccessFile(const string &filename, RandomAccessFile **result) override
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                *result = nullptr;
+                return PosixError(filename, errno);
+            }
+
+            *result = new PosixRandomAccessFile(filename, fd);
+            return Status::OK();
+        }
+
+        Status NewWritableFile(const string &filename, WritableFile **result) override
+        {
+            int fd = ::open(filename.c_str(), O_TRUNC | O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                *result = nullptr;
+                return PosixError(filename, errno);
+            }
+
+            *result = new PosixWritableFile(filename, fd);
+            return Status::OK();
+        }
+
+        Status NewAppendableFile(const string &filename, WritableFile **result) override
+        {
+            int fd = ::open(filename.c_str(), O_APPEND | O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                *result = nullptr;
+                return PosixError(filename, errno);
+            }
+
+            *result = new PosixWritableFile(filename, fd);
+            return Status::OK();
+        }
+
+        bool FileExists(const string &filename) override
+        {
+            return ::access(filename.c_str(), F_OK) == 0;
+        }
+
+        Status GetChildren(const string &directory_path, vector<string> *result) override
+        {
+            result->clear();
+            ::DIR *dir = ::opendir(directory_path.c_str());
+            if (dir == nullptr)
+            {
+                return PosixError(directory_path, errno);
+            }
+            struct ::dirent *entry;
+            while ((entry = ::readdir(dir)) != nullptr)
+            {
+                result->emplace_back(entry->d_name);
+            }
+            ::closedir(dir);
+            return Status::OK();
+        }
+
+        Status RemoveFile(const string &filename) override
+        {
+            if (::unlink(filename.c_str()) != 0)
+            {
+                return PosixError(filename, errno);
+            }
+            return Status::OK();
+        }
+
+        Status CreateDir(const string &dirname) override
+        {
+            if (::mkdir(dirname.c_str(), 0755) != 0)
+            {
+                return PosixError(dirname, errno);
+            }
+            return Status::OK();
+        }
+
+        Status RemoveDir(const string &dirname) override
+        {
+            if (::rmdir(dirname.c_str()) != 0)
+            {
+                return PosixError(dirname, errno);
+            }
+            return Status::OK();
+        }
+
+        Status GetFileSize(const string &filename, uint64_t *size) override
+        {
+            struct ::stat file_stat;
+            if (::stat(filename.c_str(), &file_stat) != 0)
+            {
+                *size = 0;
+                return PosixError(filename, errno);
+            }
+            *size = file_stat.st_size;
+            return Status::OK();
+        }
+
+        Status RenameFile(const string &from, const string &to) override
+        {
+            if (::rename(from.c_str(), to.c_str()) != 0)
+            {
+                return PosixError(from, errno);
+            }
+            return Status::OK();
+        }
+
         void Schedule(function<void(void *)> background_work_function, void *background_work_arg) override;
 
+        ScheduleHandle ScheduleWithHandle(function<void(void *)> background_work_function,
+                                          void *background_work_arg) override;
+
+        ScheduleHandle ScheduleAfter(function<void(void *)> background_work_function,
+                                     void *background_work_arg, uint64_t micros) override;
+
+        void WaitScheduled(const ScheduleHandle &handle) override;
+
+        bool CancelScheduled(const ScheduleHandle &handle) override;
+
+        Status SetBackgroundThreadOptions(const BackgroundThreadOptions &options) override;
+
+        Status GetBackgroundThreadCpuTimes(vector<BackgroundThreadCpuTime> *result) override;
+
+        uint64_t NowMicros() override
+        {
+            return chrono::duration_cast<chrono::microseconds>(
+                       chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void SleepForMicroseconds(int micros) override
+        {
+            this_thread::sleep_for(chrono::microseconds(micros));
+        }
+
     private:
-        mutex _background_work_mutex;
-        condition_variable _background_work_cv GUARDED_BY(_background_work_mutex);
+        port::Mutex _background_work_mutex;
+        port::CondVar _background_work_cv GUARDED_BY(_background_work_mutex);
         bool _started_background_thread GUARDED_BY(_background_work_mutex);
 
         /*
@@ -39,46 +653,595 @@ namespace leveldb
          */
         struct BackgroundWorkItem
         {
-            explicit BackgroundWorkItem(function<void(void *)> function, void *arg)
-                : work_function(function), arg(arg) {}
+            explicit BackgroundWorkItem(function<void(void *)> function, void *arg, uint64_t task_id = 0)
+                : work_function(function), arg(arg), task_id(task_id) {}
 
             function<void(void *)> work_function;
             void *const arg;
+
+            // Task of a work item that has a ScheduleHandle, 0 otherwise.
+            const uint64_t task_id;
         };
 
         queue<BackgroundWorkItem> _background_work_queue GUARDED_BY(_background_work_mutex);
 
+        /*
+         * Tracks the state of a work item that has a ScheduleHandle.
+         *
+         * Tasks are recycled through a free list, so handles do not cost a heap
+         * allocation once the pool has grown to the number of outstanding items.
+         * A task id is (generation << 32 | slot). Finishing or cancelling a task
+         * bumps the generation of its slot, which invalidates every
+         * outstanding id for it.
+         */
+        enum TaskState
+        {
+            kTaskFree,
+            kTaskPending, // Queued or waiting in the timer wheel.
+            kTaskRunning
+        };
+
+        struct Task
+        {
+            uint32_t generation;
+            TaskState state;
+            // The tick a ScheduleAfter() item is due at while it waits in
+            // the timer wheel; 0 otherwise.
+            uint64_t deadline_tick;
+        };
+
+        deque<Task> _tasks GUARDED_BY(_background_work_mutex);
+        vector<uint32_t> _free_tasks GUARDED_BY(_background_work_mutex);
+        port::CondVar _task_done_cv GUARDED_BY(_background_work_mutex);
+        int _task_waiters GUARDED_BY(_background_work_mutex);
+
+        // A ScheduleAfter() work item waiting in the timer wheel.
+        struct TimerEntry
+        {
+            uint64_t deadline_tick;
+            function<void(void *)> work_function;
+            void *arg;
+            uint64_t task_id;
+        };
+
+        /*
+         * Hashed timer wheel: an entry due at tick "t" lives in slot
+         * t % kTimerWheelSize. The timer thread visits one slot per tick and
+         * fires the entries that are due, leaving the ones due in a later
+         * revolution.
+         */
+        bool _started_timer_thread GUARDED_BY(_background_work_mutex);
+        port::CondVar _timer_cv GUARDED_BY(_background_work_mutex);
+        vector<TimerEntry> _timer_wheel[kTimerWheelSize] GUARDED_BY(_background_work_mutex);
+        size_t _num_timers GUARDED_BY(_background_work_mutex);
+
+        // The next tick whose slot the timer thread has to visit.
+        uint64_t _timer_tick GUARDED_BY(_background_work_mutex);
+
+        // A thread started by this Env to run background work or timers.
+        struct BackgroundThread
+        {
+            const char *name;
+            pthread_t handle;
+#if defined(__linux__)
+            pid_t tid;
+#endif
+        };
+
+        vector<BackgroundThread> _threads GUARDED_BY(_background_work_mutex);
+        BackgroundThreadOptions _thread_options GUARDED_BY(_background_work_mutex);
+
+#if defined(__linux__)
+        // Scheduling of the thread that created the Env, restored for
+        // options that are left at their defaults.
+        cpu_set_t _default_cpus;
+        int _default_nice;
+#endif
+
+        // Records the calling thread as a background thread and applies the
+        // current options to it.
+        void RegisterCurrentThread(const char *name) LOCKS_EXCLUDED(_background_work_mutex);
+        Status ApplyThreadOptionsLocked(const BackgroundThread &thread)
+            EXCLUSIVE_LOCKS_REQUIRED(_background_work_mutex);
+
+        void EnqueueLocked(function<void(void *)> work_function, void *arg, uint64_t task_id)
+            EXCLUSIVE_LOCKS_REQUIRED(_background_work_mutex);
+        uint64_t AllocateTaskLocked() EXCLUSIVE_LOCKS_REQUIRED(_background_work_mutex);
+        Task *FindTaskLocked(uint64_t task_id) EXCLUSIVE_LOCKS_REQUIRED(_background_work_mutex);
+        void ReleaseTaskLocked(uint64_t task_id) EXCLUSIVE_LOCKS_REQUIRED(_background_work_mutex);
+
         void BackgroundThreadMain();
+        void TimerThreadMain();
 
         static void BackgroundThreadEntryPoint(PosixEnv *env)
         {
             env->BackgroundThreadMain();
         }
+
+        static void TimerThreadEntryPoint(PosixEnv *env)
+        {
+            env->TimerThreadMain();
+        }
     };
 
+    PosixEnv::PosixEnv()
+        : _background_work_cv(&_background_work_mutex),
+          _started_background_thread(false),
+          _task_done_cv(&_background_work_mutex),
+          _task_waiters(0),
+          _started_timer_thread(false),
+          _timer_cv(&_background_work_mutex),
+          _num_timers(0),
+          _timer_tick(0)
+    {
+#if defined(__linux__)
+        CPU_ZERO(&_default_cpus);
+        if (::sched_getaffinity(0, sizeof(_default_cpus), &_default_cpus) != 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                CPU_SET(cpu, &_default_cpus);
+            }
+        }
+        _default_nice = ::getpriority(PRIO_PROCESS, 0);
+#endif
+    }
+
+    void
+    PosixEnv::Schedule(function<void(void *)> background_work_function, void *background_work_arg)
+    {
+        MutexLock lk(&_background_work_mutex);
+        EnqueueLocked(background_work_function, background_work_arg, 0);
+    }
+
+    ScheduleHandle
+    PosixEnv::ScheduleWithHandle(function<void(void *)> background_work_function, void *background_work_arg)
+    {
+        MutexLock lk(&_background_work_mutex);
+        const uint64_t task_id = AllocateTaskLocked();
+        EnqueueLocked(background_work_function, background_work_arg, task_id);
+        return ScheduleHandle(this, task_id);
+    }
+
+    ScheduleHandle
+    PosixEnv::ScheduleAfter(function<void(void *)> background_work_function, void *background_work_arg,
+                            uint64_t micros)
+    {
+        if (micros == 0)
+        {
+            return ScheduleWithHandle(background_work_function, background_work_arg);
+        }
+
+        MutexLock lk(&_background_work_mutex);
+
+        // Read the clock under the lock, so the timer thread cannot move
+        // past the deadline's tick before the entry is in the wheel.
+        const uint64_t now = NowMicros();
+        uint64_t deadline_tick = (now + micros + kTimerTickMicros - 1) / kTimerTickMicros;
+
+        // Start the timer thread, if we haven't done so already.
+        if (!_started_timer_thread)
+        {
+            _started_timer_thread = true;
+            thread timer_thread(PosixEnv::TimerThreadEntryPoint, this);
+            timer_thread.detach();
+        }
+
+        // An idle wheel has stopped turning; catch it up with the clock.
+        if (_num_timers == 0)
+        {
+            _timer_tick = now / kTimerTickMicros;
+            _timer_cv.Signal();
+        }
+
+        // A slot the wheel has already passed would only be seen again a
+        // revolution later.
+        deadline_tick = max(deadline_tick, _timer_tick);
+
+        const uint64_t task_id = AllocateTaskLocked();
+        FindTaskLocked(task_id)->deadline_tick = deadline_tick;
+        _timer_wheel[deadline_tick % kTimerWheelSize].push_back(
+            TimerEntry{deadline_tick, background_work_function, background_work_arg, task_id});
+        _num_timers++;
+        return ScheduleHandle(this, task_id);
+    }
+
+    void
+    PosixEnv::WaitScheduled(const ScheduleHandle &handle)
+    {
+        MutexLock lk(&_background_work_mutex);
+        _task_waiters++;
+        while (FindTaskLocked(handle.id()) != nullptr)
+        {
+            _task_done_cv.Wait();
+        }
+        _task_waiters--;
+    }
+
+    bool
+    PosixEnv::CancelScheduled(const ScheduleHandle &handle)
+    {
+        MutexLock lk(&_background_work_mutex);
+        Task *task = FindTaskLocked(handle.id());
+        if (task == nullptr || task->state != kTaskPending)
+        {
+            return false;
+        }
+
+        /*
+         * Take a timer out of the wheel, so that the timer thread can go
+         * to sleep once no live timers remain. A queue entry stays behind
+         * and is dropped when reached.
+         */
+        if (task->deadline_tick != 0)
+        {
+            vector<TimerEntry> &slot = _timer_wheel[task->deadline_tick % kTimerWheelSize];
+            for (size_t i = 0; i < slot.size(); i++)
+            {
+                if (slot[i].task_id == handle.id())
+                {
+                    if (i + 1 != slot.size())
+                    {
+                        slot[i] = move(slot.back());
+                    }
+                    slot.pop_back();
+                    _num_timers--;
+                    break;
+                }
+            }
+        }
+        ReleaseTaskLocked(handle.id());
+        return true;
+    }
+
+    Status
+    PosixEnv::SetBackgroundThreadOptions(const BackgroundThreadOptions &options)
+    {
+        BackgroundThreadOptions resolved = options;
+#if defined(__linux__)
+        if (resolved.cpu_set.empty() && resolved.numa_node >= 0)
+        {
+            Status s = NumaNodeCpus(resolved.numa_node, &resolved.cpu_set);
+            if (!s.ok())
+            {
+                return s;
+            }
+        }
+        for (int cpu : resolved.cpu_set)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+            {
+                return Status::InvalidArgument("CPU out of range");
+            }
+        }
+#else
+        if (!options.cpu_set.empty() || options.numa_node >= 0 ||
+            options.nice_increment != 0 || options.batch_scheduling)
+        {
+            return Status::NotSupported("background thread scheduling options");
+        }
+#endif
+
+        MutexLock lk(&_background_work_mutex);
+        _thread_options = resolved;
+        Status result;
+        for (const BackgroundThread &thread : _threads)
+        {
+            Status s = ApplyThreadOptionsLocked(thread);
+            if (result.ok() && !s.ok())
+            {
+                result = s;
+            }
+        }
+        return result;
+    }
+
+    Status
+    PosixEnv::GetBackgroundThreadCpuTimes(vector<BackgroundThreadCpuTime> *result)
+    {
+        result->clear();
+        MutexLock lk(&_background_work_mutex);
+        for (const BackgroundThread &thread : _threads)
+        {
+            uint64_t cpu_micros = 0;
+            Status s = ThreadCpuMicros(thread.handle, &cpu_micros);
+            if (!s.ok())
+            {
+                return s;
+            }
+            result->push_back(BackgroundThreadCpuTime{thread.name, cpu_micros});
+        }
+        return Status::OK();
+    }
+
+    void
+    PosixEnv::RegisterCurrentThread(const char *name)
+    {
+        SetCurrentThreadName(name);
+
+        BackgroundThread thread;
+        thread.name = name;
+        thread.handle = ::pthread_self();
+#if defined(__linux__)
+        thread.tid = static_cast<pid_t>(::syscall(SYS_gettid));
+#endif
+
+        MutexLock lk(&_background_work_mutex);
+        _threads.push_back(thread);
+
+        // There is no caller to report a failure to; the thread keeps
+        // running with whatever could be applied.
+        ApplyThreadOptionsLocked(thread);
+    }
+
+    Status
+    PosixEnv::ApplyThreadOptionsLocked(const BackgroundThread &thread)
+    {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        if (_thread_options.cpu_set.empty())
+        {
+            cpus = _default_cpus;
+        }
+        else
+        {
+            CPU_ZERO(&cpus);
+            for (int cpu : _thread_options.cpu_set)
+            {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        int error = ::pthread_setaffinity_np(thread.handle, sizeof(cpus), &cpus);
+        if (error != 0)
+        {
+            return PosixError("pthread_setaffinity_np", error);
+        }
+
+        struct sched_param param;
+        param.sched_priority = 0;
+        const int policy = _thread_options.batch_scheduling ? SCHED_BATCH : SCHED_OTHER;
+        if (::sched_setscheduler(thread.tid, policy, &param) != 0)
+        {
+            return PosixError("sched_setscheduler", errno);
+        }
+
+        /*
+         * On Linux the nice value is a per-thread attribute. Lowering it
+         * takes CAP_SYS_NICE, so leave it alone when it does not change;
+         * otherwise unprivileged callers could not even reapply defaults.
+         */
+        const int nice = _default_nice + _thread_options.nice_increment;
+        errno = 0;
+        const int current_nice = ::getpriority(PRIO_PROCESS, thread.tid);
+        if ((current_nice != nice || errno != 0) && ::setpriority(PRIO_PROCESS, thread.tid, nice) != 0)
+        {
+            return PosixError("setpriority", errno);
+        }
+#endif
+        return Status::OK();
+    }
+
+    void
+    PosixEnv::EnqueueLocked(function<void(void *)> work_function, void *arg, uint64_t task_id)
+    {
+        // Start the background thread, if we haven't done so already.
+        if (!_started_background_thread)
+        {
+            _started_background_thread = true;
+            thread background_thread(PosixEnv::BackgroundThreadEntryPoint, this);
+            background_thread.detach();
+        }
+
+        // If the queue is empty, the background thread may be waiting for work.
+        if (_background_work_queue.empty())
+        {
+            _background_work_cv.Signal();
+        }
+
+        _background_work_queue.emplace(move(work_function), arg, task_id);
+    }
+
+    uint64_t
+    PosixEnv::AllocateTaskLocked()
+    {
+        uint32_t slot;
+        if (_free_tasks.empty())
+        {
+            slot = static_cast<uint32_t>(_tasks.size());
+            _tasks.push_back(Task{1, kTaskFree, 0});
+        }
+        else
+        {
+            slot = _free_tasks.back();
+            _free_tasks.pop_back();
+        }
+
+        Task *task = &_tasks[slot];
+        task->state = kTaskPending;
+        task->deadline_tick = 0;
+        return (static_cast<uint64_t>(task->generation) << 32) | slot;
+    }
+
+    // Returns the task behind "task_id", or nullptr if it has finished or was cancelled.
+    PosixEnv::Task *
+    PosixEnv::FindTaskLocked(uint64_t task_id)
+    {
+        const uint32_t slot = static_cast<uint32_t>(task_id);
+        const uint32_t generation = static_cast<uint32_t>(task_id >> 32);
+        if (slot >= _tasks.size() || _tasks[slot].generation != generation)
+        {
+            return nullptr;
+        }
+        return &_tasks[slot];
+    }
+
+    void
+    PosixEnv::ReleaseTaskLocked(uint64_t task_id)
+    {
+        const uint32_t slot = static_cast<uint32_t>(task_id);
+        Task *task = &_tasks[slot];
+
+        // Generation 0 is skipped so that no task id is ever 0.
+        if (++task->generation == 0)
+        {
+            task->generation = 1;
+        }
+        task->state = kTaskFree;
+        _free_tasks.push_back(slot);
+
+        if (_task_waiters > 0)
+        {
+            _task_done_cv.SignalAll();
+        }
+    }
+
     void
     PosixEnv::BackgroundThreadMain()
     {
+        RegisterCurrentThread("leveldb.bg");
         while (true)
         {
             function<void(void *)> background_work_function;
             void *background_work_arg;
+            uint64_t task_id;
 
             {
-                unique_lock<mutex> lk(_background_work_mutex);
+                MutexLock lk(&_background_work_mutex);
 
                 // Wait until there is work to be done.
                 while (_background_work_queue.empty())
                 {
-                    _background_work_cv.wait(lk);
+                    _background_work_cv.Wait();
                 }
 
                 assert(!_background_work_queue.empty());
-                background_work_function = _background_work_queue.front().work_function;
+                background_work_function = move(_background_work_queue.front().work_function);
                 background_work_arg = _background_work_queue.front().arg;
+                task_id = _background_work_queue.front().task_id;
                 _background_work_queue.pop();
+
+                if (task_id != 0)
+                {
+                    Task *task = FindTaskLocked(task_id);
+                    if (task == nullptr)
+                    {
+                        // Cancelled before it started.
+                        continue;
+                    }
+                    task->state = kTaskRunning;
+                }
             }
             background_work_function(background_work_arg);
+
+            if (task_id != 0)
+            {
+                MutexLock lk(&_background_work_mutex);
+                ReleaseTaskLocked(task_id);
+            }
         }
     }
-} // namespace leveldb.
\ No newline at end of file
+
+    void
+    PosixEnv::TimerThreadMain()
+    {
+        RegisterCurrentThread("leveldb.timer");
+        MutexLock lk(&_background_work_mutex);
+        while (true)
+        {
+            // Sleep until ScheduleAfter() adds a timer.
+            while (_num_timers == 0)
+            {
+                _timer_cv.Wait();
+            }
+
+            // Visit the slots of every tick that has passed. After a long stall,
+            // one revolution is enough to see every entry.
+            const uint64_t now_tick = NowMicros() / kTimerTickMicros;
+            size_t visited = 0;
+            while (_timer_tick <= now_tick && visited < kTimerWheelSize)
+            {
+                vector<TimerEntry> &slot = _timer_wheel[_timer_tick % kTimerWheelSize];
+                size_t i = 0;
+                while (i < slot.size())
+                {
+                    if (slot[i].deadline_tick > now_tick)
+                    {
+                        // Due in a later revolution.
+                        i++;
+                        continue;
+                    }
+
+                    TimerEntry &entry = slot[i];
+                    Task *task = FindTaskLocked(entry.task_id);
+                    if (task != nullptr)
+                    {
+                        task->deadline_tick = 0;
+                        EnqueueLocked(move(entry.work_function), entry.arg, entry.task_id);
+                    }
+                    if (i + 1 != slot.size())
+                    {
+                        entry = move(slot.back());
+                    }
+                    slot.pop_back();
+                    _num_timers--;
+                }
+                _timer_tick++;
+                visited++;
+            }
+            if (_timer_tick <= now_tick)
+            {
+                _timer_tick = now_tick + 1;
+            }
+
+            _timer_cv.WaitFor(kTimerTickMicros);
+        }
+    }
+
+    namespace
+    {
+
+        /*
+         * Wraps an Env instance whose destructor is never created.
+         *
+         * Intended usage:
+         *   static SingletonEnv<PosixEnv> default_env;
+         *   return default_env.env();
+         */
+        template <typename EnvType>
+        class SingletonEnv
+        {
+        public:
+            SingletonEnv()
+            {
+                static_assert(sizeof(_env_storage) >= sizeof(EnvType),
+                              "_env_storage will not fit the Env");
+                static_assert(alignof(decltype(_env_storage)) >= alignof(EnvType),
+                              "_env_storage does not meet the Env's alignment needs");
+                new (&_env_storage) EnvType();
+            }
+
+            ~SingletonEnv() = default;
+
+            SingletonEnv(const SingletonEnv &) = delete;
+            SingletonEnv &operator=(const SingletonEnv &) = delete;
+
+            Env *env()
+            {
+                return reinterpret_cast<Env *>(&_env_storage);
+            }
+
+        private:
+            typename aligned_storage<sizeof(EnvType), alignof(EnvType)>::type _env_storage;
+        };
+
+        using PosixDefaultEnv = SingletonEnv<PosixEnv>;
+
+    } // namespace
+
+    Env *
+    Env::Default()
+    {
+        static PosixDefaultEnv env_container;
+        return env_container.env();
+    }
+} // namespace leveldb.
@@ -0,0 +1,317 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/env.h"
+
+#include <atomic>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <thread>
+#endif
+using namespace std;
+
+namespace leveldb {
+
+static void SetAtomicBool(void *atomic_bool_ptr) {
+    reinterpret_cast<atomic<bool> *>(atomic_bool_ptr)->store(true);
+}
+
+// Blocks the background thread until "release" is set.
+struct Blocker {
+    atomic<bool> started;
+    atomic<bool> release;
+
+    Blocker() : started(false), release(false) {}
+
+    static void Run(void *arg) {
+        Blocker *b = reinterpret_cast<Blocker *>(arg);
+        b->started = true;
+        while (!b->release) {
+            Env::Default()->SleepForMicroseconds(1000);
+        }
+    }
+};
+
+TEST(EnvTest, ScheduleWithHandleWait) {
+    Env *env = Env::Default();
+    atomic<bool> called(false);
+    ScheduleHandle handle = env->ScheduleWithHandle(&SetAtomicBool, &called);
+    ASSERT_TRUE(handle.Valid());
+    handle.Wait();
+    ASSERT_TRUE(called);
+
+    // Waiting again, or cancelling, a finished item is harmless.
+    handle.Wait();
+    ASSERT_FALSE(handle.Cancel());
+}
+
+TEST(EnvTest, RunMany) {
+    Env *env = Env::Default();
+    const int kItems = 1000;
+    atomic<int> last_id(0);
+
+    struct Callback {
+        atomic<int> *last_id_ptr;
+        const int id;
+
+        Callback(atomic<int> *p, int i) : last_id_ptr(p), id(i) {}
+
+        static void Run(void *arg) {
+            Callback *callback = reinterpret_cast<Callback *>(arg);
+            int current_id = callback->last_id_ptr->load();
+            ASSERT_EQ(callback->id - 1, current_id);
+            callback->last_id_ptr->store(callback->id);
+        }
+    };
+
+    vector<Callback> callbacks;
+    callbacks.reserve(kItems);
+    vector<ScheduleHandle> handles;
+    for (int i = 1; i <= kItems; i++) {
+        callbacks.emplace_back(&last_id, i);
+        handles.push_back(env->ScheduleWithHandle(&Callback::Run, &callbacks.back()));
+    }
+    for (const ScheduleHandle& handle : handles) {
+        handle.Wait();
+    }
+    ASSERT_EQ(kItems, last_id.load());
+}
+
+TEST(EnvTest, CancelBeforeStart) {
+    Env *env = Env::Default();
+    Blocker blocker;
+    ScheduleHandle blocking = env->ScheduleWithHandle(&Blocker::Run, &blocker);
+    while (!blocker.started) {
+        env->SleepForMicroseconds(1000);
+    }
+
+    atomic<bool> called(false);
+    ScheduleHandle handle = env->ScheduleWithHandle(&SetAtomicBool, &called);
+    ASSERT_TRUE(handle.Cancel());
+    ASSERT_FALSE(handle.Cancel());
+
+    // A running item can not be cancelled.
+    ASSERT_FALSE(blocking.Cancel());
+
+    blocker.release = true;
+    blocking.Wait();
+    handle.Wait();
+
+    // Flush the queue past the cancelled item.
+    atomic<bool> flushed(false);
+    env->ScheduleWithHandle(&SetAtomicBool, &flushed).Wait();
+    ASSERT_TRUE(flushed);
+    ASSERT_FALSE(called);
+}
+
+TEST(EnvTest, ScheduleAfter) {
+    Env *env = Env::Default();
+    atomic<bool> called(false);
+
+    const uint64_t start = env->NowMicros();
+    ScheduleHandle handle = env->ScheduleAfter(&SetAtomicBool, &called, 20000);
+    handle.Wait();
+    ASSERT_TRUE(called);
+    ASSERT_GE(env->NowMicros() - start, 20000);
+}
+
+TEST(EnvTest, ScheduleAfterOrdering) {
+    Env *env = Env::Default();
+    atomic<int> order(0);
+    atomic<int> first(0);
+    atomic<int> second(0);
+
+    struct Step {
+        atomic<int> *order;
+        atomic<int> *slot;
+
+        static void Run(void *arg) {
+            Step *step = reinterpret_cast<Step *>(arg);
+            step->slot->store(step->order->fetch_add(1) + 1);
+        }
+    };
+
+    // Due in a later revolution of the timer wheel than the second one.
+    Step late = {&order, &second};
+    Step early = {&order, &first};
+    ScheduleHandle h2 = env->ScheduleAfter(&Step::Run, &late, 600 * 1000);
+    ScheduleHandle h1 = env->ScheduleAfter(&Step::Run, &early, 5 * 1000);
+    h1.Wait();
+    h2.Wait();
+    ASSERT_EQ(1, first.load());
+    ASSERT_EQ(2, second.load());
+}
+
+TEST(EnvTest, ScheduleAfterWhileWheelTurns) {
+    Env *env = Env::Default();
+
+    // Keeps the timer wheel turning throughout.
+    ScheduleHandle far = env->ScheduleAfter([](void *) {}, nullptr, 60 * 1000 * 1000);
+
+    // A short delay never waits for another revolution of the wheel.
+    for (int i = 0; i < 200; i++) {
+        const uint64_t start = env->NowMicros();
+        env->ScheduleAfter([](void *) {}, nullptr, 1000 + i % 3 * 1000).Wait();
+        ASSERT_LT(env->NowMicros() - start, 250 * 1000);
+    }
+    ASSERT_TRUE(far.Cancel());
+}
+
+TEST(EnvTest, CancelDelayed) {
+    Env *env = Env::Default();
+    atomic<bool> called(false);
+    ScheduleHandle handle = env->ScheduleAfter(&SetAtomicBool, &called, 10000);
+    ASSERT_TRUE(handle.Cancel());
+    handle.Wait();
+
+    env->SleepForMicroseconds(30000);
+    ASSERT_FALSE(called);
+}
+
+TEST(EnvTest, BackgroundThreadCpuTime) {
+    Env *env = Env::Default();
+
+    // Burn 20ms of CPU on the background thread, by its own CPU clock so
+    // that time spent descheduled does not count.
+    env->ScheduleWithHandle([](void *arg) {
+        auto cpu_micros = []() {
+            struct timespec ts;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+        };
+        const uint64_t start = cpu_micros();
+        volatile uint64_t sink = 0;
+        while (cpu_micros() - start < 20000) {
+            sink = sink + 1;
+        }
+    }, nullptr).Wait();
+
+    vector<BackgroundThreadCpuTime> times;
+    ASSERT_TRUE(env->GetBackgroundThreadCpuTimes(&times).ok());
+    bool found = false;
+    for (const BackgroundThreadCpuTime& t : times) {
+        if (t.name == "leveldb.bg") {
+            found = true;
+            ASSERT_GE(t.cpu_micros, 15000);
+        }
+    }
+    ASSERT_TRUE(found);
+}
+
+TEST(EnvTest, AccessPatternHints) {
+    Env *env = Env::Default();
+    const string fname = "/tmp/leveldb_env_test_hints";
+    WritableFile *writable_file;
+    ASSERT_TRUE(env->NewWritableFile(fname, &writable_file).ok());
+    ASSERT_TRUE(writable_file->Append("hello world").ok());
+    ASSERT_TRUE(writable_file->Close().ok());
+    delete writable_file;
+
+    const AccessPattern patterns[] = {
+        AccessPattern::kSequential, AccessPattern::kRandom, AccessPattern::kWillNeed,
+        AccessPattern::kDontNeed, AccessPattern::kNormal,
+    };
+    SequentialFile *seq_file;
+    RandomAccessFile *rand_file;
+    ASSERT_TRUE(env->NewSequentialFile(fname, &seq_file).ok());
+    ASSERT_TRUE(env->NewRandomAccessFile(fname, &rand_file).ok());
+    for (AccessPattern pattern : patterns) {
+        ASSERT_TRUE(seq_file->Hint(pattern).ok());
+        ASSERT_TRUE(rand_file->Hint(pattern).ok());
+    }
+
+    // Hints never change what is read.
+    char scratch[20];
+    Slice result;
+    ASSERT_TRUE(rand_file->Read(6, 5, &result, scratch).ok());
+    ASSERT_EQ("world", result.ToString());
+    ASSERT_TRUE(seq_file->Read(5, &result, scratch).ok());
+    ASSERT_EQ("hello", result.ToString());
+
+    delete seq_file;
+    delete rand_file;
+    ASSERT_TRUE(env->RemoveFile(fname).ok());
+}
+
+#if defined(__linux__)
+// Whether this process may lower a thread's nice value again, which
+// takes CAP_SYS_NICE.
+static bool CanLowerNice() {
+    bool result = false;
+    thread probe([&result]() {
+        const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        const int nice = getpriority(PRIO_PROCESS, tid);
+        if (setpriority(PRIO_PROCESS, tid, nice + 1) == 0) {
+            result = (setpriority(PRIO_PROCESS, tid, nice) == 0);
+        }
+    });
+    probe.join();
+    return result;
+}
+
+TEST(EnvTest, BackgroundThreadOptions) {
+    Env *env = Env::Default();
+
+    // Make sure the background thread exists before changing its options.
+    env->ScheduleWithHandle([](void *) {}, nullptr).Wait();
+
+    BackgroundThreadOptions options;
+    options.cpu_set.push_back(0);
+    options.nice_increment = 1;
+    options.batch_scheduling = true;
+    ASSERT_TRUE(env->SetBackgroundThreadOptions(options).ok());
+
+    struct Observed {
+        int num_cpus;
+        bool on_cpu0;
+        int policy;
+        int nice;
+    } observed;
+    env->ScheduleWithHandle([](void *arg) {
+        Observed *o = reinterpret_cast<Observed *>(arg);
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        sched_getaffinity(0, sizeof(cpus), &cpus);
+        o->num_cpus = CPU_COUNT(&cpus);
+        o->on_cpu0 = CPU_ISSET(0, &cpus);
+        o->policy = sched_getscheduler(0);
+        o->nice = getpriority(PRIO_PROCESS, 0);
+    }, &observed).Wait();
+
+    ASSERT_EQ(1, observed.num_cpus);
+    ASSERT_TRUE(observed.on_cpu0);
+    ASSERT_EQ(SCHED_BATCH, observed.policy);
+    ASSERT_EQ(getpriority(PRIO_PROCESS, 0) + 1, observed.nice);
+
+    // Reapplying the same options needs no privilege.
+    ASSERT_TRUE(env->SetBackgroundThreadOptions(options).ok());
+
+    // Default options restore the original scheduling; the nice value
+    // only if we may lower it.
+    const bool can_lower_nice = CanLowerNice();
+    ASSERT_EQ(can_lower_nice, env->SetBackgroundThreadOptions(BackgroundThreadOptions()).ok());
+    env->ScheduleWithHandle([](void *arg) {
+        Observed *o = reinterpret_cast<Observed *>(arg);
+        o->policy = sched_getscheduler(0);
+        o->nice = getpriority(PRIO_PROCESS, 0);
+    }, &observed).Wait();
+    ASSERT_EQ(SCHED_OTHER, observed.policy);
+    ASSERT_EQ(getpriority(PRIO_PROCESS, 0) + (can_lower_nice ? 0 : 1), observed.nice);
+
+    options = BackgroundThreadOptions();
+    options.cpu_set.push_back(-1);
+    ASSERT_TRUE(env->SetBackgroundThreadOptions(options).IsInvalidArgument());
+}
+#endif
+
+} // namespace leveldb.
@@ -0,0 +1,58 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "group_commit.h"
+
+using namespace std;
+
+namespace leveldb {
+
+Status
+GroupCommit::Sync(uint64_t offset, const SyncFunction& sync)
+{
+    unique_lock<mutex> l(_mu);
+    _stats.requests++;
+    while (true) {
+        if (!_error.ok()) {
+            return _error;
+        }
+        if (_synced_offset >= offset) {
+            return Status::OK();
+        }
+        if (!_syncing) {
+            break;
+        }
+        _cv.wait(l);
+    }
+
+    // Lead a sync covering every write made so far, including those of
+    // the callers that will queue up behind it.
+    _syncing = true;
+    _stats.syncs++;
+    l.unlock();
+
+    uint64_t synced_offset = offset;
+    Status s = sync(&synced_offset);
+
+    l.lock();
+    _syncing = false;
+    if (s.ok()) {
+        if (synced_offset > _synced_offset) {
+            _synced_offset = synced_offset;
+        }
+    } else {
+        _error = s;
+    }
+    _cv.notify_all();
+    return s;
+}
+
+GroupCommit::Stats
+GroupCommit::GetStats() const
+{
+    lock_guard<mutex> l(_mu);
+    return _stats;
+}
+
+} // namespace leveldb.
@@ -0,0 +1,77 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/status.h"
+#include "port/thread_annotations.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Coalesces concurrent requests to make a file durable up to some offset.
+ *
+ * The first caller becomes the leader and issues one sync, which makes
+ * everything written to the file so far durable. Callers arriving while
+ * that sync runs wait for it; if it already covers their offset they
+ * return without syncing, otherwise one of them leads the next sync on
+ * behalf of all writes that arrived in the meantime. The number of syncs
+ * thus grows with elapsed sync latency, not with the number of writers.
+ *
+ * A failed sync is sticky: every later request fails with the same
+ * error, since a retried fsync() may report success for data the kernel
+ * has already dropped.
+ *
+ * Thread-safe.
+ */
+class GroupCommit {
+public:
+    // Counters since construction.
+    struct Stats {
+        uint64_t requests;  // Calls to Sync().
+        uint64_t syncs;     // Syncs issued on their behalf.
+    };
+
+    /*
+     * Performs a sync and stores in *synced_offset the file offset it
+     * made durable, i.e. the number of bytes written before it started.
+     */
+    using SyncFunction = function<Status(uint64_t *synced_offset)>;
+
+    GroupCommit() : _synced_offset(0), _syncing(false), _stats{0, 0} {}
+
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    /*
+     * Returns once the first "offset" bytes of the file are durable,
+     * calling "sync" at most once if no concurrent sync covers them.
+     */
+    Status Sync(uint64_t offset, const SyncFunction& sync);
+
+    Stats GetStats() const;
+
+private:
+    mutable mutex _mu;
+    condition_variable _cv;
+
+    // Bytes known to be durable.
+    uint64_t _synced_offset GUARDED_BY(_mu);
+
+    // True while a leader is syncing.
+    bool _syncing GUARDED_BY(_mu);
+
+    // The first failure, returned to every later request.
+    Status _error GUARDED_BY(_mu);
+
+    Stats _stats GUARDED_BY(_mu);
+};
+
+} // namespace leveldb.
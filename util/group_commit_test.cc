@@ -0,0 +1,123 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "group_commit.h"
+
+#include "leveldb/env.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(GroupCommitTest, Single) {
+    GroupCommit group_commit;
+    int syncs = 0;
+    auto sync = [&syncs](uint64_t *synced_offset) {
+        syncs++;
+        *synced_offset = 100;
+        return Status::OK();
+    };
+
+    ASSERT_TRUE(group_commit.Sync(10, sync).ok());
+    ASSERT_EQ(1, syncs);
+
+    // Already covered by the first sync.
+    ASSERT_TRUE(group_commit.Sync(100, sync).ok());
+    ASSERT_EQ(1, syncs);
+
+    ASSERT_TRUE(group_commit.Sync(101, sync).ok());
+    ASSERT_EQ(2, syncs);
+
+    GroupCommit::Stats stats = group_commit.GetStats();
+    ASSERT_EQ(3, stats.requests);
+    ASSERT_EQ(2, stats.syncs);
+}
+
+TEST(GroupCommitTest, Coalesce) {
+    GroupCommit group_commit;
+    const int kThreads = 8;
+    const int kWritesPerThread = 50;
+
+    // A fake file: writers bump "written", a sync takes 2ms and makes
+    // everything written before it durable.
+    atomic<uint64_t> written(0);
+    atomic<uint64_t> durable(0);
+    auto sync = [&written, &durable](uint64_t *synced_offset) {
+        *synced_offset = written.load();
+        Env::Default()->SleepForMicroseconds(2000);
+        durable.store(*synced_offset);
+        return Status::OK();
+    };
+
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kWritesPerThread; i++) {
+                const uint64_t offset = written.fetch_add(1) + 1;
+                ASSERT_TRUE(group_commit.Sync(offset, sync).ok());
+                ASSERT_GE(durable.load(), offset);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    GroupCommit::Stats stats = group_commit.GetStats();
+    ASSERT_EQ(kThreads * kWritesPerThread, stats.requests);
+    ASSERT_LT(stats.syncs, stats.requests / 2);
+}
+
+TEST(GroupCommitTest, ErrorIsSticky) {
+    GroupCommit group_commit;
+    ASSERT_TRUE(group_commit.Sync(1, [](uint64_t *synced_offset) {
+        return Status::IOError("sync failed");
+    }).IsIOError());
+
+    int syncs = 0;
+    ASSERT_TRUE(group_commit.Sync(1, [&syncs](uint64_t *synced_offset) {
+        syncs++;
+        return Status::OK();
+    }).IsIOError());
+    ASSERT_EQ(0, syncs);
+}
+
+TEST(GroupCommitTest, PosixWritableFile) {
+    Env *env = Env::Default();
+    const char *tmpdir = getenv("TEST_TMPDIR");
+    const string fname = string(tmpdir != nullptr ? tmpdir : "/tmp") + "/group_commit_test.log";
+    const int kThreads = 4;
+    const int kRecordsPerThread = 100;
+    const string record(100, 'x');
+
+    WritableFile *file;
+    ASSERT_TRUE(env->NewWritableFile(fname, &file).ok());
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([file, &record]() {
+            for (int i = 0; i < kRecordsPerThread; i++) {
+                ASSERT_TRUE(file->Append(record).ok());
+                ASSERT_TRUE(file->Sync().ok());
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    ASSERT_TRUE(file->Close().ok());
+    delete file;
+
+    uint64_t size;
+    ASSERT_TRUE(env->GetFileSize(fname, &size).ok());
+    ASSERT_EQ(kThreads * kRecordsPerThread * record.size(), size);
+    ASSERT_TRUE(env->RemoveFile(fname).ok());
+}
+
+} // namespace leveldb.
@@ -5,15 +5,25 @@
 #include "hash.h"
 #include "coding.h"
 
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_HASH64_X86 1
+#include <immintrin.h>
+#endif
+
 namespace leveldb {
 
-uint32_t
-Hash(const char *data, size_t n, uint32_t seed) {
-  // Similar to murmur hash
-  const uint32_t m = 0xc6a4a793;
-  const uint32_t r = 24;
-  const char *limit = data + n;
-  uint32_t h = seed ^ (n * m);
+namespace {
+
+// Hash() constants.
+const uint32_t kHashMultiplier = 0xc6a4a793;
+const uint32_t kHashTailShift = 24;
+
+// Hash() of data[0,limit-data-1] after its first words brought the state
+// to "h".
+inline uint32_t HashRemaining(uint32_t h, const char *data, const char *limit) {
+  const uint32_t m = kHashMultiplier;
 
   // Pick up four bytes at a time.
   while (data + 4 <= limit) {
@@ -35,10 +45,461 @@ Hash(const char *data, size_t n, uint32_t seed) {
     case 1:
       h += static_cast<uint8_t>(data[0]);
       h *= m;
-      h ^= (h >> r);
+      h ^= (h >> kHashTailShift);
       break;
   }
   return h;
 }
 
+}  // namespace
+
+uint32_t
+Hash(const char *data, size_t n, uint32_t seed) {
+  // Similar to murmur hash
+  return HashRemaining(seed ^ (n * kHashMultiplier), data, data + n);
+}
+
+namespace {
+
+// Hash64() constants. Changing any of them changes its output.
+const uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+const uint64_t kPrime3 = 0x165667b19e3779f9ull;
+const uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+const uint64_t kPrime5 = 0x27d4eb2f165667c5ull;
+const uint32_t kPrime32 = 0x9e3779b1u;
+
+// Inputs longer than kMidSizeMax are hashed in stripes of kStripeLen bytes,
+// one 64-bit lane per word, and the lanes are scrambled after every block
+// of kStripesPerBlock stripes.
+const size_t kMidSizeMax = 256;
+const size_t kStripeLen = 64;
+const size_t kLanes = 8;
+const size_t kStripesPerBlock = 16;
+
+// Layout of the secret. Stripe s of a block is keyed with words
+// [s, s + kLanes), and the last stripe of the input with words
+// [kLastStripeKey, kLastStripeKey + kLanes). Only the first kLongKeyWords
+// words are seeded.
+const size_t kLastStripeKey = 17;
+const size_t kScrambleKey = 24;
+const size_t kLongKeyWords = 32;
+const size_t kMergeKey = 32;
+const size_t kSecretWords = 40;
+
+// kSecret.words[i] is output i of SplitMix64 started from zero.
+struct Secret {
+  uint64_t words[kSecretWords] = {};
+
+  constexpr Secret() {
+    uint64_t state = 0;
+    for (size_t i = 0; i < kSecretWords; i++) {
+      state += 0x9e3779b97f4a7c15ull;
+      uint64_t z = state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      words[i] = z ^ (z >> 31);
+    }
+  }
+};
+
+constexpr Secret kSecret;
+
+inline uint64_t Rotl64(uint64_t v, int bits) {
+  return (v << bits) | (v >> (64 - bits));
+}
+
+// Multiplies to 128 bits and folds the halves together.
+inline uint64_t Mul128Fold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+  const uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+  const uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+  const uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+  const uint64_t hi_hi = (a >> 32) * (b >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+  const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  const uint64_t lower = (cross << 32) | (lo_lo & 0xffffffff);
+  return lower ^ upper;
+#endif
+}
+
+// The MurmurHash3 finalizer; a bijection.
+inline uint64_t Fmix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+// REQUIRES: n <= 16
+uint64_t HashShort(const char *p, size_t n, uint64_t seed) {
+  const uint64_t *secret = kSecret.words;
+  if (n > 8) {
+    const uint64_t lo = DecodeFixed64(p) ^ (secret[0] + seed);
+    const uint64_t hi = DecodeFixed64(p + n - 8) ^ (secret[1] - seed);
+    return Fmix64(n + Rotl64(lo, 32) + hi + Mul128Fold(lo, hi));
+  }
+  if (n >= 4) {
+    const uint64_t a = DecodeFixed32(p);
+    const uint64_t b = DecodeFixed32(p + n - 4);
+    const uint64_t v = ((a << 32) | b) ^ (secret[2] + seed);
+    return Fmix64(v + n * kPrime2);
+  }
+  if (n > 0) {
+    const uint64_t c = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+                       (static_cast<uint64_t>(static_cast<uint8_t>(p[n >> 1])) << 24) |
+                       static_cast<uint64_t>(static_cast<uint8_t>(p[n - 1])) |
+                       (static_cast<uint64_t>(n) << 8);
+    return Fmix64(c ^ (secret[3] + seed));
+  }
+  return Fmix64(seed ^ secret[4]);
+}
+
+inline uint64_t Mix16(const char *p, uint64_t k0, uint64_t k1, uint64_t seed) {
+  return Mul128Fold(DecodeFixed64(p) ^ (k0 + seed), DecodeFixed64(p + 8) ^ (k1 - seed));
+}
+
+// REQUIRES: 16 < n <= kMidSizeMax
+uint64_t HashMid(const char *p, size_t n, uint64_t seed) {
+  const uint64_t *secret = kSecret.words;
+  uint64_t acc0 = n * kPrime1;
+  uint64_t acc1 = kPrime2;
+
+  // 32 bytes per step, into two independent accumulators.
+  size_t i = 0;
+  for (size_t k = 0; i + 32 <= n; i += 32, k += 4) {
+    acc0 += Mix16(p + i, secret[k], secret[k + 1], seed);
+    acc1 += Mix16(p + i + 16, secret[k + 2], secret[k + 3], seed);
+  }
+  if (n - i > 16) {
+    acc0 += Mix16(p + i, secret[32], secret[33], seed);
+  }
+  if (n - i > 0) {
+    acc1 += Mix16(p + n - 16, secret[34], secret[35], seed);
+  }
+  return Fmix64(acc0 + Rotl64(acc1, 29));
+}
+
+/*
+ * The long input lanes. For every stripe s and lane i, with d the i-th
+ * little-endian word of the stripe and k = d ^ key[s + i]:
+ *
+ *     acc[i] += (k & 0xffffffff) * (k >> 32)
+ *     acc[i ^ 1] += d
+ *
+ * and after every block each lane is scrambled with
+ *
+ *     acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ key[kScrambleKey + i]) * kPrime32
+ *
+ * Only 32x32 bit multiplies are used so that SIMD units can do them.
+ */
+using AccumulateFunction = void (*)(uint64_t *acc, const char *p, size_t stripes,
+                                    const uint64_t *key);
+using ScrambleFunction = void (*)(uint64_t *acc, const uint64_t *key);
+
+struct LongOps {
+  AccumulateFunction accumulate;
+  ScrambleFunction scramble;
+};
+
+void AccumulatePortable(uint64_t *acc, const char *p, size_t stripes, const uint64_t *key) {
+  for (size_t s = 0; s < stripes; s++) {
+    for (size_t i = 0; i < kLanes; i++) {
+      const uint64_t d = DecodeFixed64(p + s * kStripeLen + 8 * i);
+      const uint64_t k = d ^ key[s + i];
+      acc[i ^ 1] += d;
+      acc[i] += (k & 0xffffffff) * (k >> 32);
+    }
+  }
+}
+
+void ScramblePortable(uint64_t *acc, const uint64_t *key) {
+  for (size_t i = 0; i < kLanes; i++) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= key[i];
+    acc[i] = a * kPrime32;
+  }
+}
+
+const LongOps kPortableOps = {&AccumulatePortable, &ScramblePortable};
+
+#if defined(LEVELDB_HASH64_X86)
+
+// SSE2 is part of x86-64, so this needs no runtime check.
+void AccumulateSse2(uint64_t *acc, const char *p, size_t stripes, const uint64_t *key) {
+  __m128i *a = reinterpret_cast<__m128i *>(acc);
+  __m128i lanes[4];
+  for (int i = 0; i < 4; i++) {
+    lanes[i] = _mm_loadu_si128(a + i);
+  }
+  for (size_t s = 0; s < stripes; s++) {
+    const __m128i *d_ptr = reinterpret_cast<const __m128i *>(p + s * kStripeLen);
+    const __m128i *k_ptr = reinterpret_cast<const __m128i *>(key + s);
+    for (int i = 0; i < 4; i++) {
+      const __m128i d = _mm_loadu_si128(d_ptr + i);
+      const __m128i k = _mm_xor_si128(d, _mm_loadu_si128(k_ptr + i));
+      const __m128i k_hi = _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1));
+      const __m128i product = _mm_mul_epu32(k, k_hi);
+      const __m128i d_swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+      lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, d_swapped));
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128(a + i, lanes[i]);
+  }
+}
+
+void ScrambleSse2(uint64_t *acc, const uint64_t *key) {
+  __m128i *a = reinterpret_cast<__m128i *>(acc);
+  const __m128i *k_ptr = reinterpret_cast<const __m128i *>(key);
+  const __m128i prime = _mm_set1_epi32(kPrime32);
+  for (int i = 0; i < 4; i++) {
+    __m128i v = _mm_loadu_si128(a + i);
+    v = _mm_xor_si128(v, _mm_srli_epi64(v, 47));
+    v = _mm_xor_si128(v, _mm_loadu_si128(k_ptr + i));
+    // 64x32 bit multiply from two 32x32 bit ones.
+    const __m128i lo = _mm_mul_epu32(v, prime);
+    const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(v, 32), prime);
+    _mm_storeu_si128(a + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+  }
+}
+
+__attribute__((target("avx2")))
+void AccumulateAvx2(uint64_t *acc, const char *p, size_t stripes, const uint64_t *key) {
+  __m256i *a = reinterpret_cast<__m256i *>(acc);
+  __m256i lanes[2] = {_mm256_loadu_si256(a), _mm256_loadu_si256(a + 1)};
+  for (size_t s = 0; s < stripes; s++) {
+    const __m256i *d_ptr = reinterpret_cast<const __m256i *>(p + s * kStripeLen);
+    const __m256i *k_ptr = reinterpret_cast<const __m256i *>(key + s);
+    for (int i = 0; i < 2; i++) {
+      const __m256i d = _mm256_loadu_si256(d_ptr + i);
+      const __m256i k = _mm256_xor_si256(d, _mm256_loadu_si256(k_ptr + i));
+      const __m256i k_hi = _mm256_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1));
+      const __m256i product = _mm256_mul_epu32(k, k_hi);
+      const __m256i d_swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+      lanes[i] = _mm256_add_epi64(lanes[i], _mm256_add_epi64(product, d_swapped));
+    }
+  }
+  _mm256_storeu_si256(a, lanes[0]);
+  _mm256_storeu_si256(a + 1, lanes[1]);
+}
+
+__attribute__((target("avx2")))
+void ScrambleAvx2(uint64_t *acc, const uint64_t *key) {
+  __m256i *a = reinterpret_cast<__m256i *>(acc);
+  const __m256i *k_ptr = reinterpret_cast<const __m256i *>(key);
+  const __m256i prime = _mm256_set1_epi32(kPrime32);
+  for (int i = 0; i < 2; i++) {
+    __m256i v = _mm256_loadu_si256(a + i);
+    v = _mm256_xor_si256(v, _mm256_srli_epi64(v, 47));
+    v = _mm256_xor_si256(v, _mm256_loadu_si256(k_ptr + i));
+    const __m256i lo = _mm256_mul_epu32(v, prime);
+    const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), prime);
+    _mm256_storeu_si256(a + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+  }
+}
+
+const LongOps kSse2Ops = {&AccumulateSse2, &ScrambleSse2};
+const LongOps kAvx2Ops = {&AccumulateAvx2, &ScrambleAvx2};
+
+#endif
+
+bool CpuHasAvx2() {
+#if defined(LEVELDB_HASH64_X86)
+  static const bool has_avx2 = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+const LongOps& ChooseLongOps() {
+#if defined(LEVELDB_HASH64_X86)
+  if (CpuHasAvx2()) {
+    return kAvx2Ops;
+  }
+  return kSse2Ops;
+#else
+  return kPortableOps;
+#endif
+}
+
+const LongOps& ChosenLongOps() {
+  static const LongOps& ops = ChooseLongOps();
+  return ops;
+}
+
+// REQUIRES: n > kMidSizeMax
+uint64_t HashLong(const char *p, size_t n, uint64_t seed, const LongOps& ops) {
+  uint64_t acc[kLanes] = {
+    kPrime1, kPrime2, kPrime3, kPrime4, kPrime5, ~kPrime1, ~kPrime2, ~kPrime3,
+  };
+
+  const uint64_t *key = kSecret.words;
+  uint64_t seeded_key[kLongKeyWords];
+  if (seed != 0) {
+    for (size_t i = 0; i < kLongKeyWords; i += 2) {
+      seeded_key[i] = kSecret.words[i] + seed;
+      seeded_key[i + 1] = kSecret.words[i + 1] - seed;
+    }
+    key = seeded_key;
+  }
+
+  const size_t block_len = kStripeLen * kStripesPerBlock;
+  const size_t blocks = (n - 1) / block_len;
+  for (size_t b = 0; b < blocks; b++) {
+    ops.accumulate(acc, p + b * block_len, kStripesPerBlock, key);
+    ops.scramble(acc, key + kScrambleKey);
+  }
+
+  // The last stripe always ends at the end of the input, overlapping the
+  // previous one unless n is a multiple of kStripeLen.
+  const size_t stripes = (n - 1 - blocks * block_len) / kStripeLen;
+  ops.accumulate(acc, p + blocks * block_len, stripes, key);
+  ops.accumulate(acc, p + n - kStripeLen, 1, key + kLastStripeKey);
+
+  uint64_t h = n * kPrime1;
+  for (size_t i = 0; i < kLanes; i += 2) {
+    h += Mul128Fold(acc[i] ^ kSecret.words[kMergeKey + i],
+                    acc[i + 1] ^ kSecret.words[kMergeKey + i + 1]);
+  }
+  return Fmix64(h);
+}
+
+}  // namespace
+
+uint64_t
+Hash64(const char *data, size_t n, uint64_t seed) {
+  if (n <= 16) {
+    return HashShort(data, n, seed);
+  }
+  if (n <= kMidSizeMax) {
+    return HashMid(data, n, seed);
+  }
+  return HashLong(data, n, seed, ChosenLongOps());
+}
+
+uint64_t
+Hash64Portable(const char *data, size_t n, uint64_t seed) {
+  if (n <= 16) {
+    return HashShort(data, n, seed);
+  }
+  if (n <= kMidSizeMax) {
+    return HashMid(data, n, seed);
+  }
+  return HashLong(data, n, seed, kPortableOps);
+}
+
+namespace {
+
+// How many keys ahead Hash64Batch() prefetches.
+const size_t kPrefetchDistance = 8;
+
+#if defined(LEVELDB_HASH64_X86)
+
+// Below this many words in common, gathering costs more than lock-step
+// hashing saves.
+const size_t kMinGroupWords = 16;
+
+/*
+ * Hashes keys[0,7] with one AVX2 lane per key: the "common_words" words
+ * all of them have are hashed in lock-step, and each key is finished on
+ * its own.
+ */
+__attribute__((target("avx2")))
+void HashGroupAvx2(const Slice *keys, size_t common_words, uint32_t seed, uint32_t *out) {
+  // Words are gathered relative to the first key.
+  const char *base = keys[0].data();
+  int64_t offsets[8];
+  uint32_t sizes[8];
+  for (size_t j = 0; j < 8; j++) {
+    offsets[j] = static_cast<int64_t>(reinterpret_cast<uintptr_t>(keys[j].data()) -
+                                      reinterpret_cast<uintptr_t>(base));
+    sizes[j] = static_cast<uint32_t>(keys[j].size());
+  }
+
+  const __m256i m = _mm256_set1_epi32(static_cast<int>(kHashMultiplier));
+  __m256i h = _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(sizes)), m);
+  h = _mm256_xor_si256(h, _mm256_set1_epi32(static_cast<int>(seed)));
+  __m256i offsets_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets));
+  __m256i offsets_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + 4));
+  const __m256i four = _mm256_set1_epi64x(4);
+  const int *gather_base = reinterpret_cast<const int *>(base);
+  for (size_t i = 0; i < common_words; i++) {
+    const __m128i w_lo = _mm256_i64gather_epi32(gather_base, offsets_lo, 1);
+    const __m128i w_hi = _mm256_i64gather_epi32(gather_base, offsets_hi, 1);
+    h = _mm256_add_epi32(h, _mm256_set_m128i(w_hi, w_lo));
+    h = _mm256_mullo_epi32(h, m);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    offsets_lo = _mm256_add_epi64(offsets_lo, four);
+    offsets_hi = _mm256_add_epi64(offsets_hi, four);
+  }
+
+  uint32_t lanes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), h);
+  for (size_t j = 0; j < 8; j++) {
+    const char *data = keys[j].data();
+    out[j] = HashRemaining(lanes[j], data + 4 * common_words, data + keys[j].size());
+  }
+}
+
+#endif
+
+}  // namespace
+
+void
+HashBatch(const Slice *keys, size_t n, uint32_t seed, uint32_t *out) {
+  size_t i = 0;
+#if defined(LEVELDB_HASH64_X86)
+  if (CpuHasAvx2()) {
+    for (; i + 8 <= n; i += 8) {
+      size_t common_words = SIZE_MAX;
+      for (size_t j = i; j < i + 8; j++) {
+        common_words = std::min(common_words, keys[j].size() / 4);
+      }
+      if (common_words >= kMinGroupWords) {
+        HashGroupAvx2(keys + i, common_words, seed, out + i);
+      } else {
+        for (size_t j = i; j < i + 8; j++) {
+          out[j] = Hash(keys[j].data(), keys[j].size(), seed);
+        }
+      }
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    out[i] = Hash(keys[i].data(), keys[i].size(), seed);
+  }
+}
+
+void
+Hash64Batch(const Slice *keys, size_t n, uint64_t seed, uint64_t *out) {
+  const LongOps& ops = ChosenLongOps();
+  for (size_t i = 0; i < n; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (i + kPrefetchDistance < n) {
+      __builtin_prefetch(keys[i + kPrefetchDistance].data());
+    }
+#endif
+    const char *data = keys[i].data();
+    const size_t size = keys[i].size();
+    if (size <= 16) {
+      out[i] = HashShort(data, size, seed);
+    } else if (size <= kMidSizeMax) {
+      out[i] = HashMid(data, size, seed);
+    } else {
+      out[i] = HashLong(data, size, seed, ops);
+    }
+  }
+}
+
 }  // namespace leveldb.
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "leveldb/slice.h"
+
 #include <cstddef>
 #include <cstdint>
 
@@ -11,4 +13,27 @@ namespace leveldb {
 
 uint32_t Hash(const char *data, size_t n, uint32_t seed);
 
-}  // namespace leveldb.
\ No newline at end of file
+// A 64-bit hash for long keys and for filters and hash tables too large
+// for 32 bits. Inputs of up to 256 bytes are consumed 16 or 32 bytes per
+// step; longer inputs in 64 byte stripes over eight independent lanes,
+// which use SSE2 or AVX2 when the CPU has them.
+//
+// The result depends only on data[0,n-1] and seed: it is the same on
+// every platform and for every implementation, so it may be persisted.
+// Any change to it needs a new function.
+uint64_t Hash64(const char *data, size_t n, uint64_t seed = 0);
+
+// Hash64() without SIMD. Exposed for testing.
+uint64_t Hash64Portable(const char *data, size_t n, uint64_t seed = 0);
+
+// Sets out[i] = Hash(keys[i].data(), keys[i].size(), seed) for every i < n.
+// When the CPU has AVX2, groups of eight keys of 64 bytes or more are
+// hashed in parallel lanes over the words they all have, so runs of keys
+// of similar length gain the most.
+void HashBatch(const Slice *keys, size_t n, uint32_t seed, uint32_t *out);
+
+// Sets out[i] = Hash64(keys[i].data(), keys[i].size(), seed) for every
+// i < n, prefetching keys ahead of the one being hashed.
+void Hash64Batch(const Slice *keys, size_t n, uint64_t seed, uint64_t *out);
+
+}  // namespace leveldb.
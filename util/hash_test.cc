@@ -0,0 +1,254 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "hash.h"
+
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(Hash, SignedUnsignedIssue) {
+    const uint8_t data1[1] = {0x62};
+    const uint8_t data2[2] = {0xc3, 0x97};
+    const uint8_t data3[3] = {0xe2, 0x99, 0xa5};
+    const uint8_t data4[4] = {0xe1, 0x80, 0xb9, 0x32};
+    const uint8_t data5[48] = {
+        0x01, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+        0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18, 0x28, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    ASSERT_EQ(Hash(0, 0, 0xbc9f1d34), 0xbc9f1d34);
+    ASSERT_EQ(Hash(reinterpret_cast<const char *>(data1), sizeof(data1), 0xbc9f1d34), 0xef1345c4);
+    ASSERT_EQ(Hash(reinterpret_cast<const char *>(data2), sizeof(data2), 0xbc9f1d34), 0x5b663814);
+    ASSERT_EQ(Hash(reinterpret_cast<const char *>(data3), sizeof(data3), 0xbc9f1d34), 0x323c078f);
+    ASSERT_EQ(Hash(reinterpret_cast<const char *>(data4), sizeof(data4), 0xbc9f1d34), 0xed21633a);
+    ASSERT_EQ(Hash(reinterpret_cast<const char *>(data5), sizeof(data5), 0x12345678), 0xf333dabb);
+}
+
+TEST(Hash, KnownAnswers) {
+    // Every tail length, and the four byte steps.
+    const char *kKey = "0123456789abcdefghijklmnopqrstuvwxyz";
+    const uint32_t kExpected[] = {
+        0xbc9f1d34, 0x22ea8a57, 0xb0156c56, 0xe8a2cb6f, 0xfa0eae76, 0xacde7e23, 0x7f273701,
+        0x4291ccc2, 0x7db790ec, 0x28874a07, 0x04be0687, 0x2fe6932a, 0x75cd9fe3, 0x9e1e2249,
+    };
+    for (size_t n = 0; n < sizeof(kExpected) / sizeof(kExpected[0]); n++) {
+        ASSERT_EQ(kExpected[n], Hash(kKey, n, 0xbc9f1d34)) << "length " << n;
+    }
+}
+
+// Spread of "keys" over 1 << bucket_bits buckets picked by the low bits of
+// the hash: the z-score of a chi-square test, and the fullest bucket
+// relative to the mean.
+template <typename HashFunction>
+static void BucketSpread(HashFunction hash, const vector<string>& keys, int bucket_bits,
+                         double *z, double *fullest) {
+    const size_t buckets = size_t{1} << bucket_bits;
+    vector<int> counts(buckets, 0);
+    for (const string& key : keys) {
+        counts[hash(key.data(), key.size()) & (buckets - 1)]++;
+    }
+    const double expected = static_cast<double>(keys.size()) / buckets;
+    double chi_square = 0;
+    for (int c : counts) {
+        chi_square += (c - expected) * (c - expected) / expected;
+    }
+    *z = (chi_square - (buckets - 1)) / sqrt(2.0 * (buckets - 1));
+    *fullest = *max_element(counts.begin(), counts.end()) / expected;
+}
+
+TEST(Hash, BucketDistribution) {
+    // Sequential integers and their decimal strings, the keys that filters
+    // and shards see most.
+    const int kKeys = 1 << 18;
+    vector<string> fixed(kKeys);
+    vector<string> decimal(kKeys);
+    char buf[32];
+    for (int i = 0; i < kKeys; i++) {
+        fixed[i].assign(reinterpret_cast<const char *>(&i), sizeof(i));
+        snprintf(buf, sizeof(buf), "key%012d", i);
+        decimal[i] = buf;
+    }
+
+    auto hash32 = [](const char *data, size_t n) -> uint64_t { return Hash(data, n, 0xbc9f1d34); };
+    auto hash64 = [](const char *data, size_t n) -> uint64_t { return Hash64(data, n); };
+    for (const vector<string> *keys : {&fixed, &decimal}) {
+        double z;
+        double fullest;
+        // Hash() is not random-like on these keys, but no bucket overflows.
+        BucketSpread(hash32, *keys, 10, &z, &fullest);
+        ASSERT_LT(fullest, 1.3);
+
+        // Hash64() is indistinguishable from random.
+        BucketSpread(hash64, *keys, 10, &z, &fullest);
+        ASSERT_LT(fabs(z), 5);
+        ASSERT_LT(fullest, 1.3);
+    }
+}
+
+static string Pattern(size_t n) {
+    string data(n, '\0');
+    for (size_t i = 0; i < n; i++) {
+        data[i] = static_cast<char>(i * 13 + (i >> 5));
+    }
+    return data;
+}
+
+TEST(Hash64, KnownAnswers) {
+    // Hash64() output is persisted; these must never change.
+    struct {
+        size_t n;
+        uint64_t unseeded;
+        uint64_t seeded;
+    } const kCases[] = {
+        {0, 0xdf5afd008713e2edull, 0xbe0c35cb68d45bfcull},
+        {1, 0x4c8dab2148365f0full, 0x126c028f3a52cc13ull},
+        {3, 0x31b4384c78bfb014ull, 0x50094d7196760bd7ull},
+        {4, 0x915cf34480161abdull, 0x87e1dff23bc3e520ull},
+        {8, 0x7f3d4950f8811ccbull, 0x8b787443d0b4bd83ull},
+        {9, 0xb05f8c8cae8053e3ull, 0x1e7e9fd2f2f95884ull},
+        {16, 0x87713b9ca07aa652ull, 0xa88523e17d2fded4ull},
+        {17, 0x4417daab880f4229ull, 0x9f0f87cecc0c5321ull},
+        {32, 0x52ac290d9ddcee77ull, 0x7a9a4da00da6ceeeull},
+        {100, 0x4b866ec8d0417b19ull, 0x7eaf6c08408f29b3ull},
+        {256, 0x7f0274013edf01a2ull, 0x532e0dec6b0cc3f8ull},
+        {257, 0xf489de4e437e3c5full, 0x12efaa928d70892eull},
+        {1024, 0x1b54796347ec323full, 0x5dcd28fd502ed97dull},
+        {1025, 0xc8e704089c597af4ull, 0x2aedafff0efe1849ull},
+        {5000, 0x21311d2f008eb717ull, 0x6ccf941a98be4a6bull},
+    };
+    const uint64_t kSeed = 0x9ae16a3b2f90404full;
+    const string data = Pattern(5000);
+    for (const auto& c : kCases) {
+        ASSERT_EQ(c.unseeded, Hash64(data.data(), c.n)) << "length " << c.n;
+        ASSERT_EQ(c.unseeded, Hash64Portable(data.data(), c.n)) << "length " << c.n;
+        ASSERT_EQ(c.seeded, Hash64(data.data(), c.n, kSeed)) << "length " << c.n;
+        ASSERT_EQ(c.seeded, Hash64Portable(data.data(), c.n, kSeed)) << "length " << c.n;
+    }
+}
+
+TEST(Hash64, SimdMatchesPortable) {
+    // Covers whole and partial blocks and stripes at every alignment.
+    Random rnd(301);
+    string data(3 * 1024 + 200, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rnd.Uniform(256));
+    }
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t n = 250; n + offset <= data.size(); n += 7) {
+            for (uint64_t seed : {0ull, 1ull, 0xdeadbeefcafef00dull}) {
+                ASSERT_EQ(Hash64Portable(data.data() + offset, n, seed),
+                          Hash64(data.data() + offset, n, seed))
+                    << "offset " << offset << " length " << n;
+            }
+        }
+    }
+}
+
+TEST(Hash64, DistinctInputs) {
+    // Every prefix of a buffer, and every single bit flip of a long input,
+    // hashes differently.
+    const string data = Pattern(2048);
+    set<uint64_t> seen;
+    for (size_t n = 0; n <= data.size(); n++) {
+        ASSERT_TRUE(seen.insert(Hash64(data.data(), n)).second) << "length " << n;
+    }
+
+    string flipped = data;
+    for (size_t bit = 0; bit < 8 * flipped.size(); bit += 61) {
+        flipped[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+        ASSERT_TRUE(seen.insert(Hash64(flipped.data(), flipped.size())).second) << "bit " << bit;
+        flipped[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+    }
+
+    // And the seed matters at every length class.
+    for (size_t n : {0, 5, 12, 40, 300, 2048}) {
+        ASSERT_NE(Hash64(data.data(), n, 1), Hash64(data.data(), n, 2));
+    }
+}
+
+TEST(Hash64, Avalanche) {
+    // Flipping any input bit flips every output bit with probability close
+    // to 1/2. With 1000 samples a fair coin stays within 0.1 of 1/2 with
+    // overwhelming probability, and the samples are fixed anyway.
+    const int kSamples = 1000;
+    Random rnd(301);
+    for (size_t key_len : {4, 12, 40, 300}) {
+        // Long keys take every seventh bit to keep the test fast.
+        const size_t bit_step = key_len > 64 ? 7 : 1;
+        vector<int> flips(8 * key_len * 64, 0);
+        string key(key_len, '\0');
+        for (int s = 0; s < kSamples; s++) {
+            for (char& c : key) {
+                c = static_cast<char>(rnd.Uniform(256));
+            }
+            const uint64_t h = Hash64(key.data(), key_len);
+            for (size_t i = 0; i < 8 * key_len; i += bit_step) {
+                key[i / 8] ^= static_cast<char>(1 << (i % 8));
+                const uint64_t diff = h ^ Hash64(key.data(), key_len);
+                key[i / 8] ^= static_cast<char>(1 << (i % 8));
+                for (int j = 0; j < 64; j++) {
+                    flips[i * 64 + j] += (diff >> j) & 1;
+                }
+            }
+        }
+        for (size_t i = 0; i < 8 * key_len; i += bit_step) {
+            for (int j = 0; j < 64; j++) {
+                ASSERT_NEAR(0.5, static_cast<double>(flips[i * 64 + j]) / kSamples, 0.1)
+                    << "length " << key_len << " input bit " << i << " output bit " << j;
+            }
+        }
+    }
+}
+
+TEST(HashBatch, MatchesSingleKeyHashes) {
+    Random rnd(301);
+    string data(4096, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rnd.Uniform(256));
+    }
+
+    // Batch sizes around the lane count, with equal, nearly equal and
+    // unrelated key lengths, including empty keys.
+    for (size_t n = 0; n < 40; n++) {
+        for (int mode = 0; mode < 3; mode++) {
+            vector<Slice> keys;
+            const size_t common_length = 60 + rnd.Uniform(100);
+            for (size_t i = 0; i < n; i++) {
+                size_t length;
+                if (mode == 0) {
+                    length = common_length;
+                } else if (mode == 1) {
+                    length = common_length + rnd.Uniform(8);
+                } else {
+                    length = rnd.Uniform(300);
+                }
+                keys.emplace_back(data.data() + rnd.Uniform(data.size() - length), length);
+            }
+
+            vector<uint32_t> hashes(n);
+            vector<uint64_t> hashes64(n);
+            HashBatch(keys.data(), n, 0xbc9f1d34, hashes.data());
+            Hash64Batch(keys.data(), n, 0xbc9f1d34, hashes64.data());
+            for (size_t i = 0; i < n; i++) {
+                ASSERT_EQ(Hash(keys[i].data(), keys[i].size(), 0xbc9f1d34), hashes[i])
+                    << "key " << i << " of " << n;
+                ASSERT_EQ(Hash64(keys[i].data(), keys[i].size(), 0xbc9f1d34), hashes64[i])
+                    << "key " << i << " of " << n;
+            }
+        }
+    }
+}
+
+} // namespace leveldb.
@@ -0,0 +1,208 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+namespace leveldb {
+
+uint64_t
+Histogram::BucketLowerBound(int b)
+{
+    if (b < 16) {
+        return static_cast<uint64_t>(b);
+    }
+    const int log2 = (b - 16) / 8 + 4;
+    const uint64_t sub = (b - 16) % 8;
+    return (8 + sub) << (log2 - 3);
+}
+
+void
+Histogram::Clear()
+{
+    _min = UINT64_MAX;
+    _max = 0;
+    _num = 0;
+    _sum = 0;
+    memset(_buckets, 0, sizeof(_buckets));
+}
+
+void
+Histogram::Add(uint64_t value)
+{
+    _buckets[BucketIndex(value)]++;
+    if (_min > value) {
+        _min = value;
+    }
+    if (_max < value) {
+        _max = value;
+    }
+    _num++;
+    _sum += value;
+}
+
+void
+Histogram::Merge(const Histogram& other)
+{
+    if (other._min < _min) {
+        _min = other._min;
+    }
+    if (other._max > _max) {
+        _max = other._max;
+    }
+    _num += other._num;
+    _sum += other._sum;
+    for (int b = 0; b < kNumBuckets; b++) {
+        _buckets[b] += other._buckets[b];
+    }
+}
+
+double
+Histogram::Median() const
+{
+    return Percentile(50.0);
+}
+
+/*
+ * Finds the bucket holding the requested rank and interpolates linearly
+ * inside it, clamped to the observed min and max.
+ */
+double
+Histogram::Percentile(double p) const
+{
+    if (_num == 0) {
+        return 0.0;
+    }
+
+    const double threshold = _num * (p / 100.0);
+    double sum = 0;
+    for (int b = 0; b < kNumBuckets; b++) {
+        sum += _buckets[b];
+        if (sum >= threshold) {
+            const double left_point = BucketLowerBound(b);
+            const double right_point = (b + 1 < kNumBuckets) ? BucketLowerBound(b + 1)
+                                                              : static_cast<double>(_max);
+            const double left_sum = sum - _buckets[b];
+            const double pos = (threshold - left_sum) / _buckets[b];
+            double r = left_point + (right_point - left_point) * pos;
+            if (r < _min) {
+                r = _min;
+            }
+            if (r > _max) {
+                r = _max;
+            }
+            return r;
+        }
+    }
+    return _max;
+}
+
+double
+Histogram::Average() const
+{
+    if (_num == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(_sum) / _num;
+}
+
+string
+Histogram::ToString() const
+{
+    string r;
+    char buf[200];
+    snprintf(buf, sizeof(buf), "Count: %llu  Average: %.4f\n",
+             static_cast<unsigned long long>(_num), Average());
+    r.append(buf);
+    snprintf(buf, sizeof(buf), "Min: %llu  P50: %.2f  P99: %.2f  P99.9: %.2f  Max: %llu\n",
+             static_cast<unsigned long long>(Min()), Percentile(50.0), Percentile(99.0),
+             Percentile(99.9), static_cast<unsigned long long>(_max));
+    r.append(buf);
+    r.append("------------------------------------------------------\n");
+
+    const double mult = (_num == 0) ? 0.0 : 100.0 / _num;
+    double sum = 0;
+    for (int b = 0; b < kNumBuckets; b++) {
+        if (_buckets[b] == 0) {
+            continue;
+        }
+        sum += _buckets[b];
+        snprintf(buf, sizeof(buf), "[ %7llu, %7llu ) %7llu %7.3f%% %7.3f%% ",
+                 static_cast<unsigned long long>(BucketLowerBound(b)),
+                 static_cast<unsigned long long>(b + 1 < kNumBuckets ? BucketLowerBound(b + 1) : UINT64_MAX),
+                 static_cast<unsigned long long>(_buckets[b]),
+                 mult * _buckets[b], mult * sum);
+        r.append(buf);
+
+        // Add hash marks based on percentage; 20 marks for 100%.
+        int marks = static_cast<int>(20 * (_buckets[b] / static_cast<double>(_num)) + 0.5);
+        r.append(marks, '#');
+        r.push_back('\n');
+    }
+    return r;
+}
+
+// Threads are assigned shards round-robin the first time they add a sample.
+static atomic<uint32_t> next_shard(0);
+
+ConcurrentHistogram::ConcurrentHistogram()
+{
+    Clear();
+}
+
+void
+ConcurrentHistogram::Add(uint64_t value)
+{
+    static thread_local const uint32_t thread_shard = next_shard.fetch_add(1, memory_order_relaxed);
+    Shard *shard = &_shards[thread_shard % kNumShards];
+
+    shard->buckets[Histogram::BucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    shard->sum.fetch_add(value, memory_order_relaxed);
+
+    uint64_t cur = shard->min.load(memory_order_relaxed);
+    while (value < cur && !shard->min.compare_exchange_weak(cur, value, memory_order_relaxed)) {
+    }
+    cur = shard->max.load(memory_order_relaxed);
+    while (value > cur && !shard->max.compare_exchange_weak(cur, value, memory_order_relaxed)) {
+    }
+}
+
+void
+ConcurrentHistogram::Clear()
+{
+    for (Shard& shard : _shards) {
+        shard.min.store(UINT64_MAX, memory_order_relaxed);
+        shard.max.store(0, memory_order_relaxed);
+        shard.sum.store(0, memory_order_relaxed);
+        for (atomic<uint64_t>& bucket : shard.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+void
+ConcurrentHistogram::Snapshot(Histogram *result) const
+{
+    result->Clear();
+    for (const Shard& shard : _shards) {
+        result->_min = min(result->_min, shard.min.load(memory_order_relaxed));
+        result->_max = max(result->_max, shard.max.load(memory_order_relaxed));
+        result->_sum += shard.sum.load(memory_order_relaxed);
+        for (int b = 0; b < Histogram::kNumBuckets; b++) {
+            result->_buckets[b] += shard.buckets[b].load(memory_order_relaxed);
+        }
+    }
+
+    // Derive the count from the buckets so percentiles stay consistent
+    // with a snapshot taken while samples are being added.
+    for (int b = 0; b < Histogram::kNumBuckets; b++) {
+        result->_num += result->_buckets[b];
+    }
+}
+
+} // namespace leveldb.
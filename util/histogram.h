@@ -0,0 +1,117 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Log-linear bucketed histogram of non-negative integer samples.
+ *
+ * Values below 16 get a bucket each. Above that every power of two is
+ * split into 8 equal buckets, so a percentile is off by at most 1/8 of
+ * its magnitude.
+ *
+ * Not thread-safe; see ConcurrentHistogram.
+ */
+class Histogram {
+public:
+    Histogram() {
+        Clear();
+    }
+
+    void Clear();
+    void Add(uint64_t value);
+    void Merge(const Histogram& other);
+
+    uint64_t Count() const {
+        return _num;
+    }
+
+    uint64_t Min() const {
+        return _num == 0 ? 0 : _min;
+    }
+
+    uint64_t Max() const {
+        return _max;
+    }
+
+    double Average() const;
+    double Median() const;
+
+    // Returns the value below which "p" percent of the samples fall.
+    double Percentile(double p) const;
+
+    string ToString() const;
+
+    // Bucket layout, shared with ConcurrentHistogram.
+    static const int kNumBuckets = 16 + 60 * 8;
+
+    static int BucketIndex(uint64_t value) {
+        if (value < 16) {
+            return static_cast<int>(value);
+        }
+        const int log2 = 63 - __builtin_clzll(value);
+        return 16 + (log2 - 4) * 8 + static_cast<int>((value >> (log2 - 3)) & 7);
+    }
+
+    // Smallest value that falls into bucket "b".
+    static uint64_t BucketLowerBound(int b);
+
+private:
+    friend class ConcurrentHistogram;
+
+    uint64_t _min;
+    uint64_t _max;
+    uint64_t _num;
+    uint64_t _sum;
+
+    uint64_t _buckets[kNumBuckets];
+};
+
+/*
+ * A histogram that many threads may Add() to concurrently without locks.
+ *
+ * Samples go to one of kNumShards shards picked by the calling thread, so
+ * threads rarely touch the same cache lines. Snapshot() merges the shards
+ * into a Histogram; it may run concurrently with Add() and then sees any
+ * subset of the samples that are being added.
+ */
+class ConcurrentHistogram {
+public:
+    ConcurrentHistogram();
+
+    ConcurrentHistogram(const ConcurrentHistogram&) = delete;
+    ConcurrentHistogram& operator=(const ConcurrentHistogram&) = delete;
+
+    void Add(uint64_t value);
+
+    // Discards all samples. Samples added concurrently may or may not survive.
+    void Clear();
+
+    // Stores the merge of all shards in *result.
+    void Snapshot(Histogram *result) const;
+
+private:
+    static const int kNumShards = 8;
+
+    struct Shard {
+        atomic<uint64_t> min;
+        atomic<uint64_t> max;
+        atomic<uint64_t> sum;
+        atomic<uint64_t> buckets[Histogram::kNumBuckets];
+
+        // Keeps neighbouring shards' counters off this shard's cache lines.
+        char padding[64];
+    };
+
+    Shard _shards[kNumShards];
+};
+
+} // namespace leveldb.
@@ -0,0 +1,278 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "instrumented_env.h"
+
+#include <cstdio>
+using namespace std;
+
+namespace leveldb {
+
+const char *
+EnvStatistics::OperationName(Operation op)
+{
+    switch (op) {
+    case kOpen:
+        return "open";
+    case kSequentialRead:
+        return "sequential_read";
+    case kSkip:
+        return "skip";
+    case kRandomRead:
+        return "random_read";
+    case kAppend:
+        return "append";
+    case kFlush:
+        return "flush";
+    case kSync:
+        return "sync";
+    case kClose:
+        return "close";
+    case kScheduleWait:
+        return "schedule_wait";
+    case kScheduleRun:
+        return "schedule_run";
+    default:
+        return "unknown";
+    }
+}
+
+void
+EnvStatistics::Reset()
+{
+    for (ConcurrentHistogram& histogram : _histograms) {
+        histogram.Clear();
+    }
+}
+
+string
+EnvStatistics::ToString() const
+{
+    string r;
+    char buf[200];
+    snprintf(buf, sizeof(buf), "%-16s %10s %10s %10s %10s %10s\n",
+             "operation (us)", "count", "p50", "p99", "p99.9", "max");
+    r.append(buf);
+
+    Histogram histogram;
+    for (int op = 0; op < kNumOperations; op++) {
+        GetHistogram(static_cast<Operation>(op), &histogram);
+        if (histogram.Count() == 0) {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "%-16s %10llu %10.1f %10.1f %10.1f %10llu\n",
+                 OperationName(static_cast<Operation>(op)),
+                 static_cast<unsigned long long>(histogram.Count()),
+                 histogram.Percentile(50.0), histogram.Percentile(99.0),
+                 histogram.Percentile(99.9),
+                 static_cast<unsigned long long>(histogram.Max()));
+        r.append(buf);
+    }
+    return r;
+}
+
+namespace {
+
+// Records the time from construction to destruction as one sample of "op",
+// unless "timed" is false.
+class OperationTimer {
+public:
+    OperationTimer(Env *env, EnvStatistics *stats, EnvStatistics::Operation op, bool timed = true)
+        : _env(env), _stats(stats), _op(op), _timed(timed),
+          _start_micros(timed ? env->NowMicros() : 0) {}
+
+    ~OperationTimer() {
+        if (_timed) {
+            _stats->Record(_op, _env->NowMicros() - _start_micros);
+        }
+    }
+
+private:
+    Env *const _env;
+    EnvStatistics *const _stats;
+    const EnvStatistics::Operation _op;
+    const bool _timed;
+    const uint64_t _start_micros;
+};
+
+class InstrumentedSequentialFile : public SequentialFile {
+public:
+    InstrumentedSequentialFile(SequentialFile *target, Env *env, EnvStatistics *stats)
+        : _target(target), _env(env), _stats(stats) {}
+
+    ~InstrumentedSequentialFile() override {
+        delete _target;
+    }
+
+    Status Read(size_t n, Slice *result, char *scratch) override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kSequentialRead, _stats->Sample());
+        return _target->Read(n, result, scratch);
+    }
+
+    Status Skip(uint64_t n) override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kSkip, _stats->Sample());
+        return _target->Skip(n);
+    }
+
+    Status Hint(AccessPattern pattern) override {
+        return _target->Hint(pattern);
+    }
+
+private:
+    SequentialFile *const _target;
+    Env *const _env;
+    EnvStatistics *const _stats;
+};
+
+class InstrumentedRandomAccessFile : public RandomAccessFile {
+public:
+    InstrumentedRandomAccessFile(RandomAccessFile *target, Env *env, EnvStatistics *stats)
+        : _target(target), _env(env), _stats(stats) {}
+
+    ~InstrumentedRandomAccessFile() override {
+        delete _target;
+    }
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kRandomRead, _stats->Sample());
+        return _target->Read(offset, n, result, scratch);
+    }
+
+    Status Hint(AccessPattern pattern) override {
+        return _target->Hint(pattern);
+    }
+
+private:
+    RandomAccessFile *const _target;
+    Env *const _env;
+    EnvStatistics *const _stats;
+};
+
+class InstrumentedWritableFile : public WritableFile {
+public:
+    InstrumentedWritableFile(WritableFile *target, Env *env, EnvStatistics *stats)
+        : _target(target), _env(env), _stats(stats) {}
+
+    ~InstrumentedWritableFile() override {
+        delete _target;
+    }
+
+    Status Append(const Slice& data) override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kAppend, _stats->Sample());
+        return _target->Append(data);
+    }
+
+    Status Close() override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kClose);
+        return _target->Close();
+    }
+
+    Status Flush() override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kFlush);
+        return _target->Flush();
+    }
+
+    Status Sync() override {
+        OperationTimer timer(_env, _stats, EnvStatistics::kSync);
+        return _target->Sync();
+    }
+
+private:
+    WritableFile *const _target;
+    Env *const _env;
+    EnvStatistics *const _stats;
+};
+
+class InstrumentedEnv : public EnvWrapper {
+public:
+    InstrumentedEnv(Env *base_env, EnvStatistics *stats)
+        : EnvWrapper(base_env), _stats(stats) {}
+
+    Status NewSequentialFile(const string& fname, SequentialFile **result) override {
+        SequentialFile *file;
+        Status s;
+        {
+            OperationTimer timer(target(), _stats, EnvStatistics::kOpen);
+            s = target()->NewSequentialFile(fname, &file);
+        }
+        *result = s.ok() ? new InstrumentedSequentialFile(file, target(), _stats) : nullptr;
+        return s;
+    }
+
+    Status NewRandomAccessFile(const string& fname, RandomAccessFile **result) override {
+        RandomAccessFile *file;
+        Status s;
+        {
+            OperationTimer timer(target(), _stats, EnvStatistics::kOpen);
+            s = target()->NewRandomAccessFile(fname, &file);
+        }
+        *result = s.ok() ? new InstrumentedRandomAccessFile(file, target(), _stats) : nullptr;
+        return s;
+    }
+
+    Status NewWritableFile(const string& fname, WritableFile **result) override {
+        WritableFile *file;
+        Status s;
+        {
+            OperationTimer timer(target(), _stats, EnvStatistics::kOpen);
+            s = target()->NewWritableFile(fname, &file);
+        }
+        *result = s.ok() ? new InstrumentedWritableFile(file, target(), _stats) : nullptr;
+        return s;
+    }
+
+    Status NewAppendableFile(const string& fname, WritableFile **result) override {
+        WritableFile *file;
+        Status s;
+        {
+            OperationTimer timer(target(), _stats, EnvStatistics::kOpen);
+            s = target()->NewAppendableFile(fname, &file);
+        }
+        *result = s.ok() ? new InstrumentedWritableFile(file, target(), _stats) : nullptr;
+        return s;
+    }
+
+    void Schedule(function<void(void *)> func, void *arg) override {
+        target()->Schedule(Timed(func, 0), arg);
+    }
+
+    ScheduleHandle ScheduleWithHandle(function<void(void *)> func, void *arg) override {
+        return target()->ScheduleWithHandle(Timed(func, 0), arg);
+    }
+
+    ScheduleHandle ScheduleAfter(function<void(void *)> func, void *arg, uint64_t micros) override {
+        return target()->ScheduleAfter(Timed(func, micros), arg, micros);
+    }
+
+private:
+    /*
+     * Returns "func" wrapped to record its queue wait and run time. The wait
+     * is counted from the moment the work item becomes due, "delay_micros"
+     * from now.
+     */
+    function<void(void *)> Timed(function<void(void *)> func, uint64_t delay_micros) {
+        Env *env = target();
+        EnvStatistics *stats = _stats;
+        const uint64_t due_micros = env->NowMicros() + delay_micros;
+        return [func, env, stats, due_micros](void *a) {
+            const uint64_t start_micros = env->NowMicros();
+            stats->Record(EnvStatistics::kScheduleWait,
+                          start_micros > due_micros ? start_micros - due_micros : 0);
+            func(a);
+            stats->Record(EnvStatistics::kScheduleRun, env->NowMicros() - start_micros);
+        };
+    }
+
+    EnvStatistics *const _stats;
+};
+
+} // namespace
+
+Env *
+NewInstrumentedEnv(Env *base_env, EnvStatistics *stats)
+{
+    return new InstrumentedEnv(base_env, stats);
+}
+
+} // namespace leveldb.
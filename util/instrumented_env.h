@@ -0,0 +1,92 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/env.h"
+#include "util/histogram.h"
+
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * Latency histograms, in microseconds, for every operation an
+ * instrumented Env performs.
+ *
+ * Recording is lock-free (see ConcurrentHistogram) and costs two clock
+ * reads per operation, which is more than a buffered append or a read
+ * from the page cache costs. Reads, skips and appends can therefore be
+ * sampled: with "sample_one_in" N, each thread times one of every N of
+ * them and their histograms count only those. Other operations are
+ * always timed. Thread-safe.
+ */
+class EnvStatistics {
+public:
+    enum Operation {
+        kOpen = 0,          // NewSequentialFile, NewRandomAccessFile, ...
+        kSequentialRead,
+        kSkip,
+        kRandomRead,
+        kAppend,
+        kFlush,
+        kSync,
+        kClose,
+        kScheduleWait,      // Time between Schedule() and the start of the work.
+        kScheduleRun,       // Time spent running the scheduled work.
+        kNumOperations
+    };
+
+    // REQUIRES: sample_one_in > 0
+    explicit EnvStatistics(uint32_t sample_one_in = 1) : _sample_one_in(sample_one_in) {}
+
+    EnvStatistics(const EnvStatistics&) = delete;
+    EnvStatistics& operator=(const EnvStatistics&) = delete;
+
+    static const char *OperationName(Operation op);
+
+    // Whether the calling thread should time its next sampled operation.
+    bool Sample() const {
+        if (_sample_one_in == 1) {
+            return true;
+        }
+        static thread_local uint32_t calls = 0;
+        if (++calls < _sample_one_in) {
+            return false;
+        }
+        calls = 0;
+        return true;
+    }
+
+    void Record(Operation op, uint64_t micros) {
+        _histograms[op].Add(micros);
+    }
+
+    // Stores the merged histogram of "op" in *result.
+    void GetHistogram(Operation op, Histogram *result) const {
+        _histograms[op].Snapshot(result);
+    }
+
+    void Reset();
+
+    // One line per operation with its count, p50, p99, p99.9 and max.
+    string ToString() const;
+
+private:
+    const uint32_t _sample_one_in;
+    ConcurrentHistogram _histograms[kNumOperations];
+};
+
+/*
+ * Returns an Env that forwards to "base_env" and records the latency of
+ * every file operation and every scheduled work item in "stats".
+ *
+ * The caller must delete the result when it is no longer needed.
+ * "base_env" and "stats" must remain live while the result is in use.
+ */
+Env *NewInstrumentedEnv(Env *base_env, EnvStatistics *stats);
+
+} // namespace leveldb.
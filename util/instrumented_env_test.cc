@@ -0,0 +1,190 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "instrumented_env.h"
+
+#include "helpers/memenv/memenv.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(HistogramTest, Buckets) {
+    // Every value lands in the bucket whose bounds contain it.
+    for (uint64_t v = 0; v < 100000; v++) {
+        int b = Histogram::BucketIndex(v);
+        ASSERT_LE(Histogram::BucketLowerBound(b), v);
+        ASSERT_GT(Histogram::BucketLowerBound(b + 1), v);
+    }
+    ASSERT_EQ(Histogram::kNumBuckets - 1, Histogram::BucketIndex(UINT64_MAX));
+}
+
+TEST(HistogramTest, Percentiles) {
+    Histogram h;
+    ASSERT_EQ(0.0, h.Median());
+
+    for (uint64_t v = 1; v <= 1000; v++) {
+        h.Add(v);
+    }
+    ASSERT_EQ(1000, h.Count());
+    ASSERT_EQ(1, h.Min());
+    ASSERT_EQ(1000, h.Max());
+    ASSERT_DOUBLE_EQ(500.5, h.Average());
+
+    // Buckets are within 1/8 of the value.
+    ASSERT_NEAR(500, h.Percentile(50), 500 / 8);
+    ASSERT_NEAR(990, h.Percentile(99), 990 / 8);
+    ASSERT_LE(h.Percentile(99.9), 1000);
+
+    Histogram other;
+    other.Add(5000);
+    h.Merge(other);
+    ASSERT_EQ(1001, h.Count());
+    ASSERT_EQ(5000, h.Max());
+}
+
+TEST(HistogramTest, Concurrent) {
+    ConcurrentHistogram h;
+    const int kThreads = 4;
+    const int kSamples = 100000;
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < kSamples; i++) {
+                h.Add(t * 10 + i % 10);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    Histogram snapshot;
+    h.Snapshot(&snapshot);
+    ASSERT_EQ(kThreads * kSamples, snapshot.Count());
+    ASSERT_EQ(0, snapshot.Min());
+    ASSERT_EQ((kThreads - 1) * 10 + 9, snapshot.Max());
+
+    h.Clear();
+    h.Snapshot(&snapshot);
+    ASSERT_EQ(0, snapshot.Count());
+}
+
+TEST(InstrumentedEnvTest, FileOperations) {
+    Env *mem_env = NewMemEnv(Env::Default());
+    EnvStatistics stats;
+    Env *env = NewInstrumentedEnv(mem_env, &stats);
+
+    WritableFile *writable_file;
+    ASSERT_TRUE(env->NewWritableFile("/f", &writable_file).ok());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(writable_file->Append("0123456789").ok());
+    }
+    ASSERT_TRUE(writable_file->Sync().ok());
+    ASSERT_TRUE(writable_file->Close().ok());
+    delete writable_file;
+
+    RandomAccessFile *rand_file;
+    char scratch[10];
+    Slice result;
+    ASSERT_TRUE(env->NewRandomAccessFile("/f", &rand_file).ok());
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(rand_file->Read(i * 10, 10, &result, scratch).ok());
+    }
+    delete rand_file;
+
+    SequentialFile *seq_file;
+    ASSERT_TRUE(env->NewSequentialFile("/f", &seq_file).ok());
+    ASSERT_TRUE(seq_file->Skip(10).ok());
+    ASSERT_TRUE(seq_file->Read(10, &result, scratch).ok());
+    delete seq_file;
+
+    Histogram h;
+    stats.GetHistogram(EnvStatistics::kOpen, &h);
+    ASSERT_EQ(3, h.Count());
+    stats.GetHistogram(EnvStatistics::kAppend, &h);
+    ASSERT_EQ(10, h.Count());
+    stats.GetHistogram(EnvStatistics::kSync, &h);
+    ASSERT_EQ(1, h.Count());
+    stats.GetHistogram(EnvStatistics::kClose, &h);
+    ASSERT_EQ(1, h.Count());
+    stats.GetHistogram(EnvStatistics::kRandomRead, &h);
+    ASSERT_EQ(5, h.Count());
+    stats.GetHistogram(EnvStatistics::kSequentialRead, &h);
+    ASSERT_EQ(1, h.Count());
+    stats.GetHistogram(EnvStatistics::kSkip, &h);
+    ASSERT_EQ(1, h.Count());
+    stats.GetHistogram(EnvStatistics::kFlush, &h);
+    ASSERT_EQ(0, h.Count());
+
+    ASSERT_NE(string::npos, stats.ToString().find("append"));
+    ASSERT_EQ(string::npos, stats.ToString().find("flush"));
+
+    stats.Reset();
+    stats.GetHistogram(EnvStatistics::kAppend, &h);
+    ASSERT_EQ(0, h.Count());
+
+    delete env;
+    delete mem_env;
+}
+
+TEST(InstrumentedEnvTest, SampledOperations) {
+    Env *mem_env = NewMemEnv(Env::Default());
+    EnvStatistics stats(4);
+    Env *env = NewInstrumentedEnv(mem_env, &stats);
+
+    WritableFile *writable_file;
+    ASSERT_TRUE(env->NewWritableFile("/f", &writable_file).ok());
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(writable_file->Append("0123456789").ok());
+    }
+    ASSERT_TRUE(writable_file->Sync().ok());
+    delete writable_file;
+
+    // One append in four is timed; syncs always are.
+    Histogram h;
+    stats.GetHistogram(EnvStatistics::kAppend, &h);
+    ASSERT_EQ(25, h.Count());
+    stats.GetHistogram(EnvStatistics::kSync, &h);
+    ASSERT_EQ(1, h.Count());
+
+    delete env;
+    delete mem_env;
+}
+
+TEST(InstrumentedEnvTest, Schedule) {
+    EnvStatistics stats;
+    Env *env = NewInstrumentedEnv(Env::Default(), &stats);
+
+    atomic<int> done(0);
+    for (int i = 0; i < 3; i++) {
+        env->Schedule([](void *arg) {
+            Env::Default()->SleepForMicroseconds(2000);
+            reinterpret_cast<atomic<int> *>(arg)->fetch_add(1);
+        }, &done);
+    }
+    while (done < 3) {
+        env->SleepForMicroseconds(1000);
+    }
+    // The last sample is recorded right after the work function returns.
+    env->SleepForMicroseconds(10000);
+
+    Histogram h;
+    stats.GetHistogram(EnvStatistics::kScheduleRun, &h);
+    ASSERT_EQ(3, h.Count());
+    ASSERT_GE(h.Min(), 2000);
+
+    // Items queue behind each other on the single background thread.
+    stats.GetHistogram(EnvStatistics::kScheduleWait, &h);
+    ASSERT_EQ(3, h.Count());
+    ASSERT_GE(h.Max(), 2000);
+
+    delete env;
+}
+
+} // namespace leveldb.
@@ -0,0 +1,41 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "port/port.h"
+#include "port/thread_annotations.h"
+
+namespace leveldb {
+
+/*
+ * Helper class that locks a mutex on construction and unlocks the mutex when
+ * the destructor of the MutexLock object is invoked.
+ *
+ * Typical usage:
+ *
+ *   void MyClass::MyMethod() {
+ *     MutexLock l(&_mu);       // _mu is an instance variable
+ *     ... some complex code, possibly with multiple return paths ...
+ *   }
+ */
+class SCOPED_LOCKABLE MutexLock {
+public:
+    // "site" identifies the caller when mutex profiling is enabled.
+    explicit MutexLock(port::Mutex *mu, port::CallSite site = port::CallSite())
+        EXCLUSIVE_LOCK_FUNCTION(mu) : _mu(mu) {
+        _mu->Lock(site);
+    }
+    ~MutexLock() UNLOCK_FUNCTION() {
+        _mu->Unlock();
+    }
+
+    MutexLock(const MutexLock&) = delete;
+    MutexLock& operator=(const MutexLock&) = delete;
+
+private:
+    port::Mutex *const _mu;
+};
+
+} // namespace leveldb.
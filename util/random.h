@@ -4,64 +4,211 @@
 
 #pragma once
 
+#include <cassert>
+#include <cmath>
 #include <cstdint>
 
 namespace leveldb {
 
-
-// A simple random number generator.
+/*
+ * A fast random number generator (xoshiro256**, 64 bits per step) for
+ * tests, benchmarks and randomized data structures. Not for anything
+ * that needs unpredictable numbers.
+ *
+ * The sequence depends only on the seed, on every platform.
+ */
 class Random {
 public:
-    explicit Random(uint32_t seed) : _seed(seed & 0x7fffffffu) {
-        // Avoid bad seeds.
-        if (_seed == 0 || _seed == 0x7fffffffu) {
-        _seed = 1;
+    explicit Random(uint32_t seed) {
+        // Spread the seed over the state with SplitMix64, which never
+        // yields the all-zero state xoshiro can not leave.
+        uint64_t x = seed;
+        for (uint64_t& s : _s) {
+            x += 0x9e3779b97f4a7c15ull;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            s = z ^ (z >> 31);
         }
     }
 
-    // Returns a uniformly distributed value in the range [0..n-1]
+    // Returns 64 uniformly distributed bits.
+    uint64_t Next64() {
+        const uint64_t result = Rotl(_s[1] * 5, 7) * 9;
+        const uint64_t t = _s[1] << 17;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = Rotl(_s[3], 45);
+        return result;
+    }
+
+    // Returns 32 uniformly distributed bits.
+    uint32_t Next() {
+        return static_cast<uint32_t>(Next64() >> 32);
+    }
+
+    /*
+     * Returns a uniformly distributed value in the range [0..n-1].
+     * REQUIRES: n > 0
+     *
+     * Scales a 32-bit draw by n instead of taking a remainder, and
+     * redraws the few values that would favour some results (Lemire,
+     * "Fast Random Integer Generation in an Interval").
+     */
     uint32_t Uniform(int n) {
-        return Next() % n;
+        assert(n > 0);
+        const uint32_t range = static_cast<uint32_t>(n);
+        uint64_t m = uint64_t{Next()} * range;
+        if (static_cast<uint32_t>(m) < range) {
+            const uint32_t threshold = -range % range;
+            while (static_cast<uint32_t>(m) < threshold) {
+                m = uint64_t{Next()} * range;
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    // Uniform() over 64-bit ranges.
+    // REQUIRES: n > 0
+    uint64_t Uniform64(uint64_t n) {
+        assert(n > 0);
+        __uint128_t m = static_cast<__uint128_t>(Next64()) * n;
+        if (static_cast<uint64_t>(m) < n) {
+            const uint64_t threshold = -n % n;
+            while (static_cast<uint64_t>(m) < threshold) {
+                m = static_cast<__uint128_t>(Next64()) * n;
+            }
+        }
+        return static_cast<uint64_t>(m >> 64);
     }
 
     // Randomly returns true ~"1/n" of the time, and false otherwise.
+    // REQUIRES: n > 0
     bool OneIn(int n) {
-        return Next() % n == 0;
+        return Uniform(n) == 0;
+    }
+
+    /*
+     * Skewed: pick "base" uniformly from range [0,max_log] and then
+     * return "base" random bits. The effect is to pick a number in the
+     * range [0,2^max_log-1] with exponential bias towards smaller numbers.
+     * REQUIRES: 0 <= max_log <= 30
+     */
+    uint32_t Skewed(int max_log) {
+        return Uniform(1 << Uniform(max_log + 1));
+    }
+
+    // Returns a uniformly distributed double in [0, 1), with 53 random bits.
+    double NextDouble() {
+        return static_cast<double>(Next64() >> 11) * (1.0 / (uint64_t{1} << 53));
+    }
+
+    // Returns a draw from the exponential distribution with the given mean,
+    // such as the time between events that arrive independently.
+    // REQUIRES: mean > 0
+    double Exponential(double mean) {
+        // 1 - NextDouble() is in (0, 1], so the logarithm is finite.
+        return -mean * std::log(1.0 - NextDouble());
     }
 
 private:
-    uint32_t Next() {
-        // 2^31-1.
-        static const uint32_t M = 2147483647L;
-
-        // bits 14, 8, 7, 5, 2, 1, 0
-        static const uint64_t A = 16807;
-
-        /*
-         * We are computing:
-         *      _seed = (_seed * A) % M,    where M = 2^31-1
-         *
-         * _seed must not be zero or M, or else all subsequent computed values
-         * will be zero or M respectively. For all other values, seed_ will end
-         * up cycling through every number in [1, M-1].
-         */
-         uint64_t product = _seed * A;
-
-        // Compute (product % M) using the fact that ((x << 31) % M) == x.
-        _seed = static_cast<uint32_t>((product >> 31) + (product & M));
-
-        /*
-         * The first reduction may overflow by 1 bit, so we may need to
-         * repeat.  mod == M is not possible; using > allows the faster
-         * sign-bit-based test.
-         */
-        if (_seed > M) {
-            _seed -= M;
+    static uint64_t Rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t _s[4];
+};
+
+/*
+ * Draws values in [0, n) with Zipfian probabilities: value k comes up in
+ * proportion to 1 / (k + 1)^theta, so 0 is the most popular. theta = 0 is
+ * uniform, and the larger theta, the more skewed; 0.99 is the YCSB default.
+ *
+ * Uses rejection-inversion sampling (Hörmann and Derflinger, "Rejection-
+ * inversion to generate variates from monotone discrete distributions"),
+ * so construction is O(1) and a draw takes about one Random::NextDouble()
+ * whatever "n" is.
+ */
+class ZipfianGenerator {
+public:
+    // REQUIRES: n > 0, theta >= 0
+    ZipfianGenerator(uint64_t n, double theta)
+        : _n(n),
+          _theta(theta),
+          _h_integral_x1(HIntegral(1.5) - 1.0),
+          _h_integral_n(HIntegral(static_cast<double>(n) + 0.5)),
+          _s(2.0 - HIntegralInverse(HIntegral(2.5) - H(2.0))) {
+        assert(n > 0);
+        assert(theta >= 0);
+    }
+
+    uint64_t n() const {
+        return _n;
+    }
+
+    double theta() const {
+        return _theta;
+    }
+
+    uint64_t Next(Random *rnd) const {
+        while (true) {
+            const double u = _h_integral_n + rnd->NextDouble() * (_h_integral_x1 - _h_integral_n);
+            const double x = HIntegralInverse(u);
+            double k = std::floor(x + 0.5);
+            if (k < 1) {
+                k = 1;
+            } else if (k > static_cast<double>(_n)) {
+                k = static_cast<double>(_n);
+            }
+            if (k - x <= _s || u >= HIntegral(k + 0.5) - H(k)) {
+                return static_cast<uint64_t>(k) - 1;
+            }
+        }
+    }
+
+private:
+    // The unnormalized probability of rank x, and an antiderivative of it.
+    double H(double x) const {
+        return std::exp(-_theta * std::log(x));
+    }
+
+    double HIntegral(double x) const {
+        const double log_x = std::log(x);
+        return Expm1OverX((1.0 - _theta) * log_x) * log_x;
+    }
+
+    double HIntegralInverse(double x) const {
+        double t = x * (1.0 - _theta);
+        if (t < -1.0) {
+            // Only rounding gets here.
+            t = -1.0;
+        }
+        return std::exp(Log1pOverX(t) * x);
+    }
+
+    // log(1 + x) / x and (exp(x) - 1) / x, accurate near x = 0.
+    static double Log1pOverX(double x) {
+        if (std::fabs(x) > 1e-8) {
+            return std::log1p(x) / x;
+        }
+        return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    static double Expm1OverX(double x) {
+        if (std::fabs(x) > 1e-8) {
+            return std::expm1(x) / x;
         }
-        return _seed;
+        return 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
     }
 
-    uint32_t    _seed;
+    const uint64_t _n;
+    const double _theta;
+    const double _h_integral_x1;
+    const double _h_integral_n;
+    const double _s;
 };
 
-} // namespace leveldb.
\ No newline at end of file
+} // namespace leveldb.
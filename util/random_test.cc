@@ -0,0 +1,154 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "random.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+// The z-score of a chi-square test of "counts" against "expected" counts;
+// |z| below 5 passes for any decent generator.
+static double ChiSquareZ(const vector<int>& counts, const vector<double>& expected) {
+    double chi_square = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        chi_square += (counts[i] - expected[i]) * (counts[i] - expected[i]) / expected[i];
+    }
+    const double dof = counts.size() - 1;
+    return (chi_square - dof) / sqrt(2 * dof);
+}
+
+TEST(Random, Deterministic) {
+    Random a(301);
+    Random b(301);
+    Random c(302);
+    int same_as_c = 0;
+    for (int i = 0; i < 1000; i++) {
+        const uint64_t x = a.Next64();
+        ASSERT_EQ(x, b.Next64());
+        same_as_c += (x == c.Next64());
+    }
+    ASSERT_EQ(0, same_as_c);
+
+    // Seed 0 is as good as any other.
+    Random zero(0);
+    ASSERT_NE(zero.Next64(), zero.Next64());
+}
+
+TEST(Random, Uniform) {
+    Random rnd(301);
+    const int kBuckets = 10;
+    const int kDraws = 1000000;
+    vector<int> counts(kBuckets, 0);
+    for (int i = 0; i < kDraws; i++) {
+        const uint32_t v = rnd.Uniform(kBuckets);
+        ASSERT_LT(v, kBuckets);
+        counts[v]++;
+    }
+    ASSERT_LT(fabs(ChiSquareZ(counts, vector<double>(kBuckets, kDraws / kBuckets))), 5);
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(0, rnd.Uniform(1));
+        ASSERT_LT(rnd.Uniform(INT_MAX), static_cast<uint32_t>(INT_MAX));
+        ASSERT_LT(rnd.Uniform64(uint64_t{3} << 62), uint64_t{3} << 62);
+    }
+
+    // Taking 32 random bits modulo this range would make the low half come
+    // up 52% of the time.
+    const int kLarge = 1500000000;
+    int low = 0;
+    for (int i = 0; i < kDraws; i++) {
+        low += rnd.Uniform(kLarge) < static_cast<uint32_t>(kLarge / 2);
+    }
+    ASSERT_NEAR(0.5, static_cast<double>(low) / kDraws, 0.005);
+}
+
+TEST(Random, OneInAndSkewed) {
+    Random rnd(301);
+    const int kDraws = 1000000;
+    int hits = 0;
+    for (int i = 0; i < kDraws; i++) {
+        hits += rnd.OneIn(8);
+    }
+    ASSERT_NEAR(1.0 / 8, static_cast<double>(hits) / kDraws, 0.005);
+
+    // Each of the max_log + 1 magnitudes is equally likely.
+    vector<int> magnitudes(11, 0);
+    for (int i = 0; i < kDraws; i++) {
+        const uint32_t v = rnd.Skewed(10);
+        ASSERT_LT(v, 1 << 10);
+        magnitudes[v == 0 ? 0 : 32 - __builtin_clz(v)]++;
+    }
+    ASSERT_GT(magnitudes[10], kDraws / 11 / 4);
+    ASSERT_GT(magnitudes[0], magnitudes[10]);
+}
+
+TEST(Random, DoubleAndExponential) {
+    Random rnd(301);
+    const int kDraws = 1000000;
+    double sum = 0;
+    double exponential_sum = 0;
+    int below_mean = 0;
+    for (int i = 0; i < kDraws; i++) {
+        const double d = rnd.NextDouble();
+        ASSERT_GE(d, 0.0);
+        ASSERT_LT(d, 1.0);
+        sum += d;
+        const double e = rnd.Exponential(100.0);
+        ASSERT_GE(e, 0.0);
+        exponential_sum += e;
+        below_mean += e < 100.0;
+    }
+    ASSERT_NEAR(0.5, sum / kDraws, 0.002);
+    ASSERT_NEAR(100.0, exponential_sum / kDraws, 0.5);
+    // P(X < mean) = 1 - 1/e.
+    ASSERT_NEAR(1 - exp(-1.0), static_cast<double>(below_mean) / kDraws, 0.002);
+}
+
+TEST(ZipfianGenerator, MatchesProbabilities) {
+    Random rnd(301);
+    const int kDraws = 1000000;
+    for (double theta : {0.0, 0.5, 0.99, 1.0, 1.5}) {
+        const int kN = 100;
+        ZipfianGenerator zipf(kN, theta);
+        vector<int> counts(kN, 0);
+        for (int i = 0; i < kDraws; i++) {
+            const uint64_t v = zipf.Next(&rnd);
+            ASSERT_LT(v, kN);
+            counts[v]++;
+        }
+
+        double total = 0;
+        for (int k = 1; k <= kN; k++) {
+            total += pow(k, -theta);
+        }
+        vector<double> expected;
+        for (int k = 1; k <= kN; k++) {
+            expected.push_back(kDraws * pow(k, -theta) / total);
+        }
+        ASSERT_LT(fabs(ChiSquareZ(counts, expected)), 5) << theta;
+    }
+}
+
+TEST(ZipfianGenerator, Extremes) {
+    Random rnd(301);
+    ZipfianGenerator one(1, 0.99);
+    ZipfianGenerator huge(uint64_t{1} << 60, 0.99);
+    uint64_t largest = 0;
+    for (int i = 0; i < 100000; i++) {
+        ASSERT_EQ(0, one.Next(&rnd));
+        const uint64_t v = huge.Next(&rnd);
+        ASSERT_LT(v, uint64_t{1} << 60);
+        largest = max(largest, v);
+    }
+    // The tail of a huge key space is still reached.
+    ASSERT_GT(largest, uint64_t{1} << 40);
+}
+
+} // namespace leveldb.
@@ -0,0 +1,335 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+using namespace std;
+
+namespace leveldb {
+
+// Auto-tuning adjusts the rate once every kTuneRefillPeriods refill periods.
+static const int64_t kTuneRefillPeriods = 100;
+
+// Bucket drained in fewer than kLowWatermarkPct percent of the refills:
+// lower the rate. More than kHighWatermarkPct percent: raise it.
+static const int64_t kLowWatermarkPct = 50;
+static const int64_t kHighWatermarkPct = 90;
+
+// Each tuning step changes the rate by this percentage.
+static const int64_t kAdjustFactorPct = 5;
+
+// The tuned rate never drops below max / kAllowedRangeFactor.
+static const int64_t kAllowedRangeFactor = 20;
+
+// Priority of the I/O issued by the current thread.
+static thread_local RateLimiter::Priority current_thread_priority = RateLimiter::kForeground;
+
+RateLimiter::RateLimiter(Env *env, int64_t bytes_per_second, bool auto_tune,
+                         int64_t refill_period_micros, int32_t fairness)
+    : _env(env),
+      _refill_period_micros(refill_period_micros),
+      _fairness(fairness > 0 ? fairness : 1),
+      _auto_tune(auto_tune),
+      _max_bytes_per_second(bytes_per_second),
+      _bytes_per_second(0),
+      _refill_bytes_per_period(0),
+      _available_bytes(0),
+      _next_refill_micros(env->NowMicros()),
+      _leader(nullptr),
+      _rnd(301),
+      _num_refills(0),
+      _idle_periods(0),
+      _num_drains(0) {
+    assert(bytes_per_second > 0);
+    assert(refill_period_micros > 0);
+    memset(&_stats, 0, sizeof(_stats));
+    SetBytesPerSecondLocked(bytes_per_second);
+}
+
+RateLimiter::~RateLimiter() {
+    lock_guard<mutex> lk(_mu);
+    // Destroying the limiter while callers are blocked in Request() is a bug.
+    assert(_queue[kBackground].empty() && _queue[kForeground].empty());
+}
+
+void
+RateLimiter::Request(int64_t bytes, Priority priority)
+{
+    assert(bytes >= 0);
+    assert(priority < kNumPriorities);
+
+    unique_lock<mutex> lk(_mu);
+    _stats.requests[priority]++;
+    _stats.bytes[priority] += bytes;
+
+    // Fast path: enough tokens and nobody queued ahead of us.
+    if (_available_bytes >= bytes &&
+        _queue[kForeground].empty() && _queue[kBackground].empty()) {
+        _available_bytes -= bytes;
+        return;
+    }
+
+    _stats.requests_throttled[priority]++;
+    _stats.bytes_throttled[priority] += bytes;
+    const uint64_t start_micros = _env->NowMicros();
+
+    /*
+     * The first waiter accounts for the whole refill periods that passed
+     * with nobody waiting, and moves the refill grid past them. Lateness
+     * while requests wait is only wakeup overshoot, and is left out.
+     */
+    if (_auto_tune && _queue[kForeground].empty() && _queue[kBackground].empty() &&
+        start_micros >= _next_refill_micros + _refill_period_micros) {
+        const uint64_t idle = (start_micros - _next_refill_micros) / _refill_period_micros;
+        _idle_periods += idle;
+        _next_refill_micros += idle * _refill_period_micros;
+    }
+
+    Req r(bytes);
+    _queue[priority].push_back(&r);
+    while (!r.granted) {
+        if (_leader != nullptr) {
+            // Someone else will refill; wait until we are granted or
+            // handed the leadership.
+            r.cv.wait(lk);
+            continue;
+        }
+
+        // Become the leader: sleep until the next refill is due, then refill.
+        _leader = &r;
+        uint64_t now = _env->NowMicros();
+        if (now < _next_refill_micros) {
+            r.cv.wait_for(lk, chrono::microseconds(_next_refill_micros - now));
+            now = _env->NowMicros();
+        }
+        _leader = nullptr;
+
+        if (now >= _next_refill_micros) {
+            Refill();
+        }
+
+        if (r.granted) {
+            // Pass the leadership on to the oldest remaining waiter.
+            for (int p = kForeground; p >= kBackground; p--) {
+                if (!_queue[p].empty()) {
+                    _queue[p].front()->cv.notify_one();
+                    break;
+                }
+            }
+        }
+    }
+
+    _stats.wait_micros[priority] += _env->NowMicros() - start_micros;
+}
+
+/*
+ * Tops up the bucket and grants queued requests in priority order.
+ * Requests at the head of a queue that need more than what is left
+ * are granted partially so that oversized requests still progress.
+ */
+void
+RateLimiter::Refill()
+{
+    const uint64_t now = _env->NowMicros();
+    if (_auto_tune && _num_refills + _idle_periods >= kTuneRefillPeriods) {
+        Tune();
+    }
+    _num_refills++;
+
+    // Stay on the refill grid when woken up slightly late, so that a
+    // constant backlog drains on every period.
+    _next_refill_micros += _refill_period_micros;
+    if (_next_refill_micros <= now) {
+        _next_refill_micros = now + _refill_period_micros;
+    }
+    _available_bytes = min(_available_bytes + _refill_bytes_per_period, _refill_bytes_per_period);
+
+    const bool background_first = _rnd.OneIn(_fairness);
+    for (int i = 0; i < kNumPriorities; i++) {
+        const Priority p = (background_first == (i == 0)) ? kBackground : kForeground;
+        deque<Req *> *queue = &_queue[p];
+        while (!queue->empty()) {
+            Req *next = queue->front();
+            if (_available_bytes < next->bytes) {
+                next->bytes -= _available_bytes;
+                _available_bytes = 0;
+                break;
+            }
+            _available_bytes -= next->bytes;
+            next->bytes = 0;
+            next->granted = true;
+            queue->pop_front();
+            next->cv.notify_one();
+        }
+    }
+
+    if (!_queue[kForeground].empty() || !_queue[kBackground].empty()) {
+        _num_drains++;
+    }
+}
+
+/*
+ * Moves the rate towards the observed demand: up when most refills left
+ * requests waiting, down when the bucket was rarely exhausted.
+ */
+void
+RateLimiter::Tune()
+{
+    const int64_t elapsed_periods = _num_refills + _idle_periods;
+    if (elapsed_periods == 0) {
+        return;
+    }
+
+    const int64_t drained_pct = _num_drains * 100 / elapsed_periods;
+    int64_t new_bytes_per_second = _bytes_per_second;
+    if (drained_pct < kLowWatermarkPct) {
+        new_bytes_per_second = _bytes_per_second * 100 / (100 + kAdjustFactorPct);
+    } else if (drained_pct > kHighWatermarkPct) {
+        new_bytes_per_second = _bytes_per_second * (100 + kAdjustFactorPct) / 100;
+        if (new_bytes_per_second == _bytes_per_second) {
+            new_bytes_per_second++;
+        }
+    }
+
+    const int64_t min_bytes_per_second = max<int64_t>(_max_bytes_per_second / kAllowedRangeFactor, 1);
+    new_bytes_per_second = max(min_bytes_per_second, min(_max_bytes_per_second, new_bytes_per_second));
+    if (new_bytes_per_second != _bytes_per_second) {
+        SetBytesPerSecondLocked(new_bytes_per_second);
+    }
+
+    _num_refills = 0;
+    _idle_periods = 0;
+    _num_drains = 0;
+}
+
+void
+RateLimiter::SetBytesPerSecond(int64_t bytes_per_second)
+{
+    assert(bytes_per_second > 0);
+    lock_guard<mutex> lk(_mu);
+    _max_bytes_per_second = bytes_per_second;
+    if (!_auto_tune || _bytes_per_second > bytes_per_second) {
+        SetBytesPerSecondLocked(bytes_per_second);
+    }
+}
+
+void
+RateLimiter::SetBytesPerSecondLocked(int64_t bytes_per_second)
+{
+    _bytes_per_second = bytes_per_second;
+    _refill_bytes_per_period = max<int64_t>(bytes_per_second * _refill_period_micros / 1000000, 1);
+}
+
+int64_t
+RateLimiter::GetBytesPerSecond() const
+{
+    lock_guard<mutex> lk(_mu);
+    return _bytes_per_second;
+}
+
+RateLimiter::Stats
+RateLimiter::GetStats() const
+{
+    lock_guard<mutex> lk(_mu);
+    return _stats;
+}
+
+RateLimiter::Priority
+RateLimiter::CurrentThreadPriority()
+{
+    return current_thread_priority;
+}
+
+namespace {
+
+class RateLimitedWritableFile : public WritableFile {
+public:
+    RateLimitedWritableFile(WritableFile *target, RateLimiter *limiter)
+        : _target(target), _limiter(limiter) {}
+
+    ~RateLimitedWritableFile() override {
+        delete _target;
+    }
+
+    Status Append(const Slice& data) override {
+        _limiter->Request(data.size(), RateLimiter::CurrentThreadPriority());
+        return _target->Append(data);
+    }
+
+    Status Close() override {
+        return _target->Close();
+    }
+
+    Status Flush() override {
+        return _target->Flush();
+    }
+
+    Status Sync() override {
+        return _target->Sync();
+    }
+
+private:
+    WritableFile *const _target;
+    RateLimiter *const _limiter;
+};
+
+class RateLimitedEnv : public EnvWrapper {
+public:
+    RateLimitedEnv(Env *base_env, RateLimiter *limiter)
+        : EnvWrapper(base_env), _limiter(limiter) {}
+
+    Status NewWritableFile(const string& fname, WritableFile **result) override {
+        WritableFile *file;
+        Status s = target()->NewWritableFile(fname, &file);
+        *result = s.ok() ? new RateLimitedWritableFile(file, _limiter) : nullptr;
+        return s;
+    }
+
+    Status NewAppendableFile(const string& fname, WritableFile **result) override {
+        WritableFile *file;
+        Status s = target()->NewAppendableFile(fname, &file);
+        *result = s.ok() ? new RateLimitedWritableFile(file, _limiter) : nullptr;
+        return s;
+    }
+
+    void Schedule(function<void(void *)> func, void *arg) override {
+        target()->Schedule(ChargeAsBackground(func), arg);
+    }
+
+    ScheduleHandle ScheduleWithHandle(function<void(void *)> func, void *arg) override {
+        return target()->ScheduleWithHandle(ChargeAsBackground(func), arg);
+    }
+
+    ScheduleHandle ScheduleAfter(function<void(void *)> func, void *arg, uint64_t micros) override {
+        return target()->ScheduleAfter(ChargeAsBackground(func), arg, micros);
+    }
+
+private:
+    // Returns "func" wrapped so that everything it writes is charged as
+    // background I/O.
+    static function<void(void *)> ChargeAsBackground(function<void(void *)> func) {
+        return [func](void *a) {
+            RateLimiter::Priority saved = current_thread_priority;
+            current_thread_priority = RateLimiter::kBackground;
+            func(a);
+            current_thread_priority = saved;
+        };
+    }
+
+    RateLimiter *const _limiter;
+};
+
+} // namespace
+
+Env *
+NewRateLimitedEnv(Env *base_env, RateLimiter *limiter)
+{
+    return new RateLimitedEnv(base_env, limiter);
+}
+
+} // namespace leveldb.
@@ -0,0 +1,151 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/env.h"
+#include "port/thread_annotations.h"
+#include "util/random.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+using namespace std;
+
+namespace leveldb {
+
+/*
+ * A token bucket that throttles file writes to a configured number of
+ * bytes per second.
+ *
+ * Tokens are refilled once every refill period. Requests that cannot be
+ * satisfied from the bucket wait in a FIFO queue per priority; the oldest
+ * waiter acts as the leader and performs the refill when the period ends.
+ * Foreground requests are served first, except that background requests
+ * go first on roughly one refill out of every "fairness" so that they are
+ * never starved.
+ *
+ * When auto-tuning is enabled the rate floats between
+ * bytes_per_second / 20 and bytes_per_second, driven by how many refill
+ * periods left requests waiting. A period counts if a refill was
+ * performed in it or if nobody waited through it; a refill that comes
+ * late because its leader woke up late is still one period.
+ *
+ * Thread-safe.
+ */
+class RateLimiter {
+public:
+    enum Priority {
+        kBackground = 0,
+        kForeground = 1,
+        kNumPriorities = 2
+    };
+
+    // Counters since construction. Indexed by Priority.
+    struct Stats {
+        // Total number of Request() calls and bytes requested.
+        uint64_t requests[kNumPriorities];
+        uint64_t bytes[kNumPriorities];
+
+        // Requests (and their bytes) that had to wait for a refill.
+        uint64_t requests_throttled[kNumPriorities];
+        uint64_t bytes_throttled[kNumPriorities];
+
+        // Total time spent waiting by throttled requests.
+        uint64_t wait_micros[kNumPriorities];
+    };
+
+    /*
+     * "env" supplies the clock and must outlive the limiter.
+     * "bytes_per_second" is the rate limit (or the upper bound of the rate
+     * when "auto_tune" is true).
+     */
+    RateLimiter(Env *env, int64_t bytes_per_second,
+                bool auto_tune = false,
+                int64_t refill_period_micros = 100 * 1000,
+                int32_t fairness = 10);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    ~RateLimiter();
+
+    /*
+     * Blocks until "bytes" tokens have been granted to the caller.
+     * Requests larger than one refill are granted over several periods.
+     */
+    void Request(int64_t bytes, Priority priority);
+
+    // Changes the rate limit (or the upper bound when auto-tuning).
+    // REQUIRES: bytes_per_second > 0
+    void SetBytesPerSecond(int64_t bytes_per_second);
+
+    // Returns the rate currently in effect.
+    int64_t GetBytesPerSecond() const;
+
+    Stats GetStats() const;
+
+    // Returns the priority of I/O issued by the calling thread: kBackground
+    // inside work scheduled through a rate limited Env, kForeground otherwise.
+    static Priority CurrentThreadPriority();
+
+private:
+    // A pending request, owned by the stack frame of the waiting caller.
+    struct Req {
+        explicit Req(int64_t bytes) : bytes(bytes), granted(false) {}
+
+        // Bytes still to be granted.
+        int64_t bytes;
+        bool granted;
+        condition_variable cv;
+    };
+
+    void SetBytesPerSecondLocked(int64_t bytes_per_second);
+    void Refill();
+    void Tune();
+
+    Env *const _env;
+    const int64_t _refill_period_micros;
+    const int32_t _fairness;
+    const bool _auto_tune;
+
+    mutable mutex _mu;
+
+    // Upper bound of the rate. Equal to the rate when not auto-tuning.
+    int64_t _max_bytes_per_second GUARDED_BY(_mu);
+    int64_t _bytes_per_second GUARDED_BY(_mu);
+    int64_t _refill_bytes_per_period GUARDED_BY(_mu);
+
+    int64_t _available_bytes GUARDED_BY(_mu);
+    uint64_t _next_refill_micros GUARDED_BY(_mu);
+
+    // The waiter currently responsible for refilling, if any.
+    Req *_leader GUARDED_BY(_mu);
+    deque<Req *> _queue[kNumPriorities] GUARDED_BY(_mu);
+
+    // Used to pick the priority served first on each refill.
+    Random _rnd GUARDED_BY(_mu);
+
+    // Auto-tuning state since the last tuning step: refills performed,
+    // refill periods that passed with nobody waiting, and refills that
+    // left requests waiting.
+    int64_t _num_refills GUARDED_BY(_mu);
+    int64_t _idle_periods GUARDED_BY(_mu);
+    int64_t _num_drains GUARDED_BY(_mu);
+
+    Stats _stats GUARDED_BY(_mu);
+};
+
+/*
+ * Returns an Env that consults "limiter" before every WritableFile::Append.
+ * Work scheduled through the returned Env's Schedule() is charged at
+ * RateLimiter::kBackground, all other writes at kForeground.
+ *
+ * The caller must delete the result when it is no longer needed.
+ * "base_env" and "limiter" must remain live while the result is in use.
+ */
+Env *NewRateLimitedEnv(Env *base_env, RateLimiter *limiter);
+
+} // namespace leveldb.
@@ -0,0 +1,177 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "rate_limiter.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+static string TempFileName(const char *name) {
+    char buf[100];
+    snprintf(buf, sizeof(buf), "/tmp/leveldb_%s_%d", name, static_cast<int>(getpid()));
+    return buf;
+}
+
+TEST(RateLimiterTest, FastPathDoesNotThrottle) {
+    RateLimiter limiter(Env::Default(), 1000 * 1000);
+    // Let the first refill happen, after which 100KB are available.
+    limiter.Request(1, RateLimiter::kForeground);
+    limiter.Request(1000, RateLimiter::kForeground);
+
+    RateLimiter::Stats stats = limiter.GetStats();
+    ASSERT_EQ(2, stats.requests[RateLimiter::kForeground]);
+    ASSERT_EQ(1001, stats.bytes[RateLimiter::kForeground]);
+    ASSERT_EQ(1, stats.requests_throttled[RateLimiter::kForeground]);
+    ASSERT_EQ(0, stats.requests[RateLimiter::kBackground]);
+}
+
+TEST(RateLimiterTest, Rate) {
+    Env *env = Env::Default();
+    const int64_t kBytesPerSecond = 1000 * 1000;
+    // 10KB per 10ms refill.
+    RateLimiter limiter(env, kBytesPerSecond, false, 10 * 1000);
+
+    const uint64_t start = env->NowMicros();
+    for (int i = 0; i < 20; i++) {
+        limiter.Request(10 * 1000, RateLimiter::kBackground);
+    }
+    const uint64_t elapsed = env->NowMicros() - start;
+
+    // 200KB at 1MB/s takes ~200ms, the first refill is immediate.
+    ASSERT_GE(elapsed, 150 * 1000);
+    ASSERT_LE(elapsed, 1000 * 1000);
+
+    RateLimiter::Stats stats = limiter.GetStats();
+    ASSERT_EQ(200 * 1000, stats.bytes_throttled[RateLimiter::kBackground]);
+    ASSERT_GT(stats.wait_micros[RateLimiter::kBackground], 0);
+}
+
+TEST(RateLimiterTest, OversizedRequest) {
+    Env *env = Env::Default();
+    RateLimiter limiter(env, 1000 * 1000, false, 10 * 1000);
+
+    // Ten times the refill size is granted over several refills.
+    const uint64_t start = env->NowMicros();
+    limiter.Request(100 * 1000, RateLimiter::kForeground);
+    ASSERT_GE(env->NowMicros() - start, 50 * 1000);
+}
+
+TEST(RateLimiterTest, ConcurrentRequests) {
+    Env *env = Env::Default();
+    RateLimiter limiter(env, 2 * 1000 * 1000, false, 10 * 1000);
+    const int kThreads = 4;
+    const int kRequests = 10;
+    vector<thread> threads;
+
+    for (int t = 0; t < kThreads; t++) {
+        RateLimiter::Priority pri = (t % 2 == 0) ? RateLimiter::kBackground
+                                                 : RateLimiter::kForeground;
+        threads.emplace_back([&limiter, pri]() {
+            for (int i = 0; i < kRequests; i++) {
+                limiter.Request(5000, pri);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    RateLimiter::Stats stats = limiter.GetStats();
+    ASSERT_EQ(kThreads / 2 * kRequests, stats.requests[RateLimiter::kBackground]);
+    ASSERT_EQ(kThreads / 2 * kRequests, stats.requests[RateLimiter::kForeground]);
+}
+
+TEST(RateLimiterTest, AutoTune) {
+    Env *env = Env::Default();
+    const int64_t kMaxBytesPerSecond = 10 * 1000 * 1000;
+    // 10KB per 1ms refill, tuned every 100 refills.
+    RateLimiter limiter(env, kMaxBytesPerSecond, true, 1000);
+    ASSERT_EQ(kMaxBytesPerSecond, limiter.GetBytesPerSecond());
+
+    // An idle limiter lowers its rate.
+    env->SleepForMicroseconds(150 * 1000);
+    limiter.Request(20 * 1000, RateLimiter::kBackground);
+    const int64_t lowered = limiter.GetBytesPerSecond();
+    ASSERT_LT(lowered, kMaxBytesPerSecond);
+
+    // A constant backlog raises it again. Give up only after many tuning
+    // steps, since late wakeups on a loaded machine may skip refills.
+    const uint64_t start = env->NowMicros();
+    while (limiter.GetBytesPerSecond() <= lowered && env->NowMicros() - start < 3000 * 1000) {
+        limiter.Request(100 * 1000, RateLimiter::kBackground);
+    }
+    ASSERT_GT(limiter.GetBytesPerSecond(), lowered);
+}
+
+// A clock running at three times real time, so that every timed wait
+// looks like it overshot by two periods.
+class FastClockEnv : public EnvWrapper {
+public:
+    FastClockEnv() : EnvWrapper(Env::Default()), _start(Env::Default()->NowMicros()) {}
+
+    uint64_t NowMicros() override {
+        return _start + 3 * (target()->NowMicros() - _start);
+    }
+
+private:
+    const uint64_t _start;
+};
+
+TEST(RateLimiterTest, AutoTuneIgnoresLateWakeups) {
+    FastClockEnv env;
+    const int64_t kMaxBytesPerSecond = 10 * 1000 * 1000;
+    RateLimiter limiter(&env, kMaxBytesPerSecond, true, 1000);
+
+    // A constant backlog keeps the rate, however late the refills come.
+    const uint64_t start = env.NowMicros();
+    while (env.NowMicros() - start < 1000 * 1000) {
+        limiter.Request(100 * 1000, RateLimiter::kBackground);
+    }
+    ASSERT_EQ(kMaxBytesPerSecond, limiter.GetBytesPerSecond());
+}
+
+TEST(RateLimiterTest, RateLimitedEnvPriorities) {
+    RateLimiter limiter(Env::Default(), 100 * 1000 * 1000);
+    Env *env = NewRateLimitedEnv(Env::Default(), &limiter);
+    const string fname = TempFileName("rate_limiter_test");
+
+    WritableFile *file;
+    ASSERT_TRUE(env->NewWritableFile(fname, &file).ok());
+    ASSERT_TRUE(file->Append("foreground").ok());
+
+    struct State {
+        WritableFile *file;
+        atomic<bool> done;
+    } state;
+    state.file = file;
+    state.done = false;
+
+    env->Schedule([](void *arg) {
+        State *s = reinterpret_cast<State *>(arg);
+        s->file->Append("background");
+        s->done = true;
+    }, &state);
+    while (!state.done) {
+        env->SleepForMicroseconds(1000);
+    }
+
+    ASSERT_TRUE(file->Close().ok());
+    delete file;
+    delete env;
+    unlink(fname.c_str());
+
+    RateLimiter::Stats stats = limiter.GetStats();
+    ASSERT_EQ(10, stats.bytes[RateLimiter::kForeground]);
+    ASSERT_EQ(10, stats.bytes[RateLimiter::kBackground]);
+}
+
+} // namespace leveldb.
@@ -0,0 +1,210 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "readahead_file.h"
+
+#include "port/thread_annotations.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+namespace {
+
+// Size of the first prefetch after sequential access is detected.
+const size_t kInitialReadaheadSize = 16 * 1024;
+
+// Number of back to back sequential reads that start prefetching.
+const int kSequentialReadsToPrefetch = 2;
+
+/*
+ * Everything a prefetch touches. Prefetches hold a reference, so a file
+ * may be closed while one of them is still queued.
+ */
+struct ReadaheadState {
+    ReadaheadState(RandomAccessFile *target, size_t max_readahead_size)
+        : target(target),
+          max_readahead_size(max(max_readahead_size, kInitialReadaheadSize)),
+          next_offset(0),
+          sequential_reads(0),
+          readahead_size(kInitialReadaheadSize),
+          buf_offset(0),
+          buf_at_eof(false),
+          prefetching(false),
+          prefetch_offset(0),
+          prefetch_size(0) {}
+
+    ~ReadaheadState() {
+        delete target;
+    }
+
+    RandomAccessFile *const target;
+    const size_t max_readahead_size;
+
+    mutex mu;
+
+    // Where a read continuing the current run would start.
+    uint64_t next_offset GUARDED_BY(mu);
+    int sequential_reads GUARDED_BY(mu);
+    size_t readahead_size GUARDED_BY(mu);
+
+    // buf holds the file contents at [buf_offset, buf_offset + buf.size()).
+    string buf GUARDED_BY(mu);
+    uint64_t buf_offset GUARDED_BY(mu);
+    bool buf_at_eof GUARDED_BY(mu);
+
+    bool prefetching GUARDED_BY(mu);
+    uint64_t prefetch_offset GUARDED_BY(mu);
+    size_t prefetch_size GUARDED_BY(mu);
+};
+
+/*
+ * Reads never wait for a prefetch: it may be queued behind the very work
+ * item that is reading, or behind unrelated background work. A read the
+ * buffer cannot serve goes to the file, and a prefetch that lands late
+ * only refills the buffer.
+ */
+class ReadaheadRandomAccessFile : public RandomAccessFile {
+public:
+    ReadaheadRandomAccessFile(Env *env, RandomAccessFile *target, size_t max_readahead_size)
+        : _env(env), _state(make_shared<ReadaheadState>(target, max_readahead_size)) {}
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+        ReadaheadState *const st = _state.get();
+        unique_lock<mutex> lk(st->mu);
+
+        const bool sequential = (offset == st->next_offset);
+        size_t copied = 0;
+        if (offset >= st->buf_offset && offset < st->buf_offset + st->buf.size()) {
+            copied = min<size_t>(n, st->buf_offset + st->buf.size() - offset);
+            memcpy(scratch, st->buf.data() + (offset - st->buf_offset), copied);
+        }
+
+        Status s;
+        if (copied == n || (copied > 0 && st->buf_at_eof)) {
+            *result = Slice(scratch, copied);
+        } else {
+            lk.unlock();
+            if (copied == 0) {
+                s = st->target->Read(offset, n, result, scratch);
+            } else {
+                // Only the head of the range was buffered.
+                Slice rest;
+                s = st->target->Read(offset + copied, n - copied, &rest, scratch + copied);
+                if (rest.data() != scratch + copied) {
+                    memmove(scratch + copied, rest.data(), rest.size());
+                }
+                *result = Slice(scratch, copied + rest.size());
+            }
+            lk.lock();
+        }
+
+        bool prefetch = false;
+        if (s.ok()) {
+            if (sequential) {
+                st->sequential_reads++;
+            } else {
+                st->sequential_reads = 0;
+                st->readahead_size = kInitialReadaheadSize;
+            }
+            st->next_offset = offset + result->size();
+            if (st->sequential_reads >= kSequentialReadsToPrefetch) {
+                prefetch = StartPrefetchLocked(st);
+            }
+        }
+        lk.unlock();
+
+        // Outside the lock, in case the Env runs the work item right away.
+        if (prefetch) {
+            shared_ptr<ReadaheadState> state = _state;
+            _env->Schedule([state](void *) { Prefetch(state.get()); }, nullptr);
+        }
+        return s;
+    }
+
+    Status Hint(AccessPattern pattern) override {
+        return _state->target->Hint(pattern);
+    }
+
+private:
+    /*
+     * Claims the next prefetch unless enough data past next_offset is
+     * buffered or one is already on its way. Returns true if the caller
+     * must schedule it.
+     */
+    static bool StartPrefetchLocked(ReadaheadState *st) {
+        if (st->prefetching) {
+            return false;
+        }
+
+        uint64_t start = st->next_offset;
+        if (st->next_offset >= st->buf_offset &&
+            st->next_offset <= st->buf_offset + st->buf.size()) {
+            if (st->buf_at_eof) {
+                return false;
+            }
+            start = st->buf_offset + st->buf.size();
+            if (start - st->next_offset >= st->readahead_size / 2) {
+                return false;
+            }
+        }
+
+        st->prefetching = true;
+        st->prefetch_offset = start;
+        st->prefetch_size = st->readahead_size;
+        st->readahead_size = min(st->readahead_size * 2, st->max_readahead_size);
+        return true;
+    }
+
+    static void Prefetch(ReadaheadState *st) {
+        uint64_t offset;
+        size_t size;
+        {
+            lock_guard<mutex> lk(st->mu);
+            offset = st->prefetch_offset;
+            size = st->prefetch_size;
+        }
+
+        string data(size, '\0');
+        Slice fetched;
+        Status s = st->target->Read(offset, size, &fetched, &data[0]);
+
+        lock_guard<mutex> lk(st->mu);
+        // Errors are dropped; the reader will run into them itself.
+        if (s.ok() && offset + fetched.size() >= st->next_offset) {
+            if (st->next_offset >= st->buf_offset &&
+                st->buf_offset + st->buf.size() == offset) {
+                // Keep the buffered bytes that have not been read yet.
+                const uint64_t consumed =
+                    min<uint64_t>(st->next_offset - st->buf_offset, st->buf.size());
+                st->buf.erase(0, consumed);
+                st->buf_offset += consumed;
+                st->buf.append(fetched.data(), fetched.size());
+            } else {
+                st->buf.assign(fetched.data(), fetched.size());
+                st->buf_offset = offset;
+            }
+            st->buf_at_eof = fetched.size() < size;
+        }
+        st->prefetching = false;
+    }
+
+    Env *const _env;
+    const shared_ptr<ReadaheadState> _state;
+};
+
+} // namespace
+
+RandomAccessFile *
+NewReadaheadRandomAccessFile(Env *env, RandomAccessFile *file, size_t max_readahead_size)
+{
+    return new ReadaheadRandomAccessFile(env, file, max_readahead_size);
+}
+
+} // namespace leveldb.
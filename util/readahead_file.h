@@ -0,0 +1,31 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/env.h"
+
+#include <cstddef>
+
+namespace leveldb {
+
+/*
+ * Returns a RandomAccessFile that reads through "file" and, once it has
+ * seen a run of reads each starting where the previous one ended,
+ * prefetches the data that follows on a background thread of "env".
+ *
+ * The prefetch window starts small and doubles on every prefetch up to
+ * "max_readahead_size" bytes; any non-sequential read shrinks it again.
+ * Reads that hit prefetched data are copied out of the window; the others
+ * go to "file" without waiting for a prefetch in flight, so the result can
+ * be read from within a work item of "env".
+ *
+ * The result takes ownership of "file", which is deleted once the result
+ * and any prefetch still queued are gone. "env" must remain live until
+ * then.
+ */
+RandomAccessFile *NewReadaheadRandomAccessFile(Env *env, RandomAccessFile *file,
+                                               size_t max_readahead_size = 1 << 20);
+
+} // namespace leveldb.
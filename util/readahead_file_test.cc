@@ -0,0 +1,169 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "readahead_file.h"
+
+#include "helpers/memenv/memenv.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+// Counts the reads that reach the underlying file.
+class CountingFile : public RandomAccessFile {
+public:
+    CountingFile(RandomAccessFile *target, atomic<int> *reads, atomic<uint64_t> *bytes)
+        : _target(target), _reads(reads), _bytes(bytes) {}
+
+    ~CountingFile() override {
+        delete _target;
+    }
+
+    Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+        _reads->fetch_add(1);
+        _bytes->fetch_add(n);
+        return _target->Read(offset, n, result, scratch);
+    }
+
+private:
+    RandomAccessFile *const _target;
+    atomic<int> *const _reads;
+    atomic<uint64_t> *const _bytes;
+};
+
+// Runs scheduled work right away, so that prefetches land in order.
+class InlineScheduleEnv : public EnvWrapper {
+public:
+    InlineScheduleEnv() : EnvWrapper(Env::Default()) {}
+
+    void Schedule(function<void(void *)> func, void *arg) override {
+        func(arg);
+    }
+};
+
+class ReadaheadFileTest : public testing::Test {
+public:
+    ReadaheadFileTest() : _env(NewMemEnv(Env::Default())), _reads(0), _bytes(0) {
+        _contents.resize(kFileSize);
+        for (size_t i = 0; i < kFileSize; i++) {
+            _contents[i] = static_cast<char>(i % 251);
+        }
+        WritableFile *writable_file;
+        EXPECT_TRUE(_env->NewWritableFile("/f", &writable_file).ok());
+        EXPECT_TRUE(writable_file->Append(_contents).ok());
+        delete writable_file;
+    }
+
+    ~ReadaheadFileTest() {
+        delete _env;
+    }
+
+    RandomAccessFile *Open(size_t max_readahead_size, Env *schedule_env = Env::Default()) {
+        RandomAccessFile *file;
+        EXPECT_TRUE(_env->NewRandomAccessFile("/f", &file).ok());
+        return NewReadaheadRandomAccessFile(schedule_env, new CountingFile(file, &_reads, &_bytes),
+                                            max_readahead_size);
+    }
+
+    // Reads [offset, offset + n) and checks it against the file contents.
+    void CheckRead(RandomAccessFile *file, uint64_t offset, size_t n) {
+        string scratch(n, '\0');
+        Slice result;
+        ASSERT_TRUE(file->Read(offset, n, &result, &scratch[0]).ok());
+        const size_t expected = offset >= kFileSize ? 0 : min<size_t>(n, kFileSize - offset);
+        ASSERT_EQ(expected, result.size());
+        ASSERT_EQ(0, memcmp(result.data(), _contents.data() + offset, expected));
+    }
+
+    static const size_t kFileSize = 1 << 20;
+
+    Env *_env;
+    string _contents;
+    atomic<int> _reads;
+    atomic<uint64_t> _bytes;
+};
+
+TEST_F(ReadaheadFileTest, SequentialScan) {
+    InlineScheduleEnv schedule_env;
+    RandomAccessFile *file = Open(256 * 1024, &schedule_env);
+    const size_t kReadSize = 4096;
+    for (uint64_t offset = 0; offset < kFileSize; offset += kReadSize) {
+        CheckRead(file, offset, kReadSize);
+    }
+    CheckRead(file, kFileSize, kReadSize);
+    delete file;
+
+    // Most reads are served from prefetched windows.
+    ASSERT_LT(_reads.load(), static_cast<int>(kFileSize / kReadSize / 4));
+}
+
+TEST_F(ReadaheadFileTest, RandomReadsDoNotPrefetch) {
+    RandomAccessFile *file = Open(256 * 1024);
+    const size_t kReadSize = 1000;
+    int num_reads = 0;
+    // Backwards, so that no read continues the previous one.
+    for (uint64_t offset = kFileSize - kReadSize; offset >= 3 * kReadSize; offset -= 3 * kReadSize) {
+        CheckRead(file, offset, kReadSize);
+        num_reads++;
+    }
+    delete file;
+
+    ASSERT_EQ(num_reads, _reads.load());
+    ASSERT_EQ(num_reads * kReadSize, _bytes.load());
+}
+
+TEST_F(ReadaheadFileTest, MixedAccess) {
+    RandomAccessFile *file = Open(64 * 1024);
+    srand(301);
+    uint64_t offset = 0;
+    for (int i = 0; i < 2000; i++) {
+        const size_t n = 1 + rand() % 10000;
+        if (rand() % 20 == 0) {
+            offset = rand() % (kFileSize + 100);
+        }
+        CheckRead(file, offset, n);
+        offset += n;
+        if (offset > kFileSize) {
+            offset = 0;
+        }
+    }
+    delete file;
+}
+
+TEST_F(ReadaheadFileTest, ScanFromScheduledWork) {
+    // Prefetches queue up behind the scan on the same background thread.
+    RandomAccessFile *file = Open(256 * 1024);
+    mutex mu;
+    condition_variable cv;
+    bool done = false;
+    Env::Default()->Schedule(
+        [&](void *) {
+            const size_t kReadSize = 4096;
+            for (uint64_t offset = 0; offset < kFileSize; offset += kReadSize) {
+                CheckRead(file, offset, kReadSize);
+            }
+            delete file;
+            lock_guard<mutex> lk(mu);
+            done = true;
+            cv.notify_all();
+        },
+        nullptr);
+
+    {
+        unique_lock<mutex> lk(mu);
+        ASSERT_TRUE(cv.wait_for(lk, chrono::seconds(60), [&] { return done; }));
+    }
+
+    // Let the prefetches still queued finish before the counters go away.
+    Env::Default()->ScheduleWithHandle([](void *) {}, nullptr).Wait();
+}
+
+} // namespace leveldb.
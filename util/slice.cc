@@ -0,0 +1,207 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/slice.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_SLICE_X86 1
+#include <immintrin.h>
+#endif
+using namespace std;
+
+namespace leveldb {
+
+namespace {
+
+inline uint64_t LoadUnaligned64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ * Offset of the first differing byte of two words that differ, as loaded
+ * by LoadUnaligned64(). The byte first in memory is the least significant
+ * one on little-endian hosts and the most significant one on big-endian.
+ */
+inline size_t FirstDifferentByte(uint64_t x, uint64_t y) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return static_cast<size_t>(__builtin_clzll(x ^ y)) / 8;
+#else
+    return static_cast<size_t>(__builtin_ctzll(x ^ y)) / 8;
+#endif
+}
+
+/*
+ * Inputs shorter than a vector. Words that would run past "n" are loaded
+ * at n - 8 instead, overlapping bytes already known to be equal.
+ */
+inline size_t MismatchShort(const char *a, const char *b, size_t n) {
+    if (n >= 8) {
+        uint64_t x = LoadUnaligned64(a);
+        uint64_t y = LoadUnaligned64(b);
+        if (x != y) {
+            return FirstDifferentByte(x, y);
+        }
+        x = LoadUnaligned64(a + n - 8);
+        y = LoadUnaligned64(b + n - 8);
+        if (x != y) {
+            return n - 8 + FirstDifferentByte(x, y);
+        }
+        return n;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return n;
+}
+
+size_t MismatchPortable(const char *a, const char *b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const uint64_t x = LoadUnaligned64(a + i);
+        const uint64_t y = LoadUnaligned64(b + i);
+        if (x != y) {
+            return i + FirstDifferentByte(x, y);
+        }
+    }
+    return i + MismatchShort(a + i, b + i, n - i);
+}
+
+#if defined(LEVELDB_SLICE_X86)
+
+// Bit i is set iff a[i] == b[i], for the 16 bytes at a and b.
+inline unsigned EqualMask16(const char *a, const char *b) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+}
+
+/*
+ * 16 <= n <= 32: the first 16 bytes, then the last 16, which overlap the
+ * first ones unless n is 32.
+ */
+inline size_t MismatchUpTo32(const char *a, const char *b, size_t n) {
+    unsigned equal = EqualMask16(a, b);
+    if (equal != 0xffff) {
+        return __builtin_ctz(~equal);
+    }
+    equal = EqualMask16(a + n - 16, b + n - 16);
+    if (equal != 0xffff) {
+        return n - 16 + __builtin_ctz(~equal);
+    }
+    return n;
+}
+
+// SSE2 is part of x86-64, so this needs no check.
+size_t MismatchSse2(const char *a, const char *b, size_t n) {
+    if (n < 16) {
+        return MismatchShort(a, b, n);
+    }
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const unsigned lo = EqualMask16(a + i, b + i);
+        const unsigned hi = EqualMask16(a + i + 16, b + i + 16);
+        const uint32_t equal = lo | (hi << 16);
+        if (equal != 0xffffffffu) {
+            return i + __builtin_ctz(~equal);
+        }
+    }
+    if (i == n) {
+        return n;
+    }
+    // Finish with the last 32 bytes (or all of them), overlapping the loop.
+    i = (n >= 32) ? n - 32 : 0;
+    return i + MismatchUpTo32(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline uint32_t EqualMask32(const char *a, const char *b) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+    const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+}
+
+__attribute__((target("avx2")))
+size_t MismatchAvx2(const char *a, const char *b, size_t n) {
+    if (n <= 32) {
+        return n < 16 ? MismatchShort(a, b, n) : MismatchUpTo32(a, b, n);
+    }
+    // Two vectors per step, with one test for both; the step that found
+    // a difference is redone to locate it.
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const __m256i lo = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        const __m256i hi = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i + 32)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i + 32)));
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(lo, hi))) != 0xffffffffu) {
+            const uint32_t equal = EqualMask32(a + i, b + i);
+            if (equal != 0xffffffffu) {
+                return i + __builtin_ctz(~equal);
+            }
+            return i + 32 + __builtin_ctz(~EqualMask32(a + i + 32, b + i + 32));
+        }
+    }
+    // At most 63 bytes are left: one more vector if needed, then the last
+    // one, which may overlap bytes already found equal.
+    if (i == n) {
+        return n;
+    }
+    if (n - i > 32) {
+        const uint32_t equal = EqualMask32(a + i, b + i);
+        if (equal != 0xffffffffu) {
+            return i + __builtin_ctz(~equal);
+        }
+    }
+    const uint32_t equal = EqualMask32(a + n - 32, b + n - 32);
+    if (equal != 0xffffffffu) {
+        return n - 32 + __builtin_ctz(~equal);
+    }
+    return n;
+}
+
+#endif
+
+using MismatchFunction = size_t (*)(const char *, const char *, size_t);
+
+MismatchFunction ChooseMismatch() {
+#if defined(LEVELDB_SLICE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &MismatchAvx2;
+    }
+    return &MismatchSse2;
+#else
+    return &MismatchPortable;
+#endif
+}
+
+inline size_t Mismatch(const char *a, const char *b, size_t n) {
+    static const MismatchFunction mismatch = ChooseMismatch();
+    return mismatch(a, b, n);
+}
+
+} // namespace
+
+size_t
+Slice::difference_offset(const Slice& b) const
+{
+    return Mismatch(_data, b._data, min(_size, b._size));
+}
+
+size_t
+DifferenceOffsetPortable(const Slice& a, const Slice& b)
+{
+    return MismatchPortable(a.data(), b.data(), min(a.size(), b.size()));
+}
+
+} // namespace leveldb.
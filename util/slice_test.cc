@@ -0,0 +1,75 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/slice.h"
+
+#include "random.h"
+
+#include <string>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+TEST(Slice, Compare) {
+    ASSERT_EQ(0, Slice("abc").compare(Slice("abc")));
+    ASSERT_LT(Slice("abc").compare(Slice("abd")), 0);
+    ASSERT_GT(Slice("abd").compare(Slice("abc")), 0);
+    ASSERT_LT(Slice("ab").compare(Slice("abc")), 0);
+    ASSERT_GT(Slice("abc").compare(Slice("ab")), 0);
+    ASSERT_LT(Slice("").compare(Slice("a")), 0);
+
+    // Bytes compare as unsigned.
+    ASSERT_LT(Slice("\x7f").compare(Slice("\x80")), 0);
+
+    ASSERT_TRUE(Slice("abc").starts_with(Slice("ab")));
+    ASSERT_TRUE(Slice("abc").starts_with(Slice("")));
+    ASSERT_FALSE(Slice("abc").starts_with(Slice("abcd")));
+    ASSERT_FALSE(Slice("abc").starts_with(Slice("b")));
+}
+
+TEST(Slice, DifferenceOffset) {
+    ASSERT_EQ(0, Slice("").difference_offset(Slice("")));
+    ASSERT_EQ(0, Slice("abc").difference_offset(Slice("")));
+    ASSERT_EQ(0, Slice("abc").difference_offset(Slice("xbc")));
+    ASSERT_EQ(2, Slice("abc").difference_offset(Slice("ab")));
+    ASSERT_EQ(2, Slice("abc").difference_offset(Slice("abd")));
+    ASSERT_EQ(3, Slice("abc").difference_offset(Slice("abc")));
+}
+
+// Every length up to a few vectors, with the first difference at every
+// position and at unaligned addresses, against the portable version and
+// a byte loop.
+TEST(Slice, DifferenceOffsetMatchesBytewise) {
+    Random rnd(301);
+    string a(300 + 32, '\0');
+    for (char& c : a) {
+        c = static_cast<char>(rnd.Uniform(256));
+    }
+    for (size_t len = 0; len <= 300; len++) {
+        const size_t a_offset = rnd.Uniform(32);
+        const size_t b_offset = rnd.Uniform(32);
+        for (size_t diff = 0; diff <= len; diff++) {
+            string b(b_offset, '\0');
+            b.append(a, a_offset, len);
+            if (diff < len) {
+                b[b_offset + diff] ^= static_cast<char>(1 + rnd.Uniform(255));
+            }
+            const Slice x(a.data() + a_offset, len);
+            const Slice y(b.data() + b_offset, len + rnd.Uniform(2));
+            ASSERT_EQ(diff, x.difference_offset(y)) << len;
+            ASSERT_EQ(diff, y.difference_offset(x)) << len;
+            ASSERT_EQ(diff, DifferenceOffsetPortable(x, y)) << len;
+
+            // Agrees with compare().
+            if (diff < len) {
+                const int expected = static_cast<unsigned char>(x[diff]) <
+                                     static_cast<unsigned char>(y[diff]) ? -1 : 1;
+                ASSERT_EQ(expected, x.compare(y) < 0 ? -1 : 1);
+            }
+        }
+    }
+}
+
+} // namespace leveldb.
@@ -0,0 +1,181 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "workload.h"
+
+#include "coding.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+using namespace std;
+
+namespace leveldb {
+
+namespace {
+
+const size_t kMinKeySize = 8;
+
+// Bytes of value data; values wrap around it.
+const size_t kValueDataSize = 1 << 20;
+
+/*
+ * Fills "dst" with "len" bytes that compress to about "ratio" of their
+ * size: runs of random printable bytes, each repeated to fill 100 bytes.
+ */
+void CompressibleBytes(Random *rnd, double ratio, size_t len, string *dst) {
+    const size_t kRun = 100;
+    const size_t raw = max<size_t>(1, static_cast<size_t>(kRun * ratio));
+    string chunk;
+    dst->clear();
+    while (dst->size() < len) {
+        chunk.clear();
+        for (size_t i = 0; i < raw; i++) {
+            chunk.push_back(static_cast<char>(' ' + rnd->Uniform(95)));
+        }
+        while (chunk.size() < kRun) {
+            chunk.append(chunk, 0, min(raw, kRun - chunk.size()));
+        }
+        dst->append(chunk);
+    }
+    dst->resize(len);
+}
+
+} // namespace
+
+size_t
+SizeDistribution::Draw(Random *rnd) const
+{
+    switch (kind) {
+    case Kind::kFixed:
+        return mean;
+    case Kind::kUniform:
+        return min + rnd->Uniform64(max - min + 1);
+    case Kind::kExponential: {
+        const double size = rnd->Exponential(static_cast<double>(mean));
+        return std::max(min, std::min(max, static_cast<size_t>(size)));
+    }
+    }
+    assert(false);
+    return mean;
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadOptions& options)
+    : _options(options),
+      _rnd(options.seed),
+      _zipf(options.num_keys, options.zipf_theta),
+      _num_keys(options.num_keys),
+      _value_pos(0)
+{
+    assert(options.read_weight + options.write_weight + options.scan_weight > 0);
+
+    const uint64_t num_prefixes = max<uint64_t>(1, min(options.num_prefixes, options.num_keys));
+    _keys_per_prefix = (options.num_keys + num_prefixes - 1) / num_prefixes;
+    _num_hot_prefixes = max<uint64_t>(1, static_cast<uint64_t>(
+                                             ceil(num_prefixes * options.hot_prefix_fraction)));
+    _num_hot_prefixes = min(_num_hot_prefixes, num_prefixes);
+
+    size_t value_data_size = kValueDataSize;
+    if (options.value_size.max > value_data_size) {
+        value_data_size = options.value_size.max;
+    }
+    CompressibleBytes(&_rnd, options.value_compression_ratio, value_data_size, &_value_data);
+}
+
+uint64_t
+WorkloadGenerator::NextKeyNumber()
+{
+    switch (_options.key_distribution) {
+    case KeyDistribution::kUniform:
+        return _rnd.Uniform64(_num_keys);
+    case KeyDistribution::kZipfian: {
+        const uint64_t rank = _zipf.Next(&_rnd);
+        if (!_options.scramble_zipfian) {
+            return rank;
+        }
+        char buf[8];
+        EncodeFixed64(buf, rank);
+        return Hash64(buf, sizeof(buf)) % _num_keys;
+    }
+    case KeyDistribution::kLatest:
+        return _num_keys - 1 - _zipf.Next(&_rnd) % _num_keys;
+    case KeyDistribution::kHotPrefix: {
+        const uint64_t num_prefixes = (_num_keys + _keys_per_prefix - 1) / _keys_per_prefix;
+        uint64_t prefix;
+        if (_num_hot_prefixes == num_prefixes || _rnd.NextDouble() < _options.hot_access_fraction) {
+            prefix = _rnd.Uniform64(_num_hot_prefixes);
+        } else {
+            prefix = _num_hot_prefixes + _rnd.Uniform64(num_prefixes - _num_hot_prefixes);
+        }
+        const uint64_t first = prefix * _keys_per_prefix;
+        return first + _rnd.Uniform64(min(_keys_per_prefix, _num_keys - first));
+    }
+    }
+    assert(false);
+    return 0;
+}
+
+Slice
+WorkloadGenerator::Key(uint64_t key_number)
+{
+    size_t size = kMinKeySize;
+    if (_options.key_size.kind == SizeDistribution::Kind::kFixed) {
+        size = _options.key_size.mean;
+    } else {
+        // Draw the size from the key number alone, so it never changes.
+        Random rnd(static_cast<uint32_t>(key_number ^ (key_number >> 32)) ^ _options.seed);
+        size = _options.key_size.Draw(&rnd);
+    }
+    size = max(size, kMinKeySize);
+
+    _key.assign(size, '0');
+    for (int i = 0; i < 8; i++) {
+        _key[i] = static_cast<char>(key_number >> (56 - 8 * i));
+    }
+    return Slice(_key);
+}
+
+Slice
+WorkloadGenerator::Value()
+{
+    const size_t size = _options.value_size.Draw(&_rnd);
+    if (_value_pos + size > _value_data.size()) {
+        _value_pos = 0;
+    }
+    const Slice value(_value_data.data() + _value_pos, size);
+    _value_pos += size;
+    return value;
+}
+
+Operation
+WorkloadGenerator::Next()
+{
+    const WorkloadOptions& o = _options;
+    const double pick = _rnd.NextDouble() * (o.read_weight + o.write_weight + o.scan_weight);
+
+    Operation op;
+    op.scan_length = 0;
+    if (pick < o.read_weight) {
+        op.type = OperationType::kRead;
+    } else if (pick < o.read_weight + o.write_weight) {
+        op.type = OperationType::kWrite;
+    } else {
+        op.type = OperationType::kScan;
+        op.scan_length = o.scan_length.Draw(&_rnd);
+    }
+
+    if (op.type == OperationType::kWrite && o.key_distribution == KeyDistribution::kLatest) {
+        op.key_number = _num_keys++;
+    } else {
+        op.key_number = NextKeyNumber();
+    }
+    op.key = Key(op.key_number);
+    if (op.type == OperationType::kWrite) {
+        op.value = Value();
+    }
+    return op;
+}
+
+} // namespace leveldb.
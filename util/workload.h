@@ -0,0 +1,161 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include "leveldb/slice.h"
+#include "random.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+namespace leveldb {
+
+// How the sizes of keys, values or scans are drawn.
+struct SizeDistribution {
+    enum class Kind {
+        kFixed,         // Always "mean".
+        kUniform,       // Uniform over [min, max].
+        kExponential,   // Exponential with the given mean, clipped to [min, max].
+    };
+
+    Kind kind = Kind::kFixed;
+    size_t mean = 100;
+    size_t min = 100;
+    size_t max = 100;
+
+    static SizeDistribution Fixed(size_t size) {
+        return SizeDistribution{Kind::kFixed, size, size, size};
+    }
+
+    static SizeDistribution Uniform(size_t min, size_t max) {
+        return SizeDistribution{Kind::kUniform, (min + max) / 2, min, max};
+    }
+
+    static SizeDistribution Exponential(size_t mean, size_t min, size_t max) {
+        return SizeDistribution{Kind::kExponential, mean, min, max};
+    }
+
+    size_t Draw(Random *rnd) const;
+};
+
+// Which keys operations go to.
+enum class KeyDistribution {
+    kUniform,       // Every key equally often.
+    kZipfian,       // A few keys take most operations; see zipf_theta.
+    kLatest,        // Writes insert new keys and reads favour the newest ones.
+    kHotPrefix,     // Most operations go to the keys of a few hot prefixes.
+};
+
+enum class OperationType {
+    kRead,
+    kWrite,
+    kScan,
+};
+
+struct WorkloadOptions {
+    // Keys in the initial key space, numbered 0 to num_keys - 1.
+    uint64_t num_keys = 1000000;
+
+    KeyDistribution key_distribution = KeyDistribution::kUniform;
+
+    // Skew of kZipfian and kLatest; see ZipfianGenerator.
+    double zipf_theta = 0.99;
+
+    // Spread the popular kZipfian keys over the key space instead of
+    // crowding them at its start, as hashed production keys are.
+    bool scramble_zipfian = true;
+
+    // kHotPrefix: the key space is split into num_prefixes runs of
+    // adjacent keys, and hot_access_fraction of the operations go to the
+    // first hot_prefix_fraction of them. Within a prefix keys are uniform.
+    uint64_t num_prefixes = 1000;
+    double hot_prefix_fraction = 0.01;
+    double hot_access_fraction = 0.9;
+
+    // Key sizes are at least 8 bytes, the big-endian key number, so that
+    // keys sort in key number order. A key has the same size every time.
+    SizeDistribution key_size = SizeDistribution::Fixed(16);
+    SizeDistribution value_size = SizeDistribution::Fixed(100);
+
+    // How far value bytes compress, as compressed size over raw size.
+    double value_compression_ratio = 0.5;
+
+    // Relative weights of the operation types.
+    double read_weight = 1;
+    double write_weight = 1;
+    double scan_weight = 0;
+
+    // Keys visited by a scan.
+    SizeDistribution scan_length = SizeDistribution::Uniform(1, 100);
+
+    uint32_t seed = 301;
+};
+
+struct Operation {
+    OperationType type;
+    uint64_t key_number;
+    Slice key;
+    Slice value;        // kWrite only.
+    size_t scan_length; // kScan only.
+};
+
+/*
+ * Draws the operations of a key/value benchmark from WorkloadOptions,
+ * so that every benchmark can replay the same traffic:
+ *
+ *     WorkloadGenerator load(options);
+ *     for (uint64_t i = 0; i < options.num_keys; i++) {
+ *         db->Put(load.Key(i), load.Value());
+ *     }
+ *     WorkloadGenerator workload(options);
+ *     for (int i = 0; i < ops; i++) {
+ *         Operation op = workload.Next();
+ *         ...
+ *     }
+ *
+ * The same options give the same sequence. Slices returned stay valid
+ * until the next call on the generator. Not thread-safe: give each thread
+ * its own generator, with its own seed.
+ */
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadOptions& options);
+
+    WorkloadGenerator(const WorkloadGenerator&) = delete;
+    WorkloadGenerator& operator=(const WorkloadGenerator&) = delete;
+
+    Operation Next();
+
+    // Draws the number of the key the next operation goes to.
+    uint64_t NextKeyNumber();
+
+    // The key with the given number.
+    Slice Key(uint64_t key_number);
+
+    // A value of a size drawn from value_size.
+    Slice Value();
+
+    // Keys in the key space, including those inserted by kLatest writes.
+    uint64_t num_keys() const {
+        return _num_keys;
+    }
+
+private:
+    const WorkloadOptions _options;
+    Random _rnd;
+    const ZipfianGenerator _zipf;
+    uint64_t _num_keys;
+    uint64_t _keys_per_prefix;
+    uint64_t _num_hot_prefixes;
+
+    // Compressible bytes that values are cut from.
+    string _value_data;
+    size_t _value_pos;
+    string _key;
+};
+
+} // namespace leveldb.
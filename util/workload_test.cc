@@ -0,0 +1,169 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "workload.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+using namespace std;
+
+namespace leveldb {
+
+// Counts how often each key number comes up in "n" draws.
+static vector<int> KeyCounts(const WorkloadOptions& options, int n) {
+    WorkloadGenerator gen(options);
+    vector<int> counts(options.num_keys, 0);
+    for (int i = 0; i < n; i++) {
+        const uint64_t k = gen.NextKeyNumber();
+        EXPECT_LT(k, options.num_keys);
+        counts[k]++;
+    }
+    return counts;
+}
+
+// The fraction of the draws that went to the "top" most drawn keys.
+static double TopShare(vector<int> counts, size_t top) {
+    sort(counts.begin(), counts.end(), greater<int>());
+    double total = 0;
+    double top_total = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        total += counts[i];
+        top_total += i < top ? counts[i] : 0;
+    }
+    return top_total / total;
+}
+
+TEST(Workload, Deterministic) {
+    WorkloadOptions options;
+    options.key_distribution = KeyDistribution::kZipfian;
+    options.scan_weight = 1;
+    WorkloadGenerator a(options);
+    WorkloadGenerator b(options);
+    for (int i = 0; i < 10000; i++) {
+        const Operation x = a.Next();
+        const Operation y = b.Next();
+        ASSERT_EQ(static_cast<int>(x.type), static_cast<int>(y.type));
+        ASSERT_EQ(x.key_number, y.key_number);
+        ASSERT_EQ(x.key.ToString(), y.key.ToString());
+        ASSERT_EQ(x.value.ToString(), y.value.ToString());
+        ASSERT_EQ(x.scan_length, y.scan_length);
+    }
+}
+
+TEST(Workload, Keys) {
+    WorkloadOptions options;
+    options.key_size = SizeDistribution::Uniform(4, 40);
+    WorkloadGenerator gen(options);
+
+    string prev;
+    for (uint64_t k = 0; k < 1000; k++) {
+        const string key = gen.Key(k).ToString();
+        ASSERT_GE(key.size(), 8);
+        ASSERT_LE(key.size(), 40);
+        // Sizes never change, and keys sort by number.
+        ASSERT_EQ(key, gen.Key(k).ToString());
+        ASSERT_LT(prev, key);
+        prev = key;
+    }
+
+    options.key_size = SizeDistribution::Fixed(24);
+    WorkloadGenerator fixed(options);
+    ASSERT_EQ(24, fixed.Key(12345).size());
+}
+
+TEST(Workload, KeyDistributions) {
+    WorkloadOptions options;
+    options.num_keys = 10000;
+    const int kDraws = 1000000;
+
+    // 1% of the keys get about 1% of uniform traffic, and most of
+    // Zipfian traffic.
+    options.key_distribution = KeyDistribution::kUniform;
+    ASSERT_LT(TopShare(KeyCounts(options, kDraws), 100), 0.02);
+
+    options.key_distribution = KeyDistribution::kZipfian;
+    const vector<int> zipf = KeyCounts(options, kDraws);
+    ASSERT_GT(TopShare(zipf, 100), 0.5);
+
+    // Scrambling moves the hottest key away from the start of the key space
+    // without changing the skew.
+    options.scramble_zipfian = false;
+    const vector<int> unscrambled = KeyCounts(options, kDraws);
+    ASSERT_EQ(unscrambled[0], *max_element(unscrambled.begin(), unscrambled.end()));
+    ASSERT_NE(zipf[0], *max_element(zipf.begin(), zipf.end()));
+    ASSERT_NEAR(TopShare(zipf, 100), TopShare(unscrambled, 100), 0.02);
+
+    // 90% of the traffic goes to the first 1% of the prefixes.
+    options.key_distribution = KeyDistribution::kHotPrefix;
+    options.num_prefixes = 1000;
+    const vector<int> prefix = KeyCounts(options, kDraws);
+    int hot = 0;
+    for (int k = 0; k < 100; k++) {
+        hot += prefix[k];
+    }
+    ASSERT_NEAR(0.9, static_cast<double>(hot) / kDraws, 0.01);
+}
+
+TEST(Workload, Latest) {
+    WorkloadOptions options;
+    options.num_keys = 10000;
+    options.key_distribution = KeyDistribution::kLatest;
+    WorkloadGenerator gen(options);
+
+    int recent_reads = 0;
+    int reads = 0;
+    for (int i = 0; i < 100000; i++) {
+        const uint64_t num_keys = gen.num_keys();
+        const Operation op = gen.Next();
+        if (op.type == OperationType::kWrite) {
+            // Writes insert the next key.
+            ASSERT_EQ(num_keys, op.key_number);
+            ASSERT_EQ(num_keys + 1, gen.num_keys());
+        } else {
+            ASSERT_LT(op.key_number, num_keys);
+            reads++;
+            recent_reads += op.key_number >= num_keys - 100;
+        }
+    }
+    ASSERT_GT(recent_reads, reads / 2);
+}
+
+TEST(Workload, OperationMix) {
+    WorkloadOptions options;
+    options.read_weight = 6;
+    options.write_weight = 3;
+    options.scan_weight = 1;
+    options.value_size = SizeDistribution::Exponential(200, 10, 1000);
+    options.scan_length = SizeDistribution::Uniform(5, 50);
+    WorkloadGenerator gen(options);
+
+    const int kOps = 100000;
+    int counts[3] = {0, 0, 0};
+    double value_bytes = 0;
+    for (int i = 0; i < kOps; i++) {
+        const Operation op = gen.Next();
+        counts[static_cast<int>(op.type)]++;
+        if (op.type == OperationType::kWrite) {
+            ASSERT_GE(op.value.size(), 10);
+            ASSERT_LE(op.value.size(), 1000);
+            value_bytes += op.value.size();
+        } else {
+            ASSERT_TRUE(op.value.empty());
+        }
+        if (op.type == OperationType::kScan) {
+            ASSERT_GE(op.scan_length, 5);
+            ASSERT_LE(op.scan_length, 50);
+        }
+    }
+    ASSERT_NEAR(0.6, static_cast<double>(counts[0]) / kOps, 0.01);
+    ASSERT_NEAR(0.3, static_cast<double>(counts[1]) / kOps, 0.01);
+    ASSERT_NEAR(0.1, static_cast<double>(counts[2]) / kOps, 0.01);
+    // Clipping at both ends roughly cancels out.
+    ASSERT_NEAR(200, value_bytes / counts[1], 20);
+}
+
+} // namespace leveldb.